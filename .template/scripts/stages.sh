@@ -190,7 +190,14 @@ compute_stages() {
         [[ -n "$r" ]] && resolved+=("$r")
       done < <(resolve_arg "$dep_task_path" "$REPOSITORY_ROOT")
 
+      local dep_is_wildcard=false
+      [[ "$dep_task_path" == *"*"* || "$dep_task_path" == *"?"* || "$dep_task_path" == *"!("* ]] && dep_is_wildcard=true
+
       for r in "${resolved[@]}"; do
+        # Wildcard dependencies skip disabled tasks that are not part of this invocation
+        if [[ "$dep_is_wildcard" == true ]] && [[ -z "${invocation_task_set["$r"]+x}" ]] && is_task_disabled "$r"; then
+          continue
+        fi
         validate_dependency "$occ_key" "$r" "$dep_run_spec" \
           invocation_pair_set invocation_task_set _task_run_pairs_ref \
           missing_deps missing_count _task_dep_checks
@@ -7,6 +7,16 @@ is_run_folder() {
   [[ -f "$dir/.run_script.sh" || -f "$dir/.run_begin" || -f "$dir/.run_success" || -f "$dir/.run_failed" || -f "$dir/.run_metadata" ]]
 }
 
+# True if TASK_DISABLED is set to true/1/yes in the task's task_meta.sh chain.
+is_task_disabled() {
+  local task_disabled
+  task_disabled=$(resolve_task_var "$1" "TASK_DISABLED" | tr '[:upper:]' '[:lower:]')
+  case "$task_disabled" in
+    true|1|yes) return 0 ;;
+  esac
+  return 1
+}
+
 # Resolves a single argument to a list of absolute task directory paths.
 # Must be called from REPOSITORY_ROOT or with paths relative to it.
 resolve_arg() {
@@ -151,12 +161,8 @@ build_task_run_pairs() {
         exit 1
       fi
 
-      if [[ "$FORCE_DISABLED" != true ]]; then
-        local task_disabled
-        task_disabled=$(resolve_task_var "$task_dir" "TASK_DISABLED" | tr '[:upper:]' '[:lower:]')
-        case "$task_disabled" in
-          true|1|yes) continue ;;
-        esac
+      if [[ "$FORCE_DISABLED" != true ]] && is_task_disabled "$task_dir"; then
+        continue
       fi
 
       if [[ -z "${task_runs[$task_dir]+x}" ]]; then
@@ -0,0 +1,132 @@
+// Calibration probe measuring the attainable peaks of the node it runs on: FP32 FMA
+// throughput (GFLOP/s) and STREAM triad memory bandwidth (GB/s), both using all OpenMP
+// threads. The results are written to "peak" as key=value lines and serve as the roofs
+// of the roofline plot, together with the node's cache sizes for the size sweep plot.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <omp.h>
+#include <unistd.h>
+
+// Native vector width of the build (-march=native).
+#if defined(__AVX512F__)
+#define PEAK_VECTOR_BYTES 64
+#elif defined(__AVX__)
+#define PEAK_VECTOR_BYTES 32
+#else
+#define PEAK_VECTOR_BYTES 16
+#endif
+
+// Independent FMA chains per thread: enough vector registers to cover FMA latency times
+// the number of FMA ports, without spilling.
+#ifndef PEAK_FMA_CHAINS
+#define PEAK_FMA_CHAINS 12
+#endif
+
+typedef float vfloat __attribute__((vector_size(PEAK_VECTOR_BYTES)));
+constexpr int VECTOR_LANES = PEAK_VECTOR_BYTES / sizeof(float);
+
+#ifndef PEAK_FMA_ITERS
+#define PEAK_FMA_ITERS 50000000
+#endif
+
+// Triad arrays must be much larger than the last-level cache.
+#ifndef STREAM_ELEMENTS
+#define STREAM_ELEMENTS (1 << 25)
+#endif
+
+#ifndef PEAK_REPEATS
+#define PEAK_REPEATS 5
+#endif
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Best-of-PEAK_REPEATS FP32 throughput of acc = acc * a + b into independent accumulators.
+double measure_fma_gflops(int threads, float& sink) {
+    double best = 0;
+    for (int r = 0; r < PEAK_REPEATS; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        #pragma omp parallel num_threads(threads) reduction(+ : sink)
+        {
+            vfloat acc[PEAK_FMA_CHAINS];
+            for (int c = 0; c < PEAK_FMA_CHAINS; ++c) acc[c] = vfloat{} + static_cast<float>(omp_get_thread_num() + c);
+            const vfloat a = vfloat{} + 0.999999f, b = vfloat{} + 1e-7f;
+            for (long it = 0; it < PEAK_FMA_ITERS; ++it) {
+                // Fully unrolled, so the accumulators stay in registers.
+                #pragma GCC unroll 32
+                for (int c = 0; c < PEAK_FMA_CHAINS; ++c) acc[c] = acc[c] * a + b;
+            }
+            for (int c = 0; c < PEAK_FMA_CHAINS; ++c)
+                for (int l = 0; l < VECTOR_LANES; ++l) sink += acc[c][l];
+        }
+        const double flops = 2.0 * PEAK_FMA_CHAINS * VECTOR_LANES * static_cast<double>(PEAK_FMA_ITERS) * threads;
+        best = std::max(best, flops / seconds_since(start) * 1e-9);
+    }
+    return best;
+}
+
+// Best-of-PEAK_REPEATS STREAM triad a = b + s * c, counting 3 x 4 bytes per element as
+// STREAM does (write-allocate traffic is not counted).
+double measure_triad_gbs(int threads, float& sink) {
+    const long n = STREAM_ELEMENTS;
+    std::vector<float> a(n), b(n), c(n);
+    // First touch by the threads that use the pages later.
+    #pragma omp parallel for num_threads(threads) schedule(static)
+    for (long i = 0; i < n; ++i) {
+        a[i] = 0.0f;
+        b[i] = 1.0f;
+        c[i] = 2.0f;
+    }
+    double best = 0;
+    for (int r = 0; r < PEAK_REPEATS; ++r) {
+        const float s = 3.0f + r;
+        auto start = std::chrono::steady_clock::now();
+        #pragma omp parallel for num_threads(threads) schedule(static)
+        for (long i = 0; i < n; ++i) a[i] = b[i] + s * c[i];
+        best = std::max(best, 3.0 * sizeof(float) * n / seconds_since(start) * 1e-9);
+    }
+    sink += a[n / 2];
+    return best;
+}
+
+int main() {
+    // Full-node roofs and single-thread roofs (for serial competitors).
+    float sink = 0;
+    const int threads = omp_get_max_threads();
+    const double gflops = measure_fma_gflops(threads, sink);
+    const double gbs = measure_triad_gbs(threads, sink);
+    const double gflops_1t = threads > 1 ? measure_fma_gflops(1, sink) : gflops;
+    const double gbs_1t = threads > 1 ? measure_triad_gbs(1, sink) : gbs;
+
+    std::ofstream ofs("peak");
+    ofs << "peak_gflops=" << gflops << "\n";
+    ofs << "peak_bandwidth_gbs=" << gbs << "\n";
+    ofs << "peak_gflops_1t=" << gflops_1t << "\n";
+    ofs << "peak_bandwidth_gbs_1t=" << gbs_1t << "\n";
+    ofs << "threads=" << threads << "\n";
+    // Data cache sizes as the C library reports them (omitted where unknown).
+    const std::pair<const char*, int> caches[] = {{"cache_l1_bytes", _SC_LEVEL1_DCACHE_SIZE},
+                                                  {"cache_l2_bytes", _SC_LEVEL2_CACHE_SIZE},
+                                                  {"cache_l3_bytes", _SC_LEVEL3_CACHE_SIZE}};
+    for (const auto& cache : caches) {
+        const long bytes = sysconf(cache.second);
+        if (bytes > 0) ofs << cache.first << "=" << bytes << "\n";
+    }
+    if (!ofs) {
+        std::cerr << "Failed to write peak" << std::endl;
+        return 2;
+    }
+
+    std::cout << "Peak FP32 FMA: " << gflops << " GFLOP/s, STREAM triad: " << gbs << " GB/s ("
+              << threads << " thread(s))" << std::endl;
+    std::cout << "Peak FP32 FMA: " << gflops_1t << " GFLOP/s, STREAM triad: " << gbs_1t << " GB/s (1 thread)" << std::endl;
+    // Keeps the measured loops from being optimized away.
+    return sink == std::numeric_limits<float>::infinity() ? 3 : 0;
+}
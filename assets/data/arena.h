@@ -0,0 +1,163 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+// Aligned memory arena for the operands of the timed runs. Memory comes from anonymous
+// mappings in large chunks: every allocation is ARENA_ALIGNMENT-aligned, allocations of
+// at least a huge page start on a huge-page boundary, and the huge page policy is set
+// per chunk (transparent huge pages via madvise by default, MAP_HUGETLB on request).
+// Allocations are not touched by the arena; the first write decides the NUMA node of a
+// page, so operands are initialized with first_touch_copy(), which writes them with the
+// same threads and partition the harness uses elsewhere. Memory is released when the
+// arena is destroyed.
+
+#include "data_helper.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+
+// Alignment of every allocation in bytes (a power of two, at least a cache line).
+#ifndef ARENA_ALIGNMENT
+#define ARENA_ALIGNMENT 64
+#endif
+
+// Default chunk size; larger allocations get a chunk of their own.
+#ifndef ARENA_CHUNK_BYTES
+#define ARENA_CHUNK_BYTES (size_t(64) << 20)
+#endif
+
+static_assert((ARENA_ALIGNMENT & (ARENA_ALIGNMENT - 1)) == 0 && ARENA_ALIGNMENT >= 64,
+              "ARENA_ALIGNMENT must be a power of two of at least 64");
+
+constexpr size_t HUGE_PAGE_BYTES = size_t(2) << 20;
+
+// Huge page policy of arena chunks.
+enum class HugePages { Off, Transparent, Explicit };
+
+inline const char* huge_pages_name(HugePages mode) {
+    switch (mode) {
+        case HugePages::Off: return "off";
+        case HugePages::Transparent: return "thp";
+        case HugePages::Explicit: return "hugetlb";
+    }
+    return "unknown";
+}
+
+// Read MATMUL_HUGE_PAGES: off (madvise MADV_NOHUGEPAGE), thp (default, MADV_HUGEPAGE), or
+// hugetlb (MAP_HUGETLB from the reserved pool, see /proc/sys/vm/nr_hugepages).
+inline bool huge_pages_from_env(HugePages& mode) {
+    if (const char* env = std::getenv("MATMUL_HUGE_PAGES")) {
+        const std::string name = env;
+        if (name == "off") mode = HugePages::Off;
+        else if (name == "thp") mode = HugePages::Transparent;
+        else if (name == "hugetlb") mode = HugePages::Explicit;
+        else {
+            std::cerr << "Invalid MATMUL_HUGE_PAGES '" << name << "' (expected off, thp, or hugetlb)" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+class Arena {
+public:
+    explicit Arena(HugePages mode = HugePages::Transparent, size_t chunk_bytes = ARENA_CHUNK_BYTES)
+        : mode_(mode), chunk_bytes_(round_up(chunk_bytes, HUGE_PAGE_BYTES)) {}
+    ~Arena() {
+        for (const Chunk& c : chunks_) munmap(c.base, c.length);
+    }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Uninitialized storage for count elements (see first_touch_copy()). Returns an empty
+    // span if the memory cannot be mapped.
+    template <typename T>
+    Span<T> allocate(size_t count) {
+        const size_t bytes = std::max<size_t>(count * sizeof(T), 1);
+        const size_t alignment = bytes >= HUGE_PAGE_BYTES ? HUGE_PAGE_BYTES : ARENA_ALIGNMENT;
+        if (chunks_.empty() || round_up(chunks_.back().used, alignment) + bytes > chunks_.back().length) {
+            if (!map_chunk(std::max(chunk_bytes_, round_up(bytes, HUGE_PAGE_BYTES)))) return {};
+        }
+        Chunk& c = chunks_.back();
+        const size_t offset = round_up(c.used, alignment);
+        c.used = offset + bytes;
+        return Span<T>(reinterpret_cast<T*>(static_cast<char*>(c.base) + offset), count);
+    }
+
+    // A first-touched copy of count elements of src.
+    template <typename T>
+    Span<T> copy_of(const T* src, size_t count);
+
+    // Bytes mapped for the arena's chunks.
+    size_t reserved_bytes() const {
+        size_t total = 0;
+        for (const Chunk& c : chunks_) total += c.length;
+        return total;
+    }
+
+    // Huge page policy in effect: hugetlb falls back to thp if the pool is exhausted.
+    HugePages huge_pages() const { return mode_; }
+
+private:
+    struct Chunk {
+        void* base;
+        size_t length;
+        size_t used;
+    };
+
+    static size_t round_up(size_t n, size_t alignment) { return (n + alignment - 1) / alignment * alignment; }
+
+    bool map_chunk(size_t length) {
+        if (mode_ == HugePages::Explicit) {
+            void* base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (base != MAP_FAILED) {
+                chunks_.push_back({base, length, 0});
+                return true;
+            }
+            std::cerr << "Warning: MAP_HUGETLB failed for " << (length >> 20)
+                      << " MiB (no reserved huge pages?); using transparent huge pages" << std::endl;
+            mode_ = HugePages::Transparent;
+        }
+        // Over-map by one huge page and trim, so the chunk starts on a huge-page boundary.
+        const size_t mapped = length + HUGE_PAGE_BYTES;
+        void* raw = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            std::cerr << "Failed to map " << (length >> 20) << " MiB for the operand arena" << std::endl;
+            return false;
+        }
+        char* begin = static_cast<char*>(raw);
+        char* base = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(begin), HUGE_PAGE_BYTES));
+        if (base > begin) munmap(begin, base - begin);
+        if (begin + mapped > base + length) munmap(base + length, begin + mapped - (base + length));
+        madvise(base, length, mode_ == HugePages::Off ? MADV_NOHUGEPAGE : MADV_HUGEPAGE);
+        chunks_.push_back({base, length, 0});
+        return true;
+    }
+
+    HugePages mode_;
+    size_t chunk_bytes_;
+    std::vector<Chunk> chunks_;
+};
+
+// Write src into dst (of the same size) in parallel contiguous parts, so each page is
+// touched first by one of the copying threads (spans below 2^20 elements are copied by
+// the calling thread).
+template <typename T>
+inline void first_touch_copy(Span<T> dst, const T* src) {
+    parallel_ranges(parallel_parts(dst.size(), size_t(1) << 20), dst.size(), [&](size_t, size_t begin, size_t end) {
+        std::memcpy(dst.data() + begin, src + begin, (end - begin) * sizeof(T));
+    });
+}
+
+template <typename T>
+Span<T> Arena::copy_of(const T* src, size_t count) {
+    Span<T> span = allocate<T>(count);
+    if (!span.empty()) first_touch_copy(span, src);
+    return span;
+}
+
+#endif /* ARENA_H */
@@ -0,0 +1,110 @@
+#include "data_helper.h"
+#include "matmul_gold.h"
+#include <iostream>
+#include <random>
+#include <cstdlib>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Data of a batch of independent matmuls C_b = A_b * B_b, b = 0 .. batch-1, as 3D tensors:
+// A (batch x I x K), B (1 x K x J when all problems share B, batch x K x J otherwise),
+// initial C and expected C (batch x I x J). The values of A and B are their linear index
+// in the matmul generator's random streams, so problem 0 is the MatMul data of the same
+// seed and shape. Batches hold many small problems and are generated in memory.
+int main(int argc, char* argv[]) {
+    if (argc < 5) {
+        std::cerr << "Usage: " << argv[0] << " batch I J K [txt|bin] [seed|random] [shared|batched]" << std::endl;
+        return 1;
+    }
+    int batch = std::atoi(argv[1]);
+    int I = std::atoi(argv[2]);
+    int J = std::atoi(argv[3]);
+    int K = std::atoi(argv[4]);
+    if (batch <= 0 || I <= 0 || J <= 0 || K <= 0) {
+        std::cerr << "batch, I, J, K must be positive" << std::endl;
+        return 1;
+    }
+
+    std::string ext = argc > 5 ? argv[5] : "txt";
+    TensorFormat format;
+    if (!parse_tensor_format(ext, format)) {
+        std::cerr << "Unknown format '" << ext << "' (expected txt or bin)" << std::endl;
+        return 1;
+    }
+    const std::string file_A = "input_A." + ext;
+    const std::string file_B = "input_B." + ext;
+    const std::string file_init_C = "input_C." + ext;
+    const std::string file_C = "output_C." + ext;
+
+    uint64_t seed;
+    const std::string seed_arg = argc > 6 ? argv[6] : "random";
+    if (seed_arg == "random") {
+        std::random_device rd;
+        seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+    } else {
+        char* end = nullptr;
+        seed = std::strtoull(seed_arg.c_str(), &end, 0);
+        if (seed_arg.empty() || *end != '\0') {
+            std::cerr << "Invalid seed '" << seed_arg << "' (expected an integer or random)" << std::endl;
+            return 1;
+        }
+    }
+
+    // shared (default): one B for the whole batch (e.g. the weights of a layer applied to
+    // many inputs); batched: every problem has its own B.
+    const std::string b_arg = argc > 7 ? argv[7] : "shared";
+    if (b_arg != "shared" && b_arg != "batched") {
+        std::cerr << "Invalid B option '" << b_arg << "' (expected shared or batched)" << std::endl;
+        return 1;
+    }
+    const int batch_B = b_arg == "shared" ? 1 : batch;
+
+    const size_t size_A = static_cast<size_t>(I) * K;
+    const size_t size_B = static_cast<size_t>(K) * J;
+    const size_t size_C = static_cast<size_t>(I) * J;
+    std::vector<float> A(batch * size_A);
+    std::vector<float> B(batch_B * size_B);
+    fill_uniform(A.data(), A.size(), seed, STREAM_A);
+    fill_uniform(B.data(), B.size(), seed, STREAM_B);
+
+    std::vector<float> C(batch * size_C, 0.0f);
+    if (!write_matrix(file_init_C, C, {batch, I, J}, format)) {
+        std::cerr << "Failed to write " << file_init_C << std::endl;
+        return 2;
+    }
+    if (!write_matrix(file_A, A, {batch, I, K}, format)) {
+        std::cerr << "Failed to write " << file_A << std::endl;
+        return 2;
+    }
+    if (!write_matrix(file_B, B, {batch_B, K, J}, format)) {
+        std::cerr << "Failed to write " << file_B << std::endl;
+        return 2;
+    }
+
+    // Threads take whole problems; matmul_gold() runs serially inside the parallel region,
+    // so every C_b is bit-identical to the MatMul gold of its A_b and B_b.
+#ifdef _OPENMP
+    omp_set_max_active_levels(1);
+#endif
+    #pragma omp parallel for schedule(dynamic)
+    for (int b = 0; b < batch; ++b) {
+        const float* B_b = B.data() + (batch_B == 1 ? 0 : b * size_B);
+        matmul_gold(A.data() + b * size_A, B_b, C.data() + b * size_C, I, J, K);
+    }
+    if (!write_matrix(file_C, C, {batch, I, J}, format)) {
+        std::cerr << "Failed to write " << file_C << std::endl;
+        return 2;
+    }
+#ifdef _OPENMP
+    std::cout << "Computed expected C using " << omp_get_max_threads() << " thread(s)\n";
+#endif
+
+    std::cout << "Seed: " << seed << "\n";
+    std::cout << "Wrote A (" << batch << "x" << I << "x" << K << ") to " << file_A << "\n";
+    std::cout << "Wrote B (" << batch_B << "x" << K << "x" << J << ") to " << file_B << "\n";
+    std::cout << "Wrote initial C (" << batch << "x" << I << "x" << J << ") to " << file_init_C << "\n";
+    std::cout << "Wrote expected C (" << batch << "x" << I << "x" << J << ") to " << file_C << "\n";
+
+    return 0;
+}
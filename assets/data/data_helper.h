@@ -6,13 +6,50 @@
 #endif
 
 #include <fstream>
+#include <iostream>
 #include <limits>
 #include <cmath>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Non-owning view of count contiguous elements.
+template <typename T>
+class Span {
+public:
+    Span() = default;
+    Span(T* data, size_t size) : data_(data), size_(size) {}
+    // Span<const T> from Span<T>.
+    template <typename U>
+    Span(const Span<U>& other) : data_(other.data()), size_(other.size()) {}
+
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T& operator[](size_t i) const { return data_[i]; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+    Span subspan(size_t offset, size_t count) const { return Span(data_ + offset, count); }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
 // Compute total size from dimensions.
 inline size_t total_size(const std::vector<int>& dims) {
     size_t n = 1;
@@ -41,29 +78,356 @@ inline std::vector<int> linear_to_index(size_t linear, const std::vector<int>& d
     return idx;
 }
 
+// Order of a matrix's elements in a tensor payload. Row-major is the default (and the only
+// order of tensors that are not 2D). Column-major stores the transpose row-major. Blocked
+// stores block_rows x block_cols tiles, each row-major: tile rows follow each other, the
+// tiles of a tile row go left to right, the columns are zero-padded to a multiple of
+// block_cols, and the last tile row is only as high as the rows left. A tile is then one
+// NR-column panel of a KC-row block, as a packing GEMM (assets/experiments/gemm) builds it.
+enum class LayoutKind : uint32_t { RowMajor = 0, ColMajor = 1, Blocked = 2 };
+
+struct TensorLayout {
+    LayoutKind kind = LayoutKind::RowMajor;
+    int block_rows = 0, block_cols = 0;  // blocked only
+
+    bool row_major() const { return kind == LayoutKind::RowMajor; }
+    bool operator==(const TensorLayout& o) const {
+        return kind == o.kind && (kind != LayoutKind::Blocked || (block_rows == o.block_rows && block_cols == o.block_cols));
+    }
+    bool operator!=(const TensorLayout& o) const { return !(*this == o); }
+};
+
+// Layout names as used in file names and settings: rowmajor, colmajor, blocked_<rows>x<cols>.
+inline std::string layout_name(const TensorLayout& layout) {
+    switch (layout.kind) {
+        case LayoutKind::RowMajor: return "rowmajor";
+        case LayoutKind::ColMajor: return "colmajor";
+        case LayoutKind::Blocked:
+            return "blocked_" + std::to_string(layout.block_rows) + "x" + std::to_string(layout.block_cols);
+    }
+    return "unknown";
+}
+
+inline bool parse_layout(const std::string& name, TensorLayout& layout) {
+    if (name == "rowmajor") layout = TensorLayout{};
+    else if (name == "colmajor") layout = TensorLayout{LayoutKind::ColMajor, 0, 0};
+    else {
+        int rows = 0, cols = 0;
+        char end = 0;
+        if (std::sscanf(name.c_str(), "blocked_%dx%d%c", &rows, &cols, &end) != 2 || rows <= 0 || cols <= 0) return false;
+        layout = TensorLayout{LayoutKind::Blocked, rows, cols};
+    }
+    return true;
+}
+
+// Elements a rows x cols matrix takes in the layout (more than rows * cols if blocked
+// columns are padded).
+inline size_t layout_elements(const TensorLayout& layout, int rows, int cols) {
+    if (layout.kind != LayoutKind::Blocked) return static_cast<size_t>(rows) * cols;
+    return static_cast<size_t>(rows) * ((cols + layout.block_cols - 1) / layout.block_cols * layout.block_cols);
+}
+
+// Position of element (r, c) of a rows x cols matrix in the layout.
+inline size_t layout_offset(const TensorLayout& layout, int rows, int cols, int r, int c) {
+    switch (layout.kind) {
+        case LayoutKind::RowMajor: return static_cast<size_t>(r) * cols + c;
+        case LayoutKind::ColMajor: return static_cast<size_t>(c) * rows + r;
+        case LayoutKind::Blocked: break;
+    }
+    const int br = layout.block_rows, bc = layout.block_cols;
+    const size_t padded_cols = (cols + bc - 1) / bc * bc;
+    const int r0 = r / br * br, height = std::min(br, rows - r0);
+    return static_cast<size_t>(r0) * padded_cols + static_cast<size_t>(c / bc) * height * bc +
+           static_cast<size_t>(r - r0) * bc + c % bc;
+}
+
+// Payload elements of a tensor: layout_elements() of a matrix, the product of the dimensions otherwise.
+inline size_t tensor_elements(const std::vector<int>& dims, const TensorLayout& layout) {
+    if (dims.size() == 2) return layout_elements(layout, dims[0], dims[1]);
+    return total_size(dims);
+}
+
+// Linear index of a multidimensional index in the layout (2D tensors; row-major otherwise).
+inline size_t index_to_linear(const std::vector<int>& idx, const std::vector<int>& dims, const TensorLayout& layout) {
+    if (dims.size() != 2 || layout.row_major()) return index_to_linear(idx, dims);
+    return layout_offset(layout, dims[0], dims[1], idx[0], idx[1]);
+}
+
+// Multidimensional index of a linear index in the layout; empty for the padding of a blocked layout.
+inline std::vector<int> linear_to_index(size_t linear, const std::vector<int>& dims, const TensorLayout& layout) {
+    if (dims.size() != 2 || layout.row_major()) return linear_to_index(linear, dims);
+    const int rows = dims[0], cols = dims[1];
+    if (layout.kind == LayoutKind::ColMajor) {
+        return {static_cast<int>(linear % rows), static_cast<int>(linear / rows)};
+    }
+    const int br = layout.block_rows, bc = layout.block_cols;
+    const size_t padded_cols = (cols + bc - 1) / bc * bc;
+    const int r0 = static_cast<int>(linear / (br * padded_cols)) * br, height = std::min(br, rows - r0);
+    const size_t in_tile_row = linear - static_cast<size_t>(r0) * padded_cols;
+    const size_t tile = in_tile_row / (static_cast<size_t>(height) * bc), in_tile = in_tile_row % (static_cast<size_t>(height) * bc);
+    const int r = r0 + static_cast<int>(in_tile / bc), c = static_cast<int>(tile * bc + in_tile % bc);
+    if (c >= cols) return {};
+    return {r, c};
+}
+
+// Values per line of a text tensor: one row, column, or tile row of the payload order.
+inline int layout_line_length(const std::vector<int>& dims, const TensorLayout& layout) {
+    if (dims.size() != 2) return dims.back();
+    switch (layout.kind) {
+        case LayoutKind::RowMajor: return dims[1];
+        case LayoutKind::ColMajor: return dims[0];
+        case LayoutKind::Blocked: return layout.block_cols;
+    }
+    return dims.back();
+}
+
+// Store the rows x cols matrix src (row stride ld) in the layout; dst holds
+// layout_elements() values, blocked padding is zeroed. Works in 64 x 64 squares, so
+// neither side is walked with a large stride for long.
+template <typename T>
+inline void to_layout(const T* src, int rows, int cols, size_t ld, const TensorLayout& layout, T* dst) {
+    if (layout.kind == LayoutKind::Blocked) std::fill(dst, dst + layout_elements(layout, rows, cols), T{});
+    constexpr int SQUARE = 64;
+    for (int r0 = 0; r0 < rows; r0 += SQUARE) {
+        for (int c0 = 0; c0 < cols; c0 += SQUARE) {
+            for (int r = r0; r < std::min(rows, r0 + SQUARE); ++r)
+                for (int c = c0; c < std::min(cols, c0 + SQUARE); ++c)
+                    dst[layout_offset(layout, rows, cols, r, c)] = src[static_cast<size_t>(r) * ld + c];
+        }
+    }
+}
+
+// Inverse of to_layout(): the rows x cols matrix stored in the layout, row-major into dst.
+template <typename T>
+inline void from_layout(const T* src, const TensorLayout& layout, int rows, int cols, T* dst) {
+    constexpr int SQUARE = 64;
+    for (int r0 = 0; r0 < rows; r0 += SQUARE) {
+        for (int c0 = 0; c0 < cols; c0 += SQUARE) {
+            for (int r = r0; r < std::min(rows, r0 + SQUARE); ++r)
+                for (int c = c0; c < std::min(cols, c0 + SQUARE); ++c)
+                    dst[static_cast<size_t>(r) * cols + c] = src[layout_offset(layout, rows, cols, r, c)];
+        }
+    }
+}
+
+// Philox4x32-10 counter-based random number generator (Salmon et al., SC'11). Each
+// 128-bit counter maps to four independent 32-bit outputs under a 64-bit key, so any block
+// of a random stream can be computed directly ("skip-ahead") without generating the ones
+// before it. That lets threads fill disjoint ranges independently with identical results.
+inline std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> ctr, std::array<uint32_t, 2> key) {
+    constexpr uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+    constexpr uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+    for (int round = 0; round < 10; ++round) {
+        const uint64_t p0 = static_cast<uint64_t>(M0) * ctr[0];
+        const uint64_t p1 = static_cast<uint64_t>(M1) * ctr[2];
+        ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<uint32_t>(p1),
+               static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<uint32_t>(p0)};
+        key[0] += W0;
+        key[1] += W1;
+    }
+    return ctr;
+}
+
+// Fill out[0, count) with uniform floats in [0, 1) taken from elements
+// [offset, offset + count) of random stream `stream` under `seed`. Element n is lane n % 4
+// of Philox block n / 4, so the values depend only on (seed, stream, n) -- not on how a
+// tensor is split into calls or how many OpenMP threads fill it.
+inline void fill_uniform(float* out, size_t count, uint64_t seed, uint32_t stream, size_t offset = 0) {
+    if (count == 0) return;
+    const std::array<uint32_t, 2> key = {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    const int64_t first_block = static_cast<int64_t>(offset / 4);
+    const int64_t last_block = static_cast<int64_t>((offset + count - 1) / 4);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int64_t b = first_block; b <= last_block; ++b) {
+        const uint64_t block = static_cast<uint64_t>(b);
+        const std::array<uint32_t, 4> r = philox4x32(
+            {static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32), stream, 0}, key);
+        for (size_t lane = 0; lane < 4; ++lane) {
+            const size_t n = static_cast<size_t>(block) * 4 + lane;
+            // Top 24 bits: exactly representable, so the result is always < 1.
+            if (n >= offset && n < offset + count) out[n - offset] = static_cast<float>(r[lane] >> 8) * 0x1p-24f;
+        }
+    }
+}
+
+// Element types for reduced-precision operands. bfloat16 and float16 are storage types
+// (bit patterns with conversions to and from float, layout-compatible with the vendor
+// types such as __nv_bfloat16); int8_t operands are quantized with a per-tensor scale.
+struct bfloat16 {
+    uint16_t bits;
+};
+
+struct float16 {
+    uint16_t bits;
+};
+
+inline uint32_t float_bits(float x) {
+    uint32_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    return u;
+}
+
+inline float float_from_bits(uint32_t u) {
+    float x;
+    std::memcpy(&x, &u, sizeof(x));
+    return x;
+}
+
+// Round to nearest even; NaNs stay (quiet) NaNs.
+inline bfloat16 to_bfloat16(float x) {
+    const uint32_t u = float_bits(x);
+    if ((u & 0x7fffffffu) > 0x7f800000u) return {static_cast<uint16_t>((u >> 16) | 0x40)};
+    return {static_cast<uint16_t>((u + 0x7fffu + ((u >> 16) & 1)) >> 16)};
+}
+
+inline float to_float(bfloat16 x) {
+    return float_from_bits(static_cast<uint32_t>(x.bits) << 16);
+}
+
+// Round to nearest even, including to half subnormals; overflow gives infinity.
+inline float16 to_float16(float x) {
+    uint32_t u = float_bits(x);
+    const uint32_t sign = (u >> 16) & 0x8000u;
+    u &= 0x7fffffffu;
+    uint32_t h;
+    if (u >= (143u << 23)) {
+        h = u > 0x7f800000u ? 0x7e00u : 0x7c00u;
+    } else if (u < (113u << 23)) {
+        // Below the smallest normal half: adding 0.5 aligns the result to its subnormal
+        // ULP (2^-24), so the float addition does the rounding.
+        h = float_bits(float_from_bits(u) + 0.5f) - (126u << 23);
+    } else {
+        u += (static_cast<uint32_t>(15 - 127) << 23) + 0xfffu + ((u >> 13) & 1);
+        h = u >> 13;
+    }
+    return {static_cast<uint16_t>(h | sign)};
+}
+
+inline float to_float(float16 x) {
+    const uint32_t sign = static_cast<uint32_t>(x.bits & 0x8000u) << 16;
+    uint32_t u = static_cast<uint32_t>(x.bits & 0x7fffu) << 13;
+    const uint32_t exponent = u & (0x7c00u << 13);
+    u += static_cast<uint32_t>(127 - 15) << 23;
+    if (exponent == (0x7c00u << 13)) {
+        u += static_cast<uint32_t>(128 - 16) << 23;
+    } else if (exponent == 0) {
+        u = float_bits(float_from_bits(u + (1u << 23)) - float_from_bits(113u << 23));
+    }
+    return float_from_bits(u | sign);
+}
+
+// Unit roundoff of the float type (half an ULP of 1).
+constexpr float FLOAT_UNIT_ROUNDOFF = 0x1p-24f;
+
+// Largest magnitude of a symmetric int8 quantization (-127 .. 127, so that negation is exact).
+constexpr int INT8_QUANT_MAX = 127;
+
+// Per-type properties: the name used in logs, the binary tensor dtype, the unit roundoff of
+// a conversion from float (0 for quantized types, whose error is absolute), and the
+// conversions. from_float() of int8_t takes an already scaled value.
+template <typename T>
+struct ElementTraits;
+
+template <>
+struct ElementTraits<float> {
+    static constexpr const char* name = "f32";
+    static constexpr uint32_t dtype = 1;
+    static constexpr float unit_roundoff = FLOAT_UNIT_ROUNDOFF;
+    static constexpr bool quantized = false;
+    static float from_float(float x) { return x; }
+    static float to_float(float x) { return x; }
+};
+
+template <>
+struct ElementTraits<bfloat16> {
+    static constexpr const char* name = "bf16";
+    static constexpr uint32_t dtype = 2;
+    static constexpr float unit_roundoff = 0x1p-8f;
+    static constexpr bool quantized = false;
+    static bfloat16 from_float(float x) { return to_bfloat16(x); }
+    static float to_float(bfloat16 x) { return ::to_float(x); }
+};
+
+template <>
+struct ElementTraits<float16> {
+    static constexpr const char* name = "f16";
+    static constexpr uint32_t dtype = 3;
+    static constexpr float unit_roundoff = 0x1p-11f;
+    static constexpr bool quantized = false;
+    static float16 from_float(float x) { return to_float16(x); }
+    static float to_float(float16 x) { return ::to_float(x); }
+};
+
+template <>
+struct ElementTraits<int8_t> {
+    static constexpr const char* name = "i8";
+    static constexpr uint32_t dtype = 4;
+    static constexpr float unit_roundoff = 0;
+    static constexpr bool quantized = true;
+    static int8_t from_float(float x) {
+        return static_cast<int8_t>(std::lrint(std::min(std::max(x, float(-INT8_QUANT_MAX)), float(INT8_QUANT_MAX))));
+    }
+    static float to_float(int8_t x) { return x; }
+};
+
+// Scale of a per-tensor symmetric quantization of values to T (value = scale * element):
+// the largest magnitude maps to INT8_QUANT_MAX. 1 for floating-point types.
+template <typename T>
+inline float quantization_scale(const float* values, size_t n) {
+    if (!ElementTraits<T>::quantized) return 1.0f;
+    float max_abs = 0;
+    for (size_t i = 0; i < n; ++i) max_abs = std::max(max_abs, std::fabs(values[i]));
+    return max_abs > 0 ? max_abs / INT8_QUANT_MAX : 1.0f;
+}
+
+// Convert n floats to T, dividing by scale first (see quantization_scale()).
+template <typename T>
+inline void convert_elements(const float* in, T* out, size_t n, float scale = 1.0f) {
+    const float inv_scale = 1.0f / scale;
+    for (size_t i = 0; i < n; ++i) out[i] = ElementTraits<T>::from_float(scale == 1.0f ? in[i] : in[i] * inv_scale);
+}
+
 // Read a tensor from text file: first line lists dimensions, then values in row-major order.
 // Format: "d0 d1 d2 ..." on first line, then lines of space-separated values (last dim per line).
-inline bool read_matrix(const std::string& filename, std::vector<float>& mat, std::vector<int>& dims) {
+// A matrix in another layout has "layout=<name>" after its dimensions and its values in
+// the layout's order, one line per layout_line_length(). Values are parsed as floats and
+// converted to T.
+template <typename T>
+inline bool read_matrix_text(const std::string& filename, std::vector<T>& mat, std::vector<int>& dims,
+                             TensorLayout& layout) {
     std::ifstream ifs(filename);
     if (!ifs) return false;
     std::string line;
     if (!std::getline(ifs, line)) return false;
     std::istringstream iss(line);
     dims.clear();
-    int d;
-    while (iss >> d) dims.push_back(d);
-    if (dims.empty()) return false;
+    layout = TensorLayout{};
+    std::string token;
+    while (iss >> token) {
+        if (token.compare(0, 7, "layout=") == 0) {
+            if (!parse_layout(token.substr(7), layout)) return false;
+        } else {
+            char* end = nullptr;
+            const long d = std::strtol(token.c_str(), &end, 10);
+            if (*end != '\0' || d <= 0 || d > std::numeric_limits<int>::max()) return false;
+            dims.push_back(static_cast<int>(d));
+        }
+    }
+    if (dims.empty() || (!layout.row_major() && dims.size() != 2)) return false;
 
-    size_t n = total_size(dims);
+    size_t n = tensor_elements(dims, layout);
     mat.resize(n);
 
     size_t read = 0;
-    int last_dim = dims.back();
+    int last_dim = layout_line_length(dims, layout);
     while (read < n && std::getline(ifs, line)) {
         std::istringstream row_stream(line);
         for (int j = 0; j < last_dim && read < n; ++j) {
-            if (!(row_stream >> mat[read])) return false;
-            ++read;
+            float value;
+            if (!(row_stream >> value)) return false;
+            mat[read++] = ElementTraits<T>::from_float(value);
         }
     }
     return read == n;
@@ -96,8 +460,810 @@ inline bool write_matrix(const std::string& filename, const std::vector<float>&
     return ofs.good();
 }
 
+// Binary tensor format: a fixed-size header followed by the raw payload, row-major or in
+// the layout of the header. The payload starts at a multiple of the header's alignment, so
+// a memory-mapped file (mapped at a page boundary) yields an aligned pointer without copying.
+// Version 2 added the layout fields; row-major tensors are still written as version 1
+// (the first TENSOR_V1_HEADER_BYTES of the header), so their files did not change.
+constexpr char TENSOR_MAGIC[8] = {'T', 'E', 'N', 'S', 'O', 'R', 'B', '1'};
+constexpr uint32_t TENSOR_VERSION = 2;
+constexpr size_t TENSOR_V1_HEADER_BYTES = 112;
+constexpr uint32_t TENSOR_DTYPE_F32 = ElementTraits<float>::dtype;
+constexpr uint32_t TENSOR_MAX_DIMS = 8;
+constexpr uint32_t TENSOR_DEFAULT_ALIGNMENT = 64;
+
+struct TensorHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;           // ElementTraits<T>::dtype of the payload elements
+    uint32_t ndims;
+    uint32_t alignment;       // payload_offset is a multiple of this
+    uint64_t payload_offset;  // bytes from start of file
+    uint64_t payload_bytes;
+    uint64_t checksum;        // tensor_checksum() of the payload
+    uint64_t dims[TENSOR_MAX_DIMS];
+    uint32_t layout;          // LayoutKind of the payload (version 2)
+    uint32_t block_rows;      // tile size of a blocked layout
+    uint32_t block_cols;
+    uint32_t reserved;
+};
+static_assert(sizeof(TensorHeader) == 128, "TensorHeader layout must stay stable");
+static_assert(offsetof(TensorHeader, layout) == TENSOR_V1_HEADER_BYTES, "Version 1 header must be a prefix");
+
+enum class TensorFormat { Text, Binary };
+
+// 64-bit FNV-1a style checksum, mixed one 8-byte word at a time to keep up with disk reads.
+// Incremental: feeding a payload in pieces of any size gives the same value as one update().
+class TensorChecksum {
+public:
+    void update(const void* data, size_t bytes) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        while (tail_len_ > 0 && tail_len_ < 8 && bytes > 0) {
+            tail_[tail_len_++] = *p++;
+            --bytes;
+        }
+        if (tail_len_ == 8) {
+            mix_word(tail_);
+            tail_len_ = 0;
+        }
+        size_t i = 0;
+        for (; i + 8 <= bytes; i += 8) mix_word(p + i);
+        for (; i < bytes; ++i) tail_[tail_len_++] = p[i];
+    }
+
+    uint64_t value() const {
+        uint64_t h = h_;
+        for (size_t i = 0; i < tail_len_; ++i) h = (h ^ tail_[i]) * 1099511628211ULL;
+        return h;
+    }
+
+private:
+    void mix_word(const unsigned char* p) {
+        uint64_t w;
+        std::memcpy(&w, p, 8);
+        h_ = (h_ ^ w) * 1099511628211ULL;
+    }
+
+    uint64_t h_ = 14695981039346656037ULL;
+    unsigned char tail_[8] = {};
+    size_t tail_len_ = 0;
+};
+
+inline uint64_t tensor_checksum(const void* data, size_t bytes) {
+    TensorChecksum checksum;
+    checksum.update(data, bytes);
+    return checksum.value();
+}
+
+// Returns true if the file starts with the binary tensor magic bytes.
+inline bool is_binary_tensor(const std::string& filename) {
+    std::ifstream ifs(filename, std::ios::binary);
+    char magic[sizeof(TENSOR_MAGIC)];
+    if (!ifs.read(magic, sizeof(magic))) return false;
+    return std::memcmp(magic, TENSOR_MAGIC, sizeof(magic)) == 0;
+}
+
+// Streaming tensor writer: the payload is appended in pieces (e.g. row panels), so a
+// tensor never has to be held in memory as a whole. For binary files the header is
+// rewritten with the final checksum on close(). alignment must be a power of two and a
+// multiple of sizeof(T); it is ignored for text files, which hold the values as floats.
+// Layouts other than row-major need a 2D tensor; the payload is appended in their order.
+template <typename T>
+class BasicTensorWriter {
+public:
+    BasicTensorWriter() = default;
+    BasicTensorWriter(const BasicTensorWriter&) = delete;
+    BasicTensorWriter& operator=(const BasicTensorWriter&) = delete;
+
+    bool open(
+        const std::string& filename, const std::vector<int>& dims, TensorFormat format,
+        uint32_t alignment = TENSOR_DEFAULT_ALIGNMENT, TensorLayout layout = {}
+    ) {
+        if (dims.empty() || dims.size() > TENSOR_MAX_DIMS) return false;
+        if (alignment < sizeof(T) || (alignment & (alignment - 1)) != 0) return false;
+        if (!layout.row_major() && dims.size() != 2) return false;
+        if (layout.kind == LayoutKind::Blocked && (layout.block_rows <= 0 || layout.block_cols <= 0)) return false;
+        dims_ = dims;
+        format_ = format;
+        line_length_ = static_cast<size_t>(layout_line_length(dims, layout));
+        total_ = tensor_elements(dims, layout);
+        written_ = 0;
+        checksum_ = TensorChecksum();
+
+        ofs_.open(filename, format == TensorFormat::Binary ? std::ios::binary | std::ios::out : std::ios::out);
+        if (!ofs_) return false;
+        if (format == TensorFormat::Text) {
+            for (size_t i = 0; i < dims.size(); ++i) {
+                if (i > 0) ofs_ << " ";
+                ofs_ << dims[i];
+            }
+            if (!layout.row_major()) ofs_ << " layout=" << layout_name(layout);
+            ofs_ << "\n";
+            ofs_ << std::setprecision(std::numeric_limits<float>::max_digits10);
+            return ofs_.good();
+        }
+
+        header_ = {};
+        std::memcpy(header_.magic, TENSOR_MAGIC, sizeof(TENSOR_MAGIC));
+        header_.version = layout.row_major() ? 1 : TENSOR_VERSION;
+        header_.dtype = ElementTraits<T>::dtype;
+        header_.ndims = static_cast<uint32_t>(dims.size());
+        header_.alignment = alignment;
+        header_bytes_ = layout.row_major() ? TENSOR_V1_HEADER_BYTES : sizeof(TensorHeader);
+        header_.payload_offset = (header_bytes_ + alignment - 1) / alignment * alignment;
+        header_.payload_bytes = total_ * sizeof(T);
+        for (size_t i = 0; i < dims.size(); ++i) header_.dims[i] = static_cast<uint64_t>(dims[i]);
+        header_.layout = static_cast<uint32_t>(layout.kind);
+        header_.block_rows = static_cast<uint32_t>(layout.block_rows);
+        header_.block_cols = static_cast<uint32_t>(layout.block_cols);
+        // The checksum is filled in by close(); until then the file does not validate.
+        ofs_.write(reinterpret_cast<const char*>(&header_), static_cast<std::streamsize>(header_bytes_));
+        std::vector<char> padding(header_.payload_offset - header_bytes_, 0);
+        ofs_.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        return ofs_.good();
+    }
+
+    // Append the next count values in payload order (row-major unless a layout was given).
+    bool append(const T* values, size_t count) {
+        if (!ofs_.is_open() || written_ + count > total_) return false;
+        if (format_ == TensorFormat::Binary) {
+            const size_t bytes = count * sizeof(T);
+            checksum_.update(values, bytes);
+            ofs_.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(bytes));
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                const size_t col = (written_ + i) % line_length_;
+                if (col > 0) ofs_ << " ";
+                ofs_ << ElementTraits<T>::to_float(values[i]);
+                if (col + 1 == line_length_) ofs_ << "\n";
+            }
+        }
+        written_ += count;
+        return ofs_.good();
+    }
+
+    // Finish the file. Fails if fewer values than the dimensions require were appended.
+    bool close() {
+        if (!ofs_.is_open()) return false;
+        bool ok = written_ == total_;
+        if (ok && format_ == TensorFormat::Binary) {
+            header_.checksum = checksum_.value();
+            ofs_.seekp(0);
+            ofs_.write(reinterpret_cast<const char*>(&header_), static_cast<std::streamsize>(header_bytes_));
+        }
+        ok = ok && ofs_.good();
+        ofs_.close();
+        return ok;
+    }
+
+private:
+    std::ofstream ofs_;
+    TensorFormat format_ = TensorFormat::Binary;
+    TensorHeader header_ = {};
+    size_t header_bytes_ = sizeof(TensorHeader);
+    std::vector<int> dims_;
+    size_t line_length_ = 1;
+    size_t total_ = 0;
+    size_t written_ = 0;
+    TensorChecksum checksum_;
+};
+
+using TensorWriter = BasicTensorWriter<float>;
+
+// Write a tensor in binary format. alignment must be a power of two and a multiple of sizeof(T).
+template <typename T>
+inline bool write_matrix_binary(
+    const std::string& filename, const T* mat, const std::vector<int>& dims,
+    uint32_t alignment = TENSOR_DEFAULT_ALIGNMENT
+) {
+    BasicTensorWriter<T> writer;
+    return writer.open(filename, dims, TensorFormat::Binary, alignment) &&
+           writer.append(mat, total_size(dims)) && writer.close();
+}
+
+// Read-only view of a tensor file. Binary files are memory-mapped and data() points into the
+// mapping (no copy); text files are parsed into storage owned by the view. In both cases
+// data() stays valid for the lifetime of the view. A binary file must hold elements of type T.
+// data() holds the payload in the file's layout(); size() counts its elements.
+template <typename T>
+class BasicTensorView {
+public:
+    BasicTensorView() = default;
+    ~BasicTensorView() { reset(); }
+    BasicTensorView(const BasicTensorView&) = delete;
+    BasicTensorView& operator=(const BasicTensorView&) = delete;
+    BasicTensorView(BasicTensorView&& other) noexcept { *this = std::move(other); }
+    BasicTensorView& operator=(BasicTensorView&& other) noexcept {
+        if (this != &other) {
+            reset();
+            dims_ = std::move(other.dims_);
+            layout_ = other.layout_;
+            owned_ = std::move(other.owned_);
+            map_base_ = other.map_base_;
+            map_length_ = other.map_length_;
+            data_ = map_base_ ? other.data_ : owned_.data();
+            other.map_base_ = nullptr;
+            other.map_length_ = 0;
+            other.data_ = nullptr;
+        }
+        return *this;
+    }
+
+    const T* data() const { return data_; }
+    const std::vector<int>& dims() const { return dims_; }
+    const TensorLayout& layout() const { return layout_; }
+    size_t size() const { return dims_.empty() ? 0 : tensor_elements(dims_, layout_); }
+    Span<const T> span() const { return Span<const T>(data_, size()); }
+    bool mapped() const { return map_base_ != nullptr; }
+
+    void reset() {
+        if (map_base_) munmap(map_base_, map_length_);
+        map_base_ = nullptr;
+        map_length_ = 0;
+        data_ = nullptr;
+        dims_.clear();
+        layout_ = TensorLayout{};
+        owned_.clear();
+    }
+
+    // Map a binary tensor file. With verify_checksum, the payload checksum is checked
+    // (this touches every page once, which also pre-faults the mapping).
+    bool map_binary(const std::string& filename, bool verify_checksum = true) {
+        reset();
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < TENSOR_V1_HEADER_BYTES) {
+            close(fd);
+            return false;
+        }
+        size_t length = static_cast<size_t>(st.st_size);
+        void* base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) return false;
+        map_base_ = base;
+        map_length_ = length;
+
+        // Version 1 headers end before the layout fields, which stay zero (row-major).
+        TensorHeader header = {};
+        std::memcpy(&header, base, TENSOR_V1_HEADER_BYTES);
+        const size_t header_bytes = header.version == 1 ? TENSOR_V1_HEADER_BYTES : sizeof(TensorHeader);
+        if (header.version == TENSOR_VERSION && length >= sizeof(TensorHeader)) std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, TENSOR_MAGIC, sizeof(TENSOR_MAGIC)) != 0 ||
+            header.version < 1 || header.version > TENSOR_VERSION || length < header_bytes ||
+            header.dtype != ElementTraits<T>::dtype ||
+            header.ndims == 0 || header.ndims > TENSOR_MAX_DIMS ||
+            header.alignment == 0 || header.payload_offset % header.alignment != 0 ||
+            header.payload_offset < header_bytes ||
+            header.payload_offset + header.payload_bytes > length ||
+            header.layout > static_cast<uint32_t>(LayoutKind::Blocked) ||
+            (header.layout != 0 && header.ndims != 2) ||
+            (header.layout == static_cast<uint32_t>(LayoutKind::Blocked) &&
+             (header.block_rows == 0 || header.block_cols == 0 ||
+              header.block_rows > static_cast<uint32_t>(std::numeric_limits<int>::max()) ||
+              header.block_cols > static_cast<uint32_t>(std::numeric_limits<int>::max())))) {
+            reset();
+            return false;
+        }
+        layout_ = TensorLayout{static_cast<LayoutKind>(header.layout), static_cast<int>(header.block_rows),
+                               static_cast<int>(header.block_cols)};
+        for (uint32_t i = 0; i < header.ndims; ++i) {
+            if (header.dims[i] == 0 || header.dims[i] > static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+                reset();
+                return false;
+            }
+            dims_.push_back(static_cast<int>(header.dims[i]));
+        }
+        if (tensor_elements(dims_, layout_) * sizeof(T) != header.payload_bytes) {
+            reset();
+            return false;
+        }
+
+        const char* payload = static_cast<const char*>(base) + header.payload_offset;
+        madvise(base, length, MADV_WILLNEED);
+        if (verify_checksum && tensor_checksum(payload, header.payload_bytes) != header.checksum) {
+            reset();
+            return false;
+        }
+        data_ = reinterpret_cast<const T*>(payload);
+        return true;
+    }
+
+    // Parse a text tensor file into owned storage.
+    bool read_text(const std::string& filename) {
+        reset();
+        if (!read_matrix_text(filename, owned_, dims_, layout_)) {
+            reset();
+            return false;
+        }
+        data_ = owned_.data();
+        return true;
+    }
+
+private:
+    std::vector<int> dims_;
+    TensorLayout layout_;
+    std::vector<T> owned_;
+    void* map_base_ = nullptr;
+    size_t map_length_ = 0;
+    const T* data_ = nullptr;
+};
+
+using TensorView = BasicTensorView<float>;
+
+// Open a tensor file in either format, chosen by the file's magic bytes.
+template <typename T>
+inline bool load_tensor(const std::string& filename, BasicTensorView<T>& view, bool verify_checksum = true) {
+    if (is_binary_tensor(filename)) return view.map_binary(filename, verify_checksum);
+    return view.read_text(filename);
+}
+
+// Read a tensor in either format into a caller-owned vector, row-major (copies for binary
+// files; matrices in other layouts are converted).
+inline bool read_matrix(const std::string& filename, std::vector<float>& mat, std::vector<int>& dims) {
+    TensorView view;
+    if (!load_tensor(filename, view)) return false;
+    dims = view.dims();
+    if (view.layout().row_major()) {
+        mat.assign(view.data(), view.data() + view.size());
+    } else {
+        mat.resize(total_size(dims));
+        from_layout(view.data(), view.layout(), dims[0], dims[1], mat.data());
+    }
+    return true;
+}
+
+// Write a tensor in the requested format.
+inline bool write_matrix(
+    const std::string& filename, const std::vector<float>& mat, const std::vector<int>& dims,
+    TensorFormat format
+) {
+    if (format == TensorFormat::Text) return write_matrix(filename, mat, dims);
+    if (mat.size() != total_size(dims)) return false;
+    return write_matrix_binary(filename, mat.data(), dims);
+}
+
+// Parse a format name ("txt" or "bin") as used for file extensions and command-line arguments.
+inline bool parse_tensor_format(const std::string& name, TensorFormat& format) {
+    if (name == "txt") format = TensorFormat::Text;
+    else if (name == "bin") format = TensorFormat::Binary;
+    else return false;
+    return true;
+}
+
+// Elementwise tolerance: an element passes if |calc - expected| <= abs + rel * |expected|.
+struct Tolerance {
+    float abs = EPSILON;
+    float rel = 0;
+};
+
+// Safety factor on the rounding error bound of a K-term dot product in matmul_tolerance().
+#ifndef TOLERANCE_FACTOR
+#define TOLERANCE_FACTOR 2.0f
+#endif
+
+// Tolerance for a matmul with inner dimension K whose products and sums round with the
+// given unit roundoff. A K-term dot product in any summation order has a relative error of
+// at most K * u with respect to sum |a||b| (= |C| for the nonnegative generated inputs), and
+// both the kernel and the gold output carry that error; EPSILON remains the absolute floor.
+// Reduced-precision kernels pass their own (larger) unit roundoff.
+inline Tolerance matmul_tolerance(int K, float unit_roundoff = FLOAT_UNIT_ROUNDOFF) {
+    return {EPSILON, TOLERANCE_FACTOR * static_cast<float>(K) * unit_roundoff};
+}
+
+// Tolerance for a matmul whose float inputs are converted to T (with the given scales for
+// quantized types) and whose products are accumulated in 32 bits. Rounding a and b to a
+// unit roundoff u_T perturbs each product by at most 2 u_T |a||b|, independent of K, so
+// floating-point types add 2 u_T to the relative tolerance. A symmetric int8 quantization
+// errs by up to scale / 2 per element, which bounds each product's error by
+// (INT8_QUANT_MAX + 1/4) scale_A scale_B; summed over K this is absolute. int32
+// accumulation is exact, and the float epilogue keeps matmul_tolerance()'s relative part.
+template <typename T>
+inline Tolerance matmul_tolerance_for(int K, float scale_A = 1.0f, float scale_B = 1.0f) {
+    Tolerance tol = matmul_tolerance(K);
+    if (ElementTraits<T>::quantized) {
+        tol.abs += TOLERANCE_FACTOR * static_cast<float>(K) * (INT8_QUANT_MAX + 0.25f) * scale_A * scale_B;
+    } else if (ElementTraits<T>::unit_roundoff > FLOAT_UNIT_ROUNDOFF) {
+        tol.rel += TOLERANCE_FACTOR * 2 * ElementTraits<T>::unit_roundoff;
+    }
+    return tol;
+}
+
+// Epilogue of a matmul, applied to every element of C as it is written back:
+//   C = act(alpha * A * B + beta * C_init + bias)
+// where bias is a row of J values added to every row of C and act is none, relu, or
+// gelu. The identity epilogue (the default) is C = A * B; with beta = 0 the initial C is
+// not read, so it need not be initialized.
+enum class Activation : uint32_t { None, ReLU, GELU };
+
+inline float activate(Activation activation, float v) {
+    switch (activation) {
+        case Activation::None: return v;
+        case Activation::ReLU: return v > 0.0f ? v : 0.0f;
+        case Activation::GELU: return 0.5f * v * (1.0f + std::erf(v * 0.70710678f));
+    }
+    return v;
+}
+
+struct Epilogue {
+    float alpha = 1.0f;
+    float beta = 0.0f;
+    const float* bias = nullptr;  // J values, or none
+    Activation activation = Activation::None;
+
+    bool identity() const { return alpha == 1.0f && beta == 0.0f && !bias && activation == Activation::None; }
+    // Start of an element's accumulation: beta * c (0 without reading c for beta = 0).
+    float initial(float c) const { return beta != 0.0f ? beta * c : 0.0f; }
+    // Bias and activation of an accumulated v = beta * c + alpha * (A * B)_ij.
+    float finish(float v, int j) const { return activate(activation, bias ? v + bias[j] : v); }
+    // The whole epilogue of one element, in the order the gold output applies it.
+    float apply(float product, float c, int j) const { return finish(initial(c) + alpha * product, j); }
+};
+
+inline const char* activation_name(Activation activation) {
+    switch (activation) {
+        case Activation::None: return "none";
+        case Activation::ReLU: return "relu";
+        case Activation::GELU: return "gelu";
+    }
+    return "unknown";
+}
+
+// "none" for the identity epilogue, else its non-default parts, e.g. "alpha=2,beta=1,bias,gelu".
+inline std::string epilogue_name(const Epilogue& e) {
+    if (e.identity()) return "none";
+    std::ostringstream os;
+    const char* sep = "";
+    if (e.alpha != 1.0f) { os << sep << "alpha=" << e.alpha; sep = ","; }
+    if (e.beta != 0.0f) { os << sep << "beta=" << e.beta; sep = ","; }
+    if (e.bias) { os << sep << "bias"; sep = ","; }
+    if (e.activation != Activation::None) os << sep << activation_name(e.activation);
+    return os.str();
+}
+
+// Parse an epilogue as written by epilogue_name(): "none", or comma-separated parts
+// alpha=<x>, beta=<x>, bias, and one of relu and gelu. bias is set if a bias is added;
+// e.bias itself is left for the caller to point at the values.
+inline bool parse_epilogue(const std::string& spec, Epilogue& e, bool& bias) {
+    e = Epilogue{};
+    bias = false;
+    if (spec == "none" || spec.empty()) return true;
+    std::istringstream is(spec);
+    std::string part;
+    while (std::getline(is, part, ',')) {
+        char* end = nullptr;
+        if (part.compare(0, 6, "alpha=") == 0) {
+            e.alpha = std::strtof(part.c_str() + 6, &end);
+            if (end == part.c_str() + 6 || *end != '\0') return false;
+        } else if (part.compare(0, 5, "beta=") == 0) {
+            e.beta = std::strtof(part.c_str() + 5, &end);
+            if (end == part.c_str() + 5 || *end != '\0') return false;
+        } else if (part == "bias") {
+            bias = true;
+        } else if (part == "relu" || part == "gelu") {
+            if (e.activation != Activation::None) return false;
+            e.activation = part == "relu" ? Activation::ReLU : Activation::GELU;
+        } else {
+            return false;
+        }
+    }
+    return std::isfinite(e.alpha) && std::isfinite(e.beta);
+}
+
+// Largest |values[i]| of n values (0 for none).
+inline float max_abs_value(const float* values, size_t n) {
+    float m = 0;
+    for (size_t i = 0; i < n; ++i) m = std::max(m, std::fabs(values[i]));
+    return m;
+}
+
+// Bound on |(A * B)_ij| for an I x K A and a B of size_B elements: the largest row sum of
+// |A| times the largest |B|.
+inline double product_abs_bound(const float* A, const float* B, size_t size_B, int I, int K) {
+    double row_max = 0;
+    for (int i = 0; i < I; ++i) {
+        double sum = 0;
+        for (int k = 0; k < K; ++k) sum += std::fabs(A[static_cast<size_t>(i) * K + k]);
+        row_max = std::max(row_max, sum);
+    }
+    return row_max * max_abs_value(B, size_B);
+}
+
+// Tolerance of a matmul with an epilogue, from the tolerance of its product. The product
+// error scales with alpha and passes the activation with a gain of at most 1 (relu) or
+// 1.13 (the peak slope of gelu), but where bias, beta * C, or relu cancel the product the
+// result is small while its error is not, so the product error becomes absolute: the
+// relative tolerance times the largest |alpha * (A * B)_ij| (bounded by product_bound),
+// plus a few roundings of the epilogue's own terms (c_bound and bias_bound: the largest
+// |C_init| and |bias|). The identity epilogue keeps the product's tolerance.
+inline Tolerance epilogue_tolerance(Tolerance product, const Epilogue& e, double product_bound, double c_bound,
+                                    double bias_bound) {
+    if (e.identity()) return product;
+    const double gain = e.activation == Activation::GELU ? 1.13 : 1.0;
+    const double terms = std::fabs(e.alpha) * product_bound + std::fabs(e.beta) * c_bound + bias_bound;
+    Tolerance tol = product;
+    tol.abs += static_cast<float>(gain * (product.rel * std::fabs(e.alpha) * product_bound +
+                                          TOLERANCE_FACTOR * 4 * FLOAT_UNIT_ROUNDOFF * terms));
+    tol.rel *= static_cast<float>(gain);
+    return tol;
+}
+
+// Number of ULP-error histogram buckets: bucket 0 counts exact matches, bucket b > 0
+// counts ULP errors in [2^(b-1), 2^b).
+constexpr int ULP_HISTOGRAM_BUCKETS = 33;
+
+// Result of comparing a computed tensor against the expected one.
+struct ComparisonStats {
+    size_t count = 0;
+    size_t mismatches = 0;         // elements outside the tolerance, including NaNs
+    size_t nans = 0;               // elements where calc or expected is NaN
+    float max_abs = 0;             // max |calc - expected|
+    float max_rel = 0;             // max |calc - expected| / |expected| (expected != 0)
+    uint32_t max_ulp = 0;          // max distance in units in the last place
+    size_t worst_idx = static_cast<size_t>(-1);  // linear index of the largest absolute error
+    std::array<size_t, ULP_HISTOGRAM_BUCKETS> ulp_histogram = {};
+
+    bool passed() const { return mismatches == 0; }
+
+    void merge(const ComparisonStats& o) {
+        count += o.count;
+        mismatches += o.mismatches;
+        nans += o.nans;
+        if (o.worst_idx != static_cast<size_t>(-1) && (worst_idx == static_cast<size_t>(-1) || o.max_abs > max_abs)) {
+            worst_idx = o.worst_idx;
+        }
+        max_abs = std::max(max_abs, o.max_abs);
+        max_rel = std::max(max_rel, o.max_rel);
+        max_ulp = std::max(max_ulp, o.max_ulp);
+        for (int b = 0; b < ULP_HISTOGRAM_BUCKETS; ++b) ulp_histogram[b] += o.ulp_histogram[b];
+    }
+};
+
+// Map a float to an integer such that adjacent floats map to adjacent integers (with -0
+// and +0 one apart), so ULP distances are differences.
+inline int32_t float_ordinal(float x) {
+    int32_t i;
+    std::memcpy(&i, &x, sizeof(i));
+    return i ^ ((i >> 31) & 0x7fffffff);
+}
+
+// Distance of two floats in units in the last place (exact: it is below 2^32).
+inline uint32_t ulp_distance(float a, float b) {
+    const int32_t oa = float_ordinal(a), ob = float_ordinal(b);
+    return oa > ob ? static_cast<uint32_t>(oa) - static_cast<uint32_t>(ob)
+                   : static_cast<uint32_t>(ob) - static_cast<uint32_t>(oa);
+}
+
+// Bits of a nonnegative float, which order like the floats; 0 for NaN.
+inline uint32_t nonnegative_bits(float x) {
+    return float_bits(x) & (0u - static_cast<uint32_t>(x == x));
+}
+
+// Compare elements [begin, end). The statistics loop is written with bit masks and integer
+// max reductions so that it vectorizes (float max reductions and conditional divisions do
+// not without -ffast-math); the worst index and the histogram are found in separate passes.
+inline ComparisonStats compare_range(const float* calc, const float* expected, size_t begin, size_t end, Tolerance tol) {
+    ComparisonStats stats;
+    stats.count = end - begin;
+    if (begin == end) return stats;
+    uint32_t max_abs = 0, max_rel = 0, max_ulp = 0;
+    uint32_t mismatches = 0, nans = 0;  // per block, so the counters vectorize as 32-bit lanes
+    constexpr size_t BLOCK = size_t(1) << 20;
+    for (size_t block = begin; block < end; block += BLOCK) {
+        const size_t block_end = std::min(end, block + BLOCK);
+        mismatches = nans = 0;
+        for (size_t i = block; i < block_end; ++i) {
+            const float diff = std::fabs(calc[i] - expected[i]);
+            const float mag = std::fabs(expected[i]);
+            // !(a <= b) so that NaNs count as mismatches.
+            mismatches += !(diff <= tol.abs + tol.rel * mag);
+            nans += diff != diff;
+            max_abs = std::max(max_abs, nonnegative_bits(diff));
+            const float rel = diff / std::max(mag, std::numeric_limits<float>::denorm_min());
+            max_rel = std::max(max_rel, nonnegative_bits(rel) & (0u - static_cast<uint32_t>(mag > 0)));
+            max_ulp = std::max(max_ulp, ulp_distance(calc[i], expected[i]));
+        }
+        stats.mismatches += mismatches;
+        stats.nans += nans;
+    }
+    stats.max_abs = float_from_bits(max_abs);
+    stats.max_rel = float_from_bits(max_rel);
+    stats.max_ulp = max_ulp;
+    for (size_t i = begin; i < end; ++i) {
+        if (nonnegative_bits(std::fabs(calc[i] - expected[i])) == max_abs) {
+            stats.worst_idx = i;
+            break;
+        }
+    }
+    for (size_t i = begin; i < end; ++i) {
+        const uint32_t ulp = ulp_distance(calc[i], expected[i]);
+        ++stats.ulp_histogram[ulp == 0 ? 0 : 32 - __builtin_clz(ulp)];
+    }
+    return stats;
+}
+
+// Number of contiguous parts to split n items into for parallel processing: one per
+// hardware thread (at most 64), but at least min_per_part items each.
+inline size_t parallel_parts(size_t n, size_t min_per_part) {
+    const size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    return std::min<size_t>({hw, 64, std::max<size_t>(1, n / min_per_part)});
+}
+
+// Call fn(part, begin, end) for each of `parts` contiguous ranges of [0, n), one thread per
+// range (the calling thread takes part 0).
+template <typename F>
+inline void parallel_ranges(size_t parts, size_t n, F fn) {
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < parts; ++t) workers.emplace_back([&, t] { fn(t, n * t / parts, n * (t + 1) / parts); });
+    fn(0, 0, n / parts);
+    for (std::thread& w : workers) w.join();
+}
+
+// C = epilogue(product, init_C) elementwise for an I x J matrix, as a separate pass;
+// C may be init_C or product.
+inline void apply_epilogue(const Epilogue& e, const float* product, const float* init_C, float* C, int I, int J) {
+    const size_t rows_per_part = std::max<size_t>(1, (size_t(1) << 16) / J);
+    parallel_ranges(parallel_parts(I, rows_per_part), I, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const size_t row = i * J;
+            for (int j = 0; j < J; ++j) C[row + j] = e.apply(product[row + j], init_C[row + j], j);
+        }
+    });
+}
+
+// Compare n elements of calc against expected, split over threads for large tensors.
+inline ComparisonStats compare_tensors(const float* calc, const float* expected, size_t n, Tolerance tol) {
+    std::vector<ComparisonStats> parts(parallel_parts(n, size_t(1) << 18));
+    parallel_ranges(parts.size(), n, [&](size_t t, size_t begin, size_t end) {
+        parts[t] = compare_range(calc, expected, begin, end, tol);
+    });
+    ComparisonStats stats;
+    for (const ComparisonStats& part : parts) stats.merge(part);
+    return stats;
+}
+
+// Write the statistics (and the worst element if the comparison failed) as text lines.
+inline void write_comparison(std::ostream& os, const ComparisonStats& stats, const float* calc,
+                             const float* expected, const std::vector<int>& dims, Tolerance tol) {
+    os << "Tolerance: abs = " << tol.abs << ", rel = " << tol.rel << "\n";
+    os << "Max abs error: " << stats.max_abs << "\n";
+    os << "Max rel error: " << stats.max_rel << "\n";
+    os << "Max ULP error: " << stats.max_ulp << "\n";
+    if (stats.nans) os << "NaN elements: " << stats.nans << "\n";
+    if (stats.worst_idx != static_cast<size_t>(-1)) {
+        std::vector<int> idx = linear_to_index(stats.worst_idx, dims);
+        os << "Max abs error at index ";
+        for (size_t i = 0; i < idx.size(); ++i) os << (i ? "," : "") << idx[i];
+        os << ": calc = " << calc[stats.worst_idx] << ", expected = " << expected[stats.worst_idx] << "\n";
+    }
+    os << "ULP error histogram (bucket: elements):\n";
+    for (int b = 0; b < ULP_HISTOGRAM_BUCKETS; ++b) {
+        if (stats.ulp_histogram[b] == 0) continue;
+        if (b == 0) os << "  0: ";
+        else if (b == 1) os << "  1: ";
+        else os << "  " << (uint64_t(1) << (b - 1)) << "-" << ((uint64_t(1) << b) - 1) << ": ";
+        os << stats.ulp_histogram[b] << "\n";
+    }
+}
+
+// Result of a Freivalds check; see freivalds_check().
+struct FreivaldsStats {
+    int probes = 0;
+    int failed_probes = 0;
+    double max_ratio = 0;  // max |(C r)_i - (A (B r))_i| / tolerance bound of row i
+    size_t worst_row = 0;
+    double resolution = 0;  // max over rows of the row bound / the row's largest element tolerance
+    uint64_t seed = 0;
+
+    bool passed() const { return failed_probes == 0; }
+};
+
+// First random stream of the Freivalds probe vectors (the data generator uses 0 and 1).
+constexpr uint32_t FREIVALDS_STREAM = 0x100;
+
+// Hoeffding bound multiplier of the Freivalds check: a row within the elementwise
+// tolerance fails with probability at most 2 exp(-t^2 / 2) (about 2.5e-14 for t = 8).
+#ifndef FREIVALDS_HOEFFDING_T
+#define FREIVALDS_HOEFFDING_T 8.0
+#endif
+
+// Probabilistic check that C = A * B in O(IK + KJ + IJ) per probe instead of comparing
+// against a gold C: for a random vector r with entries in [-1, 1), C r must match A (B r),
+// computed in double. If every element of C is within its tolerance t_ij = abs + rel *
+// |C_ij| (what compare_tensors() accepts), row i deviates by sum_j e_ij r_j with |e_ij| <=
+// t_ij. That is at most sum_j t_ij |r_j|, and since r is drawn independently of the errors,
+// by Hoeffding's inequality also at most FREIVALDS_HOEFFDING_T * sqrt(sum_j t_ij^2) except
+// with negligible probability; the row bound is the smaller of the two. Errors much larger
+// than the bound (wrong tiles, indices, or reductions) fail a probe unless they cancel
+// against the random weights, which has probability ~0; each further probe is independent.
+// The bound grows with the row, though: a single wrong element e_ij is only caught once
+// |e_ij r_j| exceeds it, so errors of up to about FREIVALDS_HOEFFDING_T * sqrt(J) element
+// tolerances go unnoticed (the bound over the row's largest t_ij, reported as resolution;
+// more where |r_j| is small). That is the noise floor of J errors within tolerance, which
+// no multiplier or probe count removes, so accuracy studies need the elementwise comparison
+// against the gold output. A linear epilogue (no activation) is checked the same way:
+// C r must match alpha A (B r) + beta C_init r + bias . r.
+inline FreivaldsStats freivalds_check(const float* A, const float* B, const float* C, int I, int J, int K,
+                                      Tolerance tol, int probes, uint64_t seed, const float* init_C = nullptr,
+                                      const Epilogue& epilogue = Epilogue{}) {
+    FreivaldsStats stats;
+    stats.probes = probes;
+    stats.seed = seed;
+    std::vector<float> u(J);
+    std::vector<double> r(J), x(K), y(I), z(I), bound(I), resolution(I);
+    constexpr size_t ROWS_PER_PART = 64;
+    for (int p = 0; p < probes; ++p) {
+        fill_uniform(u.data(), J, seed, FREIVALDS_STREAM + static_cast<uint32_t>(p));
+        for (int j = 0; j < J; ++j) r[j] = 2.0 * u[j] - 1.0;
+        double bias_r = 0;
+        if (epilogue.bias) {
+            for (int j = 0; j < J; ++j) bias_r += epilogue.bias[j] * r[j];
+        }
+
+        parallel_ranges(parallel_parts(K, ROWS_PER_PART), K, [&](size_t, size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                const float* row = B + k * J;
+                double sum = 0;
+                for (int j = 0; j < J; ++j) sum += row[j] * r[j];
+                x[k] = sum;
+            }
+        });
+        parallel_ranges(parallel_parts(I, ROWS_PER_PART), I, [&](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const float* a_row = A + i * K;
+                const float* c_row = C + i * J;
+                double ax = 0, cr = 0, c0r = 0, b_abs = 0, b_sq = 0, t_max = 0;
+                for (int k = 0; k < K; ++k) ax += a_row[k] * x[k];
+                if (epilogue.beta != 0.0f) {
+                    const float* c0_row = init_C + i * J;
+                    for (int j = 0; j < J; ++j) c0r += c0_row[j] * r[j];
+                }
+                for (int j = 0; j < J; ++j) {
+                    const double t = tol.abs + tol.rel * std::fabs(static_cast<double>(c_row[j]));
+                    cr += c_row[j] * r[j];
+                    b_abs += t * std::fabs(r[j]);
+                    b_sq += t * t;
+                    t_max = std::max(t_max, t);
+                }
+                y[i] = epilogue.alpha * ax + epilogue.beta * c0r + bias_r;
+                z[i] = cr;
+                bound[i] = std::min(b_abs, FREIVALDS_HOEFFDING_T * std::sqrt(b_sq));
+                resolution[i] = t_max > 0 ? bound[i] / t_max : 0;
+            }
+        });
+
+        bool failed = false;
+        for (int i = 0; i < I; ++i) {
+            const double residual = std::fabs(z[i] - y[i]);
+            double ratio = bound[i] > 0 ? residual / bound[i] : (residual > 0 ? HUGE_VAL : 0);
+            if (ratio != ratio) ratio = HUGE_VAL;  // NaN in C
+            failed = failed || ratio > 1;
+            stats.resolution = std::max(stats.resolution, resolution[i]);
+            if (ratio > stats.max_ratio) {
+                stats.max_ratio = ratio;
+                stats.worst_row = i;
+            }
+        }
+        stats.failed_probes += failed;
+    }
+    return stats;
+}
+
 // Compare two tensors for elementwise closeness. Returns true if all elements within eps.
 // worst_idx receives the linear index of the worst mismatch.
+inline bool compare_matrices(
+    const float* a, const float* b,
+    const std::vector<int>& dims,
+    int& num_mismatches, float& max_diff, size_t& worst_idx,
+    float eps = EPSILON
+) {
+    const ComparisonStats stats = compare_tensors(a, b, total_size(dims), Tolerance{eps, 0});
+    num_mismatches = static_cast<int>(std::min<size_t>(stats.mismatches, std::numeric_limits<int>::max()));
+    max_diff = stats.passed() ? 0 : stats.max_abs;
+    worst_idx = stats.passed() ? static_cast<size_t>(-1) : stats.worst_idx;
+    return stats.passed();
+}
+
 inline bool compare_matrices(
     const std::vector<float>& a, const std::vector<float>& b,
     const std::vector<int>& dims,
@@ -108,20 +1274,53 @@ inline bool compare_matrices(
     num_mismatches = 0;
     max_diff = 0;
     worst_idx = static_cast<size_t>(-1);
-
     if (a.size() != n || b.size() != n) return false;
+    return compare_matrices(a.data(), b.data(), dims, num_mismatches, max_diff, worst_idx, eps);
+}
 
-    for (size_t i = 0; i < n; ++i) {
-        float diff = std::fabs(a[i] - b[i]);
-        if (diff > eps) {
-            ++num_mismatches;
-            if (diff > max_diff) {
-                max_diff = diff;
-                worst_idx = i;
-            }
-        }
+// Floating-point operations of C += A * B with A: I x K and B: K x J (one multiply and
+// one add per inner-product term).
+inline double matmul_flops(int I, int J, int K) {
+    return 2.0 * I * J * K;
+}
+
+// Compulsory memory traffic of one matmul: A and B (operand_bytes per element) read once,
+// float C read and written once. Caches make the real traffic of a good kernel approach
+// this, so flops / bytes is the arithmetic intensity used to place a run on the roofline.
+inline double matmul_min_bytes(int I, int J, int K, size_t operand_bytes = sizeof(float)) {
+    return operand_bytes * (static_cast<double>(I) * K + static_cast<double>(K) * J) + sizeof(float) * 2.0 * I * J;
+}
+
+// Write throughput metrics of eval runs that each perform flops operations and move at
+// least bytes next to runtimes: gflops (one value per run, in the order of runtimes) and
+// metrics (flops, min_bytes, and arithmetic_intensity as key=value lines), and print
+// achieved GFLOP/s. Runtimes from different input sizes and devices are comparable in
+// GFLOP/s, where raw nanoseconds are not.
+inline bool write_throughput_metrics(const std::vector<int64_t>& runtimes_ns, double flops, double bytes) {
+    std::ofstream ofs_gflops("gflops");
+    double best = 0, sum_ns = 0;
+    for (int64_t t : runtimes_ns) {
+        const double gflops = t > 0 ? flops / static_cast<double>(t) : 0;
+        ofs_gflops << gflops << "\n";
+        best = std::max(best, gflops);
+        sum_ns += static_cast<double>(t);
     }
-    return num_mismatches == 0;
+    std::ofstream ofs_metrics("metrics");
+    ofs_metrics << std::setprecision(std::numeric_limits<double>::max_digits10);
+    ofs_metrics << "flops=" << flops << "\n";
+    ofs_metrics << "min_bytes=" << bytes << "\n";
+    ofs_metrics << "arithmetic_intensity=" << flops / bytes << "\n";
+
+    const double avg = sum_ns > 0 ? flops * runtimes_ns.size() / sum_ns : 0;
+    std::cout << "GFLOP/s: avg = " << avg << ", max = " << best
+              << " (arithmetic intensity " << flops / bytes << " flop/byte)" << std::endl;
+    return ofs_gflops.good() && ofs_metrics.good();
+}
+
+// Throughput metrics of I x K by K x J matmul runs.
+inline bool write_matmul_metrics(const std::vector<int64_t>& runtimes_ns, int I, int J, int K,
+                                 size_t operand_bytes = sizeof(float)) {
+    return write_throughput_metrics(runtimes_ns, matmul_flops(I, J, K), matmul_min_bytes(I, J, K, operand_bytes));
 }
 
 #endif /* DATA_HELPER_H */
@@ -1,70 +1,343 @@
 #include "data_helper.h"
+#include "matmul_gold.h"
+#include <algorithm>
 #include <iostream>
 #include <random>
+#include <sstream>
+#include <cstdio>
 #include <cstdlib>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-void matmul_gold(
-    const std::vector<float>& A, // I x K
-    const std::vector<float>& B, // K x J
-    std::vector<float>& C,       // I x J, output
-    int I, int J, int K
+// Fill a rows x cols matrix with random values from the given stream and write it panel
+// by panel, keeping at most panel_rows rows in memory. Each element's value depends only
+// on its linear index, so the output does not depend on the panel size.
+bool write_random_matrix(
+    const std::string& filename, int rows, int cols, TensorFormat format,
+    size_t panel_rows, uint64_t seed, uint32_t stream
 ) {
-    for (int i = 0; i < I; ++i) {
-        for (int j = 0; j < J; ++j) {
-            float sum = 0.0f;
-            for (int k = 0; k < K; ++k) {
-                sum += A[i * K + k] * B[k * J + j];
-            }
-            C[i * J + j] = sum;
+    TensorWriter writer;
+    if (!writer.open(filename, {rows, cols}, format)) return false;
+    std::vector<float> panel(std::min(panel_rows, static_cast<size_t>(rows)) * cols);
+    for (size_t r = 0; r < static_cast<size_t>(rows); r += panel_rows) {
+        const size_t count = std::min(panel_rows, rows - r) * cols;
+        fill_uniform(panel.data(), count, seed, stream, r * cols);
+        if (!writer.append(panel.data(), count)) return false;
+    }
+    return writer.close();
+}
+
+// Write a rows x cols matrix of zeros panel by panel.
+bool write_zero_matrix(const std::string& filename, int rows, int cols, TensorFormat format, size_t panel_rows) {
+    TensorWriter writer;
+    if (!writer.open(filename, {rows, cols}, format)) return false;
+    std::vector<float> panel(std::min(panel_rows, static_cast<size_t>(rows)) * cols, 0.0f);
+    for (size_t r = 0; r < static_cast<size_t>(rows); r += panel_rows) {
+        if (!writer.append(panel.data(), std::min(panel_rows, rows - r) * cols)) return false;
+    }
+    return writer.close();
+}
+
+// Write the rows x cols row-major matrix M in another layout, one piece of the layout's
+// payload order at a time: column panels for column-major, tile rows for blocked. A piece
+// holds about budget_bytes (0: the whole matrix).
+bool write_matrix_layout(
+    const std::string& filename, const float* M, int rows, int cols, const TensorLayout& layout,
+    TensorFormat format, size_t budget_bytes
+) {
+    TensorWriter writer;
+    if (!writer.open(filename, {rows, cols}, format, TENSOR_DEFAULT_ALIGNMENT, layout)) return false;
+    const size_t total = layout_elements(layout, rows, cols);
+    const size_t budget = budget_bytes > 0 ? std::min(budget_bytes / sizeof(float), total) : total;
+    std::vector<float> piece;
+    if (layout.kind == LayoutKind::ColMajor) {
+        const int step = static_cast<int>(std::max<size_t>(budget / rows, 1));
+        for (int c = 0; c < cols; c += step) {
+            const int width = std::min(step, cols - c);
+            piece.resize(static_cast<size_t>(width) * rows);
+            to_layout(M + c, rows, width, cols, layout, piece.data());
+            if (!writer.append(piece.data(), piece.size())) return false;
+        }
+    } else {
+        // Tile rows of the whole matrix are tile rows of a matrix of their rows.
+        const int unit = layout.kind == LayoutKind::Blocked ? layout.block_rows : 1;
+        const size_t unit_elements = layout_elements(layout, std::min(unit, rows), cols);
+        const int step = unit * static_cast<int>(std::max<size_t>(budget / unit_elements, 1));
+        for (int r = 0; r < rows; r += step) {
+            const int height = std::min(step, rows - r);
+            piece.resize(layout_elements(layout, height, cols));
+            to_layout(M + static_cast<size_t>(r) * cols, height, cols, cols, layout, piece.data());
+            if (!writer.append(piece.data(), piece.size())) return false;
+        }
+    }
+    return writer.close();
+}
+
+// Rows per panel (at most rows) such that a panel of row_bytes per row fits in budget_bytes,
+// rounded down to a multiple of GOLD_TILE_I where possible so that gold tiles stay full.
+size_t panel_rows_for(size_t budget_bytes, size_t row_bytes, int rows) {
+    size_t panel = budget_bytes / row_bytes;
+    if (panel >= GOLD_TILE_I) panel -= panel % GOLD_TILE_I;
+    return std::min(std::max<size_t>(panel, 1), static_cast<size_t>(rows));
+}
+
+// Streaming generation: A, B, and initial C are written in row panels, then (with gold)
+// the expected C is computed panel by panel from memory-mapped A and B. Every C panel reads
+// all of B, so B stays resident for the whole pass and is reserved from the budget; the rest
+// holds one panel: its rows of A, C, and (beta != 0) the initial C.
+// Produces the same files as the in-memory path for the same seed.
+int generate_streaming(
+    int I, int J, int K, TensorFormat format, size_t budget_bytes, uint64_t seed, bool gold,
+    const Epilogue& epilogue, const std::string& file_A, const std::string& file_B,
+    const std::string& file_init_C, const std::string& file_C
+) {
+    const size_t B_bytes = static_cast<size_t>(K) * J * sizeof(float);
+    const size_t C_row_bytes = (static_cast<size_t>(K) + (epilogue.beta != 0.0f ? 2 : 1) * J) * sizeof(float);
+    if (gold && budget_bytes < B_bytes + C_row_bytes) {
+        std::cerr << "Computing the expected C needs B (" << (B_bytes >> 20) << " MiB) and a row panel within the "
+                  << (budget_bytes >> 20) << " MiB budget" << std::endl;
+        return 1;
+    }
+    const size_t panel_rows = gold ? panel_rows_for(budget_bytes - B_bytes, C_row_bytes, I)
+                                   : panel_rows_for(budget_bytes, J * sizeof(float), I);
+    std::cout << "Streamed in panels of " << panel_rows << " row(s) of C (memory budget "
+              << (budget_bytes >> 20) << " MiB)\n";
+
+    if (!write_random_matrix(file_A, I, K, format, panel_rows_for(budget_bytes, K * sizeof(float), I), seed,
+                             STREAM_A)) {
+        std::cerr << "Failed to write " << file_A << std::endl;
+        return 2;
+    }
+    if (!write_random_matrix(file_B, K, J, format, panel_rows_for(budget_bytes, J * sizeof(float), K), seed,
+                             STREAM_B)) {
+        std::cerr << "Failed to write " << file_B << std::endl;
+        return 2;
+    }
+    if (!(epilogue.beta != 0.0f ? write_random_matrix(file_init_C, I, J, format, panel_rows, seed, STREAM_C)
+                                : write_zero_matrix(file_init_C, I, J, format, panel_rows))) {
+        std::cerr << "Failed to write " << file_init_C << std::endl;
+        return 2;
+    }
+    if (!gold) return 0;
+
+    TensorView A, B;
+    if (!A.map_binary(file_A, false) || !B.map_binary(file_B, false)) {
+        std::cerr << "Failed to map " << file_A << " and " << file_B << std::endl;
+        return 2;
+    }
+    std::vector<float> C_panel(panel_rows * J);
+    std::vector<float> init_panel(epilogue.beta != 0.0f ? C_panel.size() : 0);
+    TensorWriter writer;
+    bool ok = writer.open(file_C, {I, J}, format);
+    for (size_t i = 0; ok && i < static_cast<size_t>(I); i += panel_rows) {
+        const size_t rows = std::min(panel_rows, I - i);
+        matmul_gold(A.data() + i * K, B.data(), C_panel.data(), static_cast<int>(rows), J, K);
+        if (!epilogue.identity()) {
+            // The initial C panel is regenerated from its stream rather than read back.
+            if (!init_panel.empty()) fill_uniform(init_panel.data(), rows * J, seed, STREAM_C, i * J);
+            const float* init = init_panel.empty() ? C_panel.data() : init_panel.data();
+            apply_epilogue(epilogue, C_panel.data(), init, C_panel.data(), static_cast<int>(rows), J);
         }
+        ok = writer.append(C_panel.data(), rows * J);
+    }
+    if (!(ok && writer.close())) {
+        std::cerr << "Failed to write " << file_C << std::endl;
+        return 2;
     }
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
     if (argc < 4) {
-        std::cerr << "Usage: " << argv[0] << " I J K" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " I J K [txt|bin] [memory_budget_MiB] [seed|random] [gold|nogold] "
+                  << "[B_layouts|none] [epilogue|none]" << std::endl;
         return 1;
     }
     int I = std::atoi(argv[1]);
     int J = std::atoi(argv[2]);
     int K = std::atoi(argv[3]);
+    if (I <= 0 || J <= 0 || K <= 0) {
+        std::cerr << "I, J, K must be positive" << std::endl;
+        return 1;
+    }
 
-    std::vector<float> A(I * K);
-    std::vector<float> B(K * J);
-    std::vector<float> C(I * J, 0.0f);
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    // Output format; file extensions follow the format name (e.g. input_A.bin).
+    std::string ext = argc > 4 ? argv[4] : "txt";
+    TensorFormat format;
+    if (!parse_tensor_format(ext, format)) {
+        std::cerr << "Unknown format '" << ext << "' (expected txt or bin)" << std::endl;
+        return 1;
+    }
+    const std::string file_A = "input_A." + ext;
+    const std::string file_B = "input_B." + ext;
+    const std::string file_init_C = "input_C." + ext;
+    const std::string file_C = "output_C." + ext;
 
-    for (auto& a : A) a = dist(gen);
-    for (auto& b : B) b = dist(gen);
+    // Seed of the input values (default: random). The same seed reproduces the same A and B
+    // regardless of thread count and memory budget.
+    uint64_t seed;
+    const std::string seed_arg = argc > 6 ? argv[6] : "random";
+    if (seed_arg == "random") {
+        std::random_device rd;
+        seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+    } else {
+        char* end = nullptr;
+        seed = std::strtoull(seed_arg.c_str(), &end, 0);
+        if (seed_arg.empty() || *end != '\0') {
+            std::cerr << "Invalid seed '" << seed_arg << "' (expected an integer or random)" << std::endl;
+            return 1;
+        }
+    }
 
-    std::vector<float> initial_C(I * J, 0.0f);
-    if (!write_matrix("input_C.txt", initial_C, {I, J})) {
-        std::cerr << "Failed to write input_C.txt" << std::endl;
-        return 2;
+    // With nogold, the expected C is neither computed nor written; experiments then verify
+    // their result with Freivalds probes (see freivalds_check() in data_helper.h).
+    const std::string gold_arg = argc > 7 ? argv[7] : "gold";
+    if (gold_arg != "gold" && gold_arg != "nogold") {
+        std::cerr << "Invalid gold option '" << gold_arg << "' (expected gold or nogold)" << std::endl;
+        return 1;
     }
+    const bool gold = gold_arg == "gold";
 
-    matmul_gold(A, B, C, I, J, K);
+    // Further copies of B in other layouts (comma-separated, e.g. colmajor,blocked_256x16)
+    // for competitors that read B pre-transposed or pre-packed, as input_B.<layout>.<ext>.
+    std::vector<TensorLayout> B_layouts;
+    const std::string layouts_arg = argc > 8 ? argv[8] : "none";
+    if (layouts_arg != "none") {
+        std::stringstream ss(layouts_arg);
+        std::string name;
+        while (std::getline(ss, name, ',')) {
+            TensorLayout layout;
+            if (name.empty()) continue;
+            if (!parse_layout(name, layout)) {
+                std::cerr << "Invalid B layout '" << name << "' (expected rowmajor, colmajor, or blocked_<rows>x<cols>)"
+                          << std::endl;
+                return 1;
+            }
+            if (!layout.row_major()) B_layouts.push_back(layout);
+        }
+    }
 
-    if (!write_matrix("input_A.txt", A, {I, K})) {
-        std::cerr << "Failed to write input_A.txt" << std::endl;
-        return 2;
+    // Epilogue of the expected C (see Epilogue in data_helper.h), e.g. alpha=1,beta=1,bias,gelu.
+    // With beta != 0 the initial C is random instead of zero; with bias, the J bias values
+    // are written as a 1 x J input_bias.<ext>. They are uniform in [-alpha K / 2, 0), around
+    // the mean alpha K / 4 of the products, so that an activation sees both signs.
+    Epilogue epilogue;
+    bool with_bias = false;
+    const std::string epilogue_arg = argc > 9 ? argv[9] : "none";
+    if (!parse_epilogue(epilogue_arg, epilogue, with_bias)) {
+        std::cerr << "Invalid epilogue '" << epilogue_arg << "' (expected none or e.g. alpha=1,beta=1,bias,gelu)"
+                  << std::endl;
+        return 1;
     }
-    if (!write_matrix("input_B.txt", B, {K, J})) {
-        std::cerr << "Failed to write input_B.txt" << std::endl;
-        return 2;
+    const std::string file_bias = "input_bias." + ext;
+    std::vector<float> bias;
+    if (with_bias) {
+        bias.resize(J);
+        fill_uniform(bias.data(), J, seed, STREAM_BIAS);
+        for (float& b : bias) b *= -0.5f * epilogue.alpha * K;
+        epilogue.bias = bias.data();
+        if (!write_matrix(file_bias, bias, {1, J}, format)) {
+            std::cerr << "Failed to write " << file_bias << std::endl;
+            return 2;
+        }
+    } else {
+        std::remove(file_bias.c_str());
     }
-    if (!write_matrix("output_C.txt", C, {I, J})) {
-        std::cerr << "Failed to write output_C.txt" << std::endl;
-        return 2;
+
+    // A stale expected C from an earlier generation must not be used for this data.
+    if (!gold) std::remove(file_C.c_str());
+
+    // Memory budget in MiB (0 = unlimited). Generation streams if A, B, C, and initial C
+    // together do not fit.
+    const size_t budget_bytes = static_cast<size_t>(argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 0) << 20;
+    const size_t size_A = static_cast<size_t>(I) * K;
+    const size_t size_B = static_cast<size_t>(K) * J;
+    const size_t size_C = static_cast<size_t>(I) * J;
+    const size_t in_memory_bytes = (size_A + size_B + (gold ? 2 : 1) * size_C) * sizeof(float);
+
+    if (budget_bytes > 0 && in_memory_bytes > budget_bytes) {
+        if (format != TensorFormat::Binary) {
+            std::cerr << "Generating " << (in_memory_bytes >> 20) << " MiB within a " << (budget_bytes >> 20)
+                      << " MiB budget requires the bin format" << std::endl;
+            return 1;
+        }
+        int status = generate_streaming(I, J, K, format, budget_bytes, seed, gold, epilogue, file_A, file_B, file_init_C,
+                                        file_C);
+        if (status != 0) return status;
+    } else {
+        std::vector<float> A(size_A);
+        std::vector<float> B(size_B);
+
+        fill_uniform(A.data(), size_A, seed, STREAM_A);
+        fill_uniform(B.data(), size_B, seed, STREAM_B);
+
+        std::vector<float> initial_C(size_C, 0.0f);
+        if (epilogue.beta != 0.0f) fill_uniform(initial_C.data(), size_C, seed, STREAM_C);
+        if (!write_matrix(file_init_C, initial_C, {I, J}, format)) {
+            std::cerr << "Failed to write " << file_init_C << std::endl;
+            return 2;
+        }
+
+        if (!write_matrix(file_A, A, {I, K}, format)) {
+            std::cerr << "Failed to write " << file_A << std::endl;
+            return 2;
+        }
+        if (!write_matrix(file_B, B, {K, J}, format)) {
+            std::cerr << "Failed to write " << file_B << std::endl;
+            return 2;
+        }
+        if (gold) {
+            std::vector<float> C(size_C, 0.0f);
+            matmul_gold(A.data(), B.data(), C.data(), I, J, K);
+            if (!epilogue.identity()) apply_epilogue(epilogue, C.data(), initial_C.data(), C.data(), I, J);
+            if (!write_matrix(file_C, C, {I, J}, format)) {
+                std::cerr << "Failed to write " << file_C << std::endl;
+                return 2;
+            }
+        }
     }
+#ifdef _OPENMP
+    if (gold) std::cout << "Computed expected C using " << omp_get_max_threads() << " thread(s)\n";
+#endif
+
+    std::cout << "Seed: " << seed << "\n";
+    std::cout << "Wrote A (" << I << "x" << K << ") to " << file_A << "\n";
+    std::cout << "Wrote B (" << K << "x" << J << ") to " << file_B << "\n";
+    std::cout << "Wrote initial C (" << I << "x" << J << ") to " << file_init_C << "\n";
+    if (with_bias) std::cout << "Wrote bias (1x" << J << ") to " << file_bias << "\n";
+    if (!epilogue.identity()) std::cout << "Epilogue: " << epilogue_name(epilogue) << "\n";
+    if (gold) std::cout << "Wrote expected C (" << I << "x" << J << ") to " << file_C << "\n";
+    else std::cout << "Skipped expected C (experiments verify with Freivalds probes)\n";
 
-    std::cout << "Wrote A (" << I << "x" << K << ") to input_A.txt\n";
-    std::cout << "Wrote B (" << K << "x" << J << ") to input_B.txt\n";
-    std::cout << "Wrote initial C (" << I << "x" << J << ") to input_C.txt\n";
-    std::cout << "Wrote expected C (" << I << "x" << J << ") to output_C.txt\n";
+    if (!B_layouts.empty()) {
+        // B was written row-major above; map or read it back rather than keeping it around.
+        std::vector<float> B_values;
+        std::vector<int> B_dims;
+        TensorView B_view;
+        const float* B_data;
+        if (format == TensorFormat::Binary) {
+            if (!B_view.map_binary(file_B, false)) {
+                std::cerr << "Failed to map " << file_B << std::endl;
+                return 2;
+            }
+            B_data = B_view.data();
+        } else {
+            if (!read_matrix(file_B, B_values, B_dims)) {
+                std::cerr << "Failed to read " << file_B << std::endl;
+                return 2;
+            }
+            B_data = B_values.data();
+        }
+        for (const TensorLayout& layout : B_layouts) {
+            const std::string file = "input_B." + layout_name(layout) + "." + ext;
+            if (!write_matrix_layout(file, B_data, K, J, layout, format, budget_bytes)) {
+                std::cerr << "Failed to write " << file << std::endl;
+                return 2;
+            }
+            std::cout << "Wrote B (" << K << "x" << J << ", " << layout_name(layout) << ") to " << file << "\n";
+        }
+    }
 
     return 0;
 }
@@ -0,0 +1,78 @@
+#ifndef MATMUL_GOLD_H
+#define MATMUL_GOLD_H
+
+// Gold matmul and random streams shared by the data generators.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#ifndef GOLD_TILE_I
+#define GOLD_TILE_I 32
+#endif
+
+#ifndef GOLD_TILE_J
+#define GOLD_TILE_J 128
+#endif
+
+#ifndef GOLD_TILE_K
+#define GOLD_TILE_K 256
+#endif
+
+// Accumulator type for the gold reduction (e.g. -DGOLD_ACCUMULATOR=double).
+#ifndef GOLD_ACCUMULATOR
+#define GOLD_ACCUMULATOR float
+#endif
+
+// Blocked, multithreaded gold matmul. Threads own disjoint C tiles and every element is
+// reduced over k in ascending order, so the result does not depend on the thread count
+// or tile sizes. Built with -ffp-contract=off, it is bit-identical to the naive i-j-k loop
+// (for a float accumulator) on any ISA the j loop is vectorized for.
+inline void matmul_gold(
+    const float* A, // I x K
+    const float* B, // K x J
+    float* C,       // I x J, output
+    int I, int J, int K
+) {
+    using acc_t = GOLD_ACCUMULATOR;
+    const int tiles_i = (I + GOLD_TILE_I - 1) / GOLD_TILE_I;
+    const int tiles_j = (J + GOLD_TILE_J - 1) / GOLD_TILE_J;
+
+    #pragma omp parallel for collapse(2) schedule(dynamic)
+    for (int ti = 0; ti < tiles_i; ++ti) {
+        for (int tj = 0; tj < tiles_j; ++tj) {
+            const int ii = ti * GOLD_TILE_I, i_max = std::min(ii + GOLD_TILE_I, I);
+            const int jj = tj * GOLD_TILE_J, j_max = std::min(jj + GOLD_TILE_J, J);
+            const int width = j_max - jj;
+            acc_t acc[GOLD_TILE_I][GOLD_TILE_J] = {};
+
+            for (int kk = 0; kk < K; kk += GOLD_TILE_K) {
+                const int k_max = std::min(kk + GOLD_TILE_K, K);
+                for (int i = ii; i < i_max; ++i) {
+                    acc_t* acc_row = acc[i - ii];
+                    for (int k = kk; k < k_max; ++k) {
+                        const acc_t a = A[static_cast<size_t>(i) * K + k];
+                        const float* b_row = &B[static_cast<size_t>(k) * J + jj];
+                        #pragma omp simd
+                        for (int j = 0; j < width; ++j) {
+                            acc_row[j] += a * static_cast<acc_t>(b_row[j]);
+                        }
+                    }
+                }
+            }
+
+            for (int i = ii; i < i_max; ++i) {
+                float* c_row = &C[static_cast<size_t>(i) * J + jj];
+                for (int j = 0; j < width; ++j) c_row[j] = static_cast<float>(acc[i - ii][j]);
+            }
+        }
+    }
+}
+
+// Random streams of the inputs; see fill_uniform() in data_helper.h.
+constexpr uint32_t STREAM_A = 0;
+constexpr uint32_t STREAM_B = 1;
+constexpr uint32_t STREAM_C = 3;     // initial C, for epilogues with beta != 0
+constexpr uint32_t STREAM_BIAS = 4;  // bias row of the epilogue
+
+#endif /* MATMUL_GOLD_H */
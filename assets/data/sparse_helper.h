@@ -0,0 +1,287 @@
+#ifndef SPARSE_HELPER_H
+#define SPARSE_HELPER_H
+
+// Sparse matrices for the SpMM routine: block compressed sparse rows (BSR), with CSR as
+// the special case of 1x1 blocks, and their text and binary files.
+
+#include "data_helper.h"
+
+// Random stream of the sparsity pattern; see fill_uniform() (A and B use streams 0 and 1).
+constexpr uint32_t STREAM_PATTERN = 2;
+
+// A rows x cols matrix stored as block_rows x block_cols blocks, which must tile it. Block
+// row r holds the blocks row_ptr[r] .. row_ptr[r + 1] - 1, in ascending block column
+// col_idx[b] (in units of blocks); values holds every stored block row-major, back to back.
+// Stored blocks may contain zeros (the fill of a BSR matrix).
+struct SparseMatrix {
+    int rows = 0, cols = 0;
+    int block_rows = 1, block_cols = 1;
+    std::vector<int64_t> row_ptr;
+    std::vector<int32_t> col_idx;
+    std::vector<float> values;
+
+    bool csr() const { return block_rows == 1 && block_cols == 1; }
+    int block_row_count() const { return rows / block_rows; }
+    size_t blocks() const { return col_idx.size(); }
+    size_t block_elements() const { return static_cast<size_t>(block_rows) * block_cols; }
+};
+
+// Non-owning view of a SparseMatrix, e.g. of copies in an Arena.
+struct SparseView {
+    int rows, cols;
+    int block_rows, block_cols;
+    size_t blocks;
+    const int64_t* row_ptr;  // rows / block_rows + 1 entries
+    const int32_t* col_idx;  // blocks entries
+    const float* values;     // blocks * block_rows * block_cols entries
+
+    bool csr() const { return block_rows == 1 && block_cols == 1; }
+    int block_row_count() const { return rows / block_rows; }
+};
+
+inline SparseView sparse_view(const SparseMatrix& m) {
+    return SparseView{m.rows, m.cols, m.block_rows, m.block_cols, m.blocks(),
+                      m.row_ptr.data(), m.col_idx.data(), m.values.data()};
+}
+
+// "csr" or "bsr_<rows>x<cols>".
+inline std::string sparse_format_name(int block_rows, int block_cols) {
+    if (block_rows == 1 && block_cols == 1) return "csr";
+    return "bsr_" + std::to_string(block_rows) + "x" + std::to_string(block_cols);
+}
+
+// Parse a block size "<rows>x<cols>" (both positive).
+inline bool parse_block_size(const std::string& name, int& block_rows, int& block_cols) {
+    char x = 0;
+    char rest = 0;
+    return std::sscanf(name.c_str(), "%d%c%d%c", &block_rows, &x, &block_cols, &rest) == 3 && x == 'x' &&
+           block_rows > 0 && block_cols > 0;
+}
+
+// Number of nonzero values (the fill of stored blocks not counted).
+inline size_t sparse_nonzeros(const SparseView& m) {
+    const size_t n = m.blocks * static_cast<size_t>(m.block_rows) * m.block_cols;
+    size_t nonzeros = 0;
+    for (size_t i = 0; i < n; ++i) nonzeros += m.values[i] != 0.0f;
+    return nonzeros;
+}
+
+// Largest number of stored values in one row: the number of terms of the longest dot
+// product of a sparse-times-dense product, which sets its rounding error.
+inline int sparse_max_row_terms(const SparseView& m) {
+    int64_t longest = 0;
+    for (int r = 0; r < m.block_row_count(); ++r) longest = std::max(longest, m.row_ptr[r + 1] - m.row_ptr[r]);
+    return static_cast<int>(longest * m.block_cols);
+}
+
+// Compress a dense row-major rows x cols matrix into blocks of the given size; every block
+// with a nonzero value is stored. Fails if the blocks do not tile the matrix.
+inline bool to_sparse(const float* dense, int rows, int cols, int block_rows, int block_cols, SparseMatrix& m) {
+    if (rows <= 0 || cols <= 0 || block_rows <= 0 || block_cols <= 0 || rows % block_rows != 0 ||
+        cols % block_cols != 0) {
+        return false;
+    }
+    m = SparseMatrix{};
+    m.rows = rows;
+    m.cols = cols;
+    m.block_rows = block_rows;
+    m.block_cols = block_cols;
+    m.row_ptr.assign(1, 0);
+    for (int br = 0; br < rows / block_rows; ++br) {
+        for (int bc = 0; bc < cols / block_cols; ++bc) {
+            const float* block = dense + static_cast<size_t>(br) * block_rows * cols + static_cast<size_t>(bc) * block_cols;
+            bool nonzero = false;
+            for (int r = 0; r < block_rows && !nonzero; ++r) {
+                for (int c = 0; c < block_cols; ++c) nonzero |= block[static_cast<size_t>(r) * cols + c] != 0.0f;
+            }
+            if (!nonzero) continue;
+            m.col_idx.push_back(bc);
+            for (int r = 0; r < block_rows; ++r) {
+                m.values.insert(m.values.end(), block + static_cast<size_t>(r) * cols,
+                                block + static_cast<size_t>(r) * cols + block_cols);
+            }
+        }
+        m.row_ptr.push_back(static_cast<int64_t>(m.col_idx.size()));
+    }
+    return true;
+}
+
+// Expand into a dense row-major rows x cols matrix.
+inline void to_dense(const SparseView& m, float* dense) {
+    std::fill(dense, dense + static_cast<size_t>(m.rows) * m.cols, 0.0f);
+    const size_t block_size = static_cast<size_t>(m.block_rows) * m.block_cols;
+    for (int br = 0; br < m.block_row_count(); ++br) {
+        for (int64_t b = m.row_ptr[br]; b < m.row_ptr[br + 1]; ++b) {
+            const float* block = m.values + b * block_size;
+            float* out = dense + static_cast<size_t>(br) * m.block_rows * m.cols + static_cast<size_t>(m.col_idx[b]) * m.block_cols;
+            for (int r = 0; r < m.block_rows; ++r) {
+                std::copy(block + r * m.block_cols, block + (r + 1) * m.block_cols, out + static_cast<size_t>(r) * m.cols);
+            }
+        }
+    }
+}
+
+// Check the structure of a matrix read from a file: monotone row pointers that end at the
+// number of blocks, block columns in range and ascending within a block row.
+inline bool sparse_valid(const SparseMatrix& m) {
+    if (m.rows <= 0 || m.cols <= 0 || m.block_rows <= 0 || m.block_cols <= 0 || m.rows % m.block_rows != 0 ||
+        m.cols % m.block_cols != 0 || m.row_ptr.size() != static_cast<size_t>(m.block_row_count()) + 1 ||
+        m.row_ptr.front() != 0 || m.row_ptr.back() != static_cast<int64_t>(m.blocks()) ||
+        m.values.size() != m.blocks() * m.block_elements()) {
+        return false;
+    }
+    const int block_cols = m.cols / m.block_cols;
+    for (int r = 0; r < m.block_row_count(); ++r) {
+        if (m.row_ptr[r] > m.row_ptr[r + 1]) return false;
+        for (int64_t b = m.row_ptr[r]; b < m.row_ptr[r + 1]; ++b) {
+            if (m.col_idx[b] < 0 || m.col_idx[b] >= block_cols || (b > m.row_ptr[r] && m.col_idx[b] <= m.col_idx[b - 1])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Binary sparse format: a fixed-size header followed by the row pointers (int64), the
+// block columns (int32), and the values (float), each section starting at a multiple of
+// the alignment. The checksum (tensor_checksum()) covers everything after the header.
+constexpr char SPARSE_MAGIC[8] = {'S', 'P', 'A', 'R', 'S', 'E', 'B', '1'};
+constexpr uint32_t SPARSE_VERSION = 1;
+
+struct SparseHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t alignment;
+    uint64_t rows, cols;
+    uint64_t block_rows, block_cols;
+    uint64_t blocks;
+    uint64_t row_ptr_offset;  // bytes from start of file
+    uint64_t col_idx_offset;
+    uint64_t values_offset;
+    uint64_t file_bytes;
+    uint64_t checksum;
+};
+static_assert(sizeof(SparseHeader) == 96, "SparseHeader layout must stay stable");
+
+inline size_t sparse_align(size_t offset, size_t alignment) { return (offset + alignment - 1) / alignment * alignment; }
+
+inline bool write_sparse_binary(const std::string& filename, const SparseMatrix& m,
+                                uint32_t alignment = TENSOR_DEFAULT_ALIGNMENT) {
+    SparseHeader header = {};
+    std::memcpy(header.magic, SPARSE_MAGIC, sizeof(SPARSE_MAGIC));
+    header.version = SPARSE_VERSION;
+    header.alignment = alignment;
+    header.rows = static_cast<uint64_t>(m.rows);
+    header.cols = static_cast<uint64_t>(m.cols);
+    header.block_rows = static_cast<uint64_t>(m.block_rows);
+    header.block_cols = static_cast<uint64_t>(m.block_cols);
+    header.blocks = m.blocks();
+    header.row_ptr_offset = sparse_align(sizeof(SparseHeader), alignment);
+    header.col_idx_offset = sparse_align(header.row_ptr_offset + m.row_ptr.size() * sizeof(int64_t), alignment);
+    header.values_offset = sparse_align(header.col_idx_offset + m.col_idx.size() * sizeof(int32_t), alignment);
+    header.file_bytes = header.values_offset + m.values.size() * sizeof(float);
+
+    std::vector<char> body(header.file_bytes - sizeof(SparseHeader), 0);
+    char* base = body.data() - sizeof(SparseHeader);
+    std::memcpy(base + header.row_ptr_offset, m.row_ptr.data(), m.row_ptr.size() * sizeof(int64_t));
+    std::memcpy(base + header.col_idx_offset, m.col_idx.data(), m.col_idx.size() * sizeof(int32_t));
+    std::memcpy(base + header.values_offset, m.values.data(), m.values.size() * sizeof(float));
+    header.checksum = tensor_checksum(body.data(), body.size());
+
+    std::ofstream ofs(filename, std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ofs.write(body.data(), static_cast<std::streamsize>(body.size()));
+    return ofs.good();
+}
+
+inline bool read_sparse_binary(const std::string& filename, SparseMatrix& m) {
+    std::ifstream ifs(filename, std::ios::binary);
+    SparseHeader header;
+    if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, SPARSE_MAGIC, sizeof(SPARSE_MAGIC)) != 0 || header.version != SPARSE_VERSION ||
+        header.rows == 0 || header.cols == 0 || header.block_rows == 0 || header.block_cols == 0 ||
+        header.rows > static_cast<uint64_t>(std::numeric_limits<int>::max()) ||
+        header.cols > static_cast<uint64_t>(std::numeric_limits<int>::max()) ||
+        header.block_rows > header.rows || header.block_cols > header.cols) {
+        return false;
+    }
+    m = SparseMatrix{};
+    m.rows = static_cast<int>(header.rows);
+    m.cols = static_cast<int>(header.cols);
+    m.block_rows = static_cast<int>(header.block_rows);
+    m.block_cols = static_cast<int>(header.block_cols);
+    if (m.rows % m.block_rows != 0 || header.blocks > static_cast<uint64_t>(m.block_row_count()) * (m.cols / m.block_cols)) {
+        return false;
+    }
+    m.row_ptr.resize(static_cast<size_t>(m.block_row_count()) + 1);
+    m.col_idx.resize(header.blocks);
+    m.values.resize(header.blocks * m.block_elements());
+    if (header.row_ptr_offset < sizeof(SparseHeader) ||
+        header.col_idx_offset < header.row_ptr_offset + m.row_ptr.size() * sizeof(int64_t) ||
+        header.values_offset < header.col_idx_offset + m.col_idx.size() * sizeof(int32_t) ||
+        header.file_bytes != header.values_offset + m.values.size() * sizeof(float)) {
+        return false;
+    }
+    std::vector<char> body(header.file_bytes - sizeof(SparseHeader));
+    if (!ifs.read(body.data(), static_cast<std::streamsize>(body.size())) ||
+        tensor_checksum(body.data(), body.size()) != header.checksum) {
+        return false;
+    }
+    const char* base = body.data() - sizeof(SparseHeader);
+    std::memcpy(m.row_ptr.data(), base + header.row_ptr_offset, m.row_ptr.size() * sizeof(int64_t));
+    std::memcpy(m.col_idx.data(), base + header.col_idx_offset, m.col_idx.size() * sizeof(int32_t));
+    std::memcpy(m.values.data(), base + header.values_offset, m.values.size() * sizeof(float));
+    return sparse_valid(m);
+}
+
+// Text sparse format: a header line "<rows> <cols> <format> <blocks>" (format as in
+// sparse_format_name()), then a line of row pointers, a line of block columns, and one
+// line of values per stored block.
+inline bool write_sparse_text(const std::string& filename, const SparseMatrix& m) {
+    std::ofstream ofs(filename);
+    ofs << m.rows << " " << m.cols << " " << sparse_format_name(m.block_rows, m.block_cols) << " " << m.blocks() << "\n";
+    for (size_t i = 0; i < m.row_ptr.size(); ++i) ofs << (i ? " " : "") << m.row_ptr[i];
+    ofs << "\n";
+    for (size_t i = 0; i < m.col_idx.size(); ++i) ofs << (i ? " " : "") << m.col_idx[i];
+    ofs << "\n";
+    ofs << std::setprecision(std::numeric_limits<float>::max_digits10);
+    const size_t block_size = m.block_elements();
+    for (size_t i = 0; i < m.values.size(); ++i) {
+        ofs << m.values[i] << ((i + 1) % block_size == 0 ? "\n" : " ");
+    }
+    return ofs.good();
+}
+
+inline bool read_sparse_text(const std::string& filename, SparseMatrix& m) {
+    std::ifstream ifs(filename);
+    std::string format;
+    size_t blocks = 0;
+    m = SparseMatrix{};
+    if (!(ifs >> m.rows >> m.cols >> format >> blocks)) return false;
+    if (format != "csr" && (format.compare(0, 4, "bsr_") != 0 || !parse_block_size(format.substr(4), m.block_rows, m.block_cols))) {
+        return false;
+    }
+    if (m.rows <= 0 || m.cols <= 0 || m.rows % m.block_rows != 0) return false;
+    m.row_ptr.resize(static_cast<size_t>(m.block_row_count()) + 1);
+    m.col_idx.resize(blocks);
+    m.values.resize(blocks * m.block_elements());
+    for (int64_t& p : m.row_ptr) ifs >> p;
+    for (int32_t& c : m.col_idx) ifs >> c;
+    for (float& v : m.values) ifs >> v;
+    return !ifs.fail() && sparse_valid(m);
+}
+
+// Read a sparse matrix in either format, chosen by the file's magic bytes.
+inline bool read_sparse(const std::string& filename, SparseMatrix& m) {
+    std::ifstream ifs(filename, std::ios::binary);
+    char magic[sizeof(SPARSE_MAGIC)] = {};
+    const bool binary = ifs.read(magic, sizeof(magic)) && std::memcmp(magic, SPARSE_MAGIC, sizeof(magic)) == 0;
+    ifs.close();
+    return binary ? read_sparse_binary(filename, m) : read_sparse_text(filename, m);
+}
+
+inline bool write_sparse(const std::string& filename, const SparseMatrix& m, TensorFormat format) {
+    return format == TensorFormat::Binary ? write_sparse_binary(filename, m) : write_sparse_text(filename, m);
+}
+
+#endif /* SPARSE_HELPER_H */
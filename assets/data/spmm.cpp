@@ -0,0 +1,151 @@
+#include "data_helper.h"
+#include "matmul_gold.h"
+#include "sparse_helper.h"
+#include <iostream>
+#include <random>
+#include <cstdlib>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Data of a sparse-times-dense matmul C = A * B with an I x K sparse A: the dense A
+// (input_A.<ext>, for the dense competitors and the gold output), the same A in CSR
+// (input_A.csr.<ext>) and in BSR with the given block size (input_A.bsr.<ext>), and the
+// dense B, initial C, and expected C of the MatMul generator. The values of A are those of
+// the MatMul generator's A of the same seed where the sparsity pattern keeps them and zero
+// elsewhere. The pattern draws every element (element) or every block of the BSR block
+// size (block) independently with probability density, from its own random stream, so
+// the density can be swept without changing the values. The expected C is the dense gold
+// matmul of the dense A; its zero terms add nothing, so it sums exactly the products the
+// sparse kernels sum.
+int main(int argc, char* argv[]) {
+    if (argc < 5) {
+        std::cerr << "Usage: " << argv[0] << " I J K density [txt|bin] [seed|random] [element|block] [RxC]" << std::endl;
+        return 1;
+    }
+    int I = std::atoi(argv[1]);
+    int J = std::atoi(argv[2]);
+    int K = std::atoi(argv[3]);
+    const double density = std::atof(argv[4]);
+    if (I <= 0 || J <= 0 || K <= 0) {
+        std::cerr << "I, J, K must be positive" << std::endl;
+        return 1;
+    }
+    if (!(density > 0 && density <= 1)) {
+        std::cerr << "density must be in (0, 1]" << std::endl;
+        return 1;
+    }
+
+    std::string ext = argc > 5 ? argv[5] : "txt";
+    TensorFormat format;
+    if (!parse_tensor_format(ext, format)) {
+        std::cerr << "Unknown format '" << ext << "' (expected txt or bin)" << std::endl;
+        return 1;
+    }
+    const std::string file_A = "input_A." + ext;
+    const std::string file_csr = "input_A.csr." + ext;
+    const std::string file_bsr = "input_A.bsr." + ext;
+    const std::string file_B = "input_B." + ext;
+    const std::string file_init_C = "input_C." + ext;
+    const std::string file_C = "output_C." + ext;
+
+    uint64_t seed;
+    const std::string seed_arg = argc > 6 ? argv[6] : "random";
+    if (seed_arg == "random") {
+        std::random_device rd;
+        seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+    } else {
+        char* end = nullptr;
+        seed = std::strtoull(seed_arg.c_str(), &end, 0);
+        if (seed_arg.empty() || *end != '\0') {
+            std::cerr << "Invalid seed '" << seed_arg << "' (expected an integer or random)" << std::endl;
+            return 1;
+        }
+    }
+
+    const std::string pattern = argc > 7 ? argv[7] : "element";
+    if (pattern != "element" && pattern != "block") {
+        std::cerr << "Invalid pattern '" << pattern << "' (expected element or block)" << std::endl;
+        return 1;
+    }
+    int block_rows = 4, block_cols = 4;
+    if (argc > 8 && !parse_block_size(argv[8], block_rows, block_cols)) {
+        std::cerr << "Invalid block size '" << argv[8] << "' (expected <rows>x<cols>)" << std::endl;
+        return 1;
+    }
+    if (I % block_rows != 0 || K % block_cols != 0) {
+        std::cerr << "The " << block_rows << "x" << block_cols << " blocks must tile A (" << I << "x" << K << ")" << std::endl;
+        return 1;
+    }
+
+    const size_t size_A = static_cast<size_t>(I) * K;
+    std::vector<float> A(size_A);
+    std::vector<float> B(static_cast<size_t>(K) * J);
+    fill_uniform(A.data(), A.size(), seed, STREAM_A);
+    fill_uniform(B.data(), B.size(), seed, STREAM_B);
+
+    // Zero the elements the pattern drops.
+    const int blocks_per_row = K / block_cols;
+    const size_t draws = pattern == "element" ? size_A : size_A / (static_cast<size_t>(block_rows) * block_cols);
+    std::vector<float> keep(draws);
+    fill_uniform(keep.data(), keep.size(), seed, STREAM_PATTERN);
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < I; ++i) {
+        for (int k = 0; k < K; ++k) {
+            const size_t draw = pattern == "element"
+                                     ? static_cast<size_t>(i) * K + k
+                                     : static_cast<size_t>(i / block_rows) * blocks_per_row + k / block_cols;
+            if (keep[draw] >= density) A[static_cast<size_t>(i) * K + k] = 0.0f;
+        }
+    }
+    keep = std::vector<float>();
+
+    SparseMatrix csr, bsr;
+    to_sparse(A.data(), I, K, 1, 1, csr);
+    to_sparse(A.data(), I, K, block_rows, block_cols, bsr);
+
+    std::vector<float> C(static_cast<size_t>(I) * J, 0.0f);
+    if (!write_matrix(file_init_C, C, {I, J}, format)) {
+        std::cerr << "Failed to write " << file_init_C << std::endl;
+        return 2;
+    }
+    if (!write_matrix(file_A, A, {I, K}, format)) {
+        std::cerr << "Failed to write " << file_A << std::endl;
+        return 2;
+    }
+    if (!write_sparse(file_csr, csr, format)) {
+        std::cerr << "Failed to write " << file_csr << std::endl;
+        return 2;
+    }
+    if (!write_sparse(file_bsr, bsr, format)) {
+        std::cerr << "Failed to write " << file_bsr << std::endl;
+        return 2;
+    }
+    if (!write_matrix(file_B, B, {K, J}, format)) {
+        std::cerr << "Failed to write " << file_B << std::endl;
+        return 2;
+    }
+
+    matmul_gold(A.data(), B.data(), C.data(), I, J, K);
+    if (!write_matrix(file_C, C, {I, J}, format)) {
+        std::cerr << "Failed to write " << file_C << std::endl;
+        return 2;
+    }
+#ifdef _OPENMP
+    std::cout << "Computed expected C using " << omp_get_max_threads() << " thread(s)\n";
+#endif
+
+    const size_t nonzeros = csr.values.size();
+    std::cout << "Seed: " << seed << "\n";
+    std::cout << "Pattern: " << pattern << ", density " << density << " (actual "
+              << static_cast<double>(nonzeros) / static_cast<double>(size_A) << ")\n";
+    std::cout << "Wrote A (" << I << "x" << K << ", " << nonzeros << " nonzeros) to " << file_A << ", " << file_csr
+              << "\n";
+    std::cout << "Wrote A (" << sparse_format_name(block_rows, block_cols) << ", " << bsr.blocks() << " blocks, "
+              << bsr.values.size() - nonzeros << " explicit zeros) to " << file_bsr << "\n";
+    std::cout << "Wrote B (" << K << "x" << J << ") to " << file_B << "\n";
+    std::cout << "Wrote initial C (" << I << "x" << J << ") to " << file_init_C << "\n";
+    std::cout << "Wrote expected C (" << I << "x" << J << ") to " << file_C << "\n";
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include "batched_harness.h"
+#include <algorithm>
+#include <cstdlib>
+#include <omp.h>
+
+// Batched competitors. Threads take whole problems (a static partition of the batch), so
+// no problem is split and threads do not synchronize inside the batch. Built twice:
+//   BATCHED_PACK_B=0 (batched_parallel): every problem with an i-k-j loop nest on row-major B
+//   BATCHED_PACK_B=1 (batched_packed): B is packed into BATCHED_NR-column panels once per run
+//                    and shared by all threads (a per-problem B is packed by the thread that
+//                    owns the problem), and a BATCHED_MR x BATCHED_NR register-blocked kernel
+//                    computes C
+// MATMUL_THREADS sets the number of threads (default: OpenMP's, e.g. OMP_NUM_THREADS).
+
+#ifndef BATCHED_PACK_B
+#define BATCHED_PACK_B 0
+#endif
+
+#ifndef BATCHED_MR
+#define BATCHED_MR 6
+#endif
+
+#ifndef BATCHED_NR
+#define BATCHED_NR 32
+#endif
+
+static_assert(BATCHED_MR >= 1 && BATCHED_MR <= 8, "BATCHED_MR must be in 1..8");
+
+constexpr int MR = BATCHED_MR;
+constexpr int NR = BATCHED_NR;
+
+static void matmul_ikj(const float* A, const float* B, float* C, int I, int J, int K) {
+    for (int i = 0; i < I; ++i) {
+        float* c_row = C + static_cast<size_t>(i) * J;
+        std::fill(c_row, c_row + J, 0.0f);
+        for (int k = 0; k < K; ++k) {
+            const float a = A[static_cast<size_t>(i) * K + k];
+            const float* b_row = B + static_cast<size_t>(k) * J;
+            #pragma omp simd
+            for (int j = 0; j < J; ++j) c_row[j] += a * b_row[j];
+        }
+    }
+}
+
+static int num_panels(int J) { return (J + NR - 1) / NR; }
+
+// Panels [begin, end) of B (K x J) as K x NR row-major blocks, zero-padded past column J.
+static void pack_panels(const float* B, float* packed, int J, int K, int begin, int end) {
+    for (int p = begin; p < end; ++p) {
+        const int j0 = p * NR, width = std::min(NR, J - j0);
+        for (int k = 0; k < K; ++k) {
+            float* dst = packed + (static_cast<size_t>(p) * K + k) * NR;
+            std::copy(B + static_cast<size_t>(k) * J + j0, B + static_cast<size_t>(k) * J + j0 + width, dst);
+            std::fill(dst + width, dst + NR, 0.0f);
+        }
+    }
+}
+
+// ROWS x NR block of C from ROWS rows of A and one packed panel; the accumulators stay in
+// registers for the whole K loop.
+template <int ROWS>
+static void micro_kernel(const float* A, const float* panel, float* C, int J, int K, int width) {
+    float acc[ROWS][NR] = {};
+    for (int k = 0; k < K; ++k) {
+        const float* b = panel + static_cast<size_t>(k) * NR;
+        for (int r = 0; r < ROWS; ++r) {
+            const float a = A[static_cast<size_t>(r) * K + k];
+            #pragma omp simd
+            for (int j = 0; j < NR; ++j) acc[r][j] += a * b[j];
+        }
+    }
+    for (int r = 0; r < ROWS; ++r) std::copy(acc[r], acc[r] + width, C + static_cast<size_t>(r) * J);
+}
+
+static void block(int rows, const float* A, const float* panel, float* C, int J, int K, int width) {
+    switch (rows) {
+        case 1: micro_kernel<1>(A, panel, C, J, K, width); break;
+        case 2: micro_kernel<2>(A, panel, C, J, K, width); break;
+        case 3: micro_kernel<3>(A, panel, C, J, K, width); break;
+        case 4: micro_kernel<4>(A, panel, C, J, K, width); break;
+        case 5: micro_kernel<5>(A, panel, C, J, K, width); break;
+        case 6: micro_kernel<6>(A, panel, C, J, K, width); break;
+        case 7: micro_kernel<7>(A, panel, C, J, K, width); break;
+        default: micro_kernel<8>(A, panel, C, J, K, width); break;
+    }
+}
+
+// One problem against packed B: panel by panel (K x NR floats, resident in L1), all row
+// blocks of A.
+static void matmul_packed(const float* A, const float* packed, float* C, int I, int J, int K) {
+    for (int p = 0; p < num_panels(J); ++p) {
+        const int j0 = p * NR, width = std::min(NR, J - j0);
+        const float* panel = packed + static_cast<size_t>(p) * K * NR;
+        for (int i = 0; i < I; i += MR) {
+            block(std::min(MR, I - i), A + static_cast<size_t>(i) * K, panel, C + static_cast<size_t>(i) * J + j0, J, K,
+                  width);
+        }
+    }
+}
+
+static int threads = 1;
+static std::vector<float> shared_packed;                // packed B of a shared-B batch
+static std::vector<std::vector<float>> thread_packed;  // per-thread packed B otherwise
+
+static bool setup(const MatMulBatch& batch) {
+    threads = omp_get_max_threads();
+    if (const char* v = std::getenv("MATMUL_THREADS")) {
+        const int n = std::atoi(v);
+        if (n > 0) threads = n;
+    }
+    omp_set_num_threads(threads);
+    if (BATCHED_PACK_B) {
+        const size_t packed_size = static_cast<size_t>(num_panels(batch.J)) * batch.K * NR;
+        if (batch.shared_B) shared_packed.resize(packed_size);
+        else thread_packed.assign(threads, std::vector<float>(packed_size));
+    }
+    return true;
+}
+
+static void matmul_batched(const MatMulBatch& batch) {
+    const int I = batch.I, J = batch.J, K = batch.K;
+    if (!BATCHED_PACK_B) {
+        #pragma omp parallel for schedule(static)
+        for (int b = 0; b < batch.count; ++b) matmul_ikj(batch.A[b], batch.B[b], batch.C[b], I, J, K);
+        return;
+    }
+    if (batch.shared_B) {
+        // Packed once per run; the pack is amortized over the whole batch.
+        #pragma omp parallel for schedule(static)
+        for (int p = 0; p < num_panels(J); ++p) pack_panels(batch.B[0], shared_packed.data(), J, K, p, p + 1);
+        #pragma omp parallel for schedule(static)
+        for (int b = 0; b < batch.count; ++b) matmul_packed(batch.A[b], shared_packed.data(), batch.C[b], I, J, K);
+        return;
+    }
+    #pragma omp parallel
+    {
+        float* packed = thread_packed[omp_get_thread_num()].data();
+        #pragma omp for schedule(static)
+        for (int b = 0; b < batch.count; ++b) {
+            pack_panels(batch.B[b], packed, J, K, 0, num_panels(J));
+            matmul_packed(batch.A[b], packed, batch.C[b], I, J, K);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BatchedMatMulKernel kernel(matmul_batched);
+    kernel.setup = setup;
+    kernel.describe = [](const MatMulBatch& batch) {
+        std::string s = BATCHED_PACK_B ? (batch.shared_B ? "shared packed B" : "packed B per problem") : "i-k-j";
+        if (BATCHED_PACK_B) s += ", " + std::to_string(MR) + "x" + std::to_string(NR) + " blocks";
+        return s + ", " + std::to_string(threads) + " thread(s)";
+    };
+    kernel.threads = [] { return threads; };
+    return batched_harness_main(argc, argv, kernel);
+}
@@ -0,0 +1,22 @@
+#include "batched_harness.h"
+
+// One problem after the other, each with the naive loop nest of the MatMul baseline.
+void matmul_batched(const MatMulBatch& batch) {
+    const int I = batch.I, J = batch.J, K = batch.K;
+    for (int b = 0; b < batch.count; ++b) {
+        const float* A = batch.A[b];
+        const float* B = batch.B[b];
+        float* C = batch.C[b];
+        for (int i = 0; i < I; ++i) {
+            for (int j = 0; j < J; ++j) {
+                float sum = 0.0f;
+                for (int k = 0; k < K; ++k) {
+                    sum += A[i * K + k] * B[k * J + j];
+                }
+                C[i * J + j] = sum;
+            }
+        }
+    }
+}
+
+REGISTER_BATCHED_MATMUL_KERNEL(matmul_batched)
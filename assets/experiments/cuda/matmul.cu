@@ -0,0 +1,372 @@
+#include "harness.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+#include <cuda_runtime.h>
+#include <mma.h>
+
+// Element type of A and B: float, bfloat16, or float16 (C and the accumulators stay float).
+#ifndef MATMUL_INPUT
+#define MATMUL_INPUT float
+#endif
+
+using Input = MATMUL_INPUT;
+static_assert(!ElementTraits<Input>::quantized, "the CUDA kernels take floating-point operands");
+
+// The CUDA type with Input's layout, which the kernels see.
+using DeviceInput = std::conditional<std::is_same<Input, bfloat16>::value, __nv_bfloat16,
+                    std::conditional<std::is_same<Input, float16>::value, __half, float>::type>::type;
+static_assert(sizeof(DeviceInput) == sizeof(Input), "device and host operand types must match");
+
+__device__ inline float to_float_device(float x) { return x; }
+__device__ inline float to_float_device(__half x) { return __half2float(x); }
+__device__ inline float to_float_device(__nv_bfloat16 x) { return __bfloat162float(x); }
+
+// Shared-memory tiling: each block computes a BLOCK_M x BLOCK_N tile of C, stepping
+// through K in BLOCK_K slices; each thread owns a THREAD_M x THREAD_N register tile.
+#ifndef BLOCK_M
+#define BLOCK_M 64
+#endif
+
+#ifndef BLOCK_N
+#define BLOCK_N 64
+#endif
+
+#ifndef BLOCK_K
+#define BLOCK_K 16
+#endif
+
+#ifndef THREAD_M
+#define THREAD_M 4
+#endif
+
+#ifndef THREAD_N
+#define THREAD_N 4
+#endif
+
+#define CUDA_CHECK(call)                                                              \
+    do {                                                                              \
+        cudaError_t err_ = (call);                                                    \
+        if (err_ != cudaSuccess) {                                                    \
+            std::cerr << "CUDA error: " << cudaGetErrorString(err_) << " at "        \
+                      << __FILE__ << ":" << __LINE__ << std::endl;                    \
+            std::exit(3);                                                             \
+        }                                                                             \
+    } while (0)
+
+constexpr int TILED_THREADS = (BLOCK_M / THREAD_M) * (BLOCK_N / THREAD_N);
+static_assert((BLOCK_M * BLOCK_K) % TILED_THREADS == 0, "A tile must split evenly over threads");
+static_assert((BLOCK_K * BLOCK_N) % TILED_THREADS == 0, "B tile must split evenly over threads");
+
+// Double-buffered shared-memory tiled matmul. While the block computes on one shared
+// buffer, each thread already holds the next K slice in registers and writes it to the
+// other buffer afterwards, so only one barrier per K slice is needed. Operands are
+// widened to float when loaded.
+template <typename T>
+__global__ void __launch_bounds__(TILED_THREADS) matmul_tiled(
+    const T* __restrict__ A, const T* __restrict__ B, float* __restrict__ C,
+    int I, int J, int K
+) {
+    constexpr int A_LOADS = BLOCK_M * BLOCK_K / TILED_THREADS;
+    constexpr int B_LOADS = BLOCK_K * BLOCK_N / TILED_THREADS;
+    __shared__ float As[2][BLOCK_K][BLOCK_M]; // A slice stored transposed
+    __shared__ float Bs[2][BLOCK_K][BLOCK_N];
+
+    const int tid = threadIdx.x;
+    const int tx = tid % (BLOCK_N / THREAD_N);
+    const int ty = tid / (BLOCK_N / THREAD_N);
+    const int row0 = blockIdx.y * BLOCK_M;
+    const int col0 = blockIdx.x * BLOCK_N;
+
+    float a_stage[A_LOADS];
+    float b_stage[B_LOADS];
+    float acc[THREAD_M][THREAD_N] = {};
+
+    auto load_global = [&](int k0) {
+        #pragma unroll
+        for (int l = 0; l < A_LOADS; ++l) {
+            int e = tid + l * TILED_THREADS;
+            int r = e / BLOCK_K, c = e % BLOCK_K;
+            int gr = row0 + r, gc = k0 + c;
+            a_stage[l] = (gr < I && gc < K) ? to_float_device(A[static_cast<size_t>(gr) * K + gc]) : 0.0f;
+        }
+        #pragma unroll
+        for (int l = 0; l < B_LOADS; ++l) {
+            int e = tid + l * TILED_THREADS;
+            int r = e / BLOCK_N, c = e % BLOCK_N;
+            int gr = k0 + r, gc = col0 + c;
+            b_stage[l] = (gr < K && gc < J) ? to_float_device(B[static_cast<size_t>(gr) * J + gc]) : 0.0f;
+        }
+    };
+    auto store_shared = [&](int buf) {
+        #pragma unroll
+        for (int l = 0; l < A_LOADS; ++l) {
+            int e = tid + l * TILED_THREADS;
+            As[buf][e % BLOCK_K][e / BLOCK_K] = a_stage[l];
+        }
+        #pragma unroll
+        for (int l = 0; l < B_LOADS; ++l) {
+            int e = tid + l * TILED_THREADS;
+            Bs[buf][e / BLOCK_N][e % BLOCK_N] = b_stage[l];
+        }
+    };
+
+    load_global(0);
+    store_shared(0);
+    __syncthreads();
+
+    int buf = 0;
+    for (int k0 = 0; k0 < K; k0 += BLOCK_K) {
+        const bool has_next = k0 + BLOCK_K < K;
+        if (has_next) load_global(k0 + BLOCK_K);
+
+        #pragma unroll
+        for (int k = 0; k < BLOCK_K; ++k) {
+            float a_frag[THREAD_M], b_frag[THREAD_N];
+            #pragma unroll
+            for (int m = 0; m < THREAD_M; ++m) a_frag[m] = As[buf][k][ty * THREAD_M + m];
+            #pragma unroll
+            for (int n = 0; n < THREAD_N; ++n) b_frag[n] = Bs[buf][k][tx * THREAD_N + n];
+            #pragma unroll
+            for (int m = 0; m < THREAD_M; ++m)
+                #pragma unroll
+                for (int n = 0; n < THREAD_N; ++n) acc[m][n] += a_frag[m] * b_frag[n];
+        }
+
+        // The other buffer was last read before the previous barrier, so it is free.
+        if (has_next) store_shared(buf ^ 1);
+        __syncthreads();
+        buf ^= 1;
+    }
+
+    #pragma unroll
+    for (int m = 0; m < THREAD_M; ++m) {
+        int r = row0 + ty * THREAD_M + m;
+        if (r >= I) continue;
+        #pragma unroll
+        for (int n = 0; n < THREAD_N; ++n) {
+            int c = col0 + tx * THREAD_N + n;
+            if (c < J) C[static_cast<size_t>(r) * J + c] = acc[m][n];
+        }
+    }
+}
+
+// Tensor-core matmul with TF32 inputs and FP32 accumulation (sm_80 and newer). Each warp
+// computes one 16x16 tile of C; a block of 4 warps covers 32x32. Requires I and J to be
+// multiples of 16 and K a multiple of 8 (see wmma_supported()).
+constexpr int WMMA_WARPS = 4;
+
+__global__ void matmul_wmma(
+    const float* __restrict__ A, const float* __restrict__ B, float* __restrict__ C,
+    int I, int J, int K
+) {
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 800
+    using namespace nvcuda;
+    const int warp = threadIdx.x / 32;
+    const int row = blockIdx.y * 32 + (warp / 2) * 16;
+    const int col = blockIdx.x * 32 + (warp % 2) * 16;
+    if (row >= I || col >= J) return;
+
+    wmma::fragment<wmma::matrix_a, 16, 16, 8, wmma::precision::tf32, wmma::row_major> a_frag;
+    wmma::fragment<wmma::matrix_b, 16, 16, 8, wmma::precision::tf32, wmma::row_major> b_frag;
+    wmma::fragment<wmma::accumulator, 16, 16, 8, float> c_frag;
+    wmma::fill_fragment(c_frag, 0.0f);
+
+    for (int k = 0; k < K; k += 8) {
+        wmma::load_matrix_sync(a_frag, A + static_cast<size_t>(row) * K + k, K);
+        wmma::load_matrix_sync(b_frag, B + static_cast<size_t>(k) * J + col, J);
+        for (int t = 0; t < a_frag.num_elements; ++t) a_frag.x[t] = wmma::__float_to_tf32(a_frag.x[t]);
+        for (int t = 0; t < b_frag.num_elements; ++t) b_frag.x[t] = wmma::__float_to_tf32(b_frag.x[t]);
+        wmma::mma_sync(c_frag, a_frag, b_frag, c_frag);
+    }
+    wmma::store_matrix_sync(C + static_cast<size_t>(row) * J + col, c_frag, J, wmma::mem_row_major);
+#endif
+}
+
+// Tensor-core matmul with half or bfloat16 inputs and FP32 accumulation (sm_70 and newer
+// for half, sm_80 for bfloat16), tiled like matmul_wmma. Requires I, J, and K to be
+// multiples of 16.
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 700
+template <typename T>
+__device__ void wmma16_tile(const T* __restrict__ A, const T* __restrict__ B, float* __restrict__ C, int I, int J, int K) {
+    using namespace nvcuda;
+    const int warp = threadIdx.x / 32;
+    const int row = blockIdx.y * 32 + (warp / 2) * 16;
+    const int col = blockIdx.x * 32 + (warp % 2) * 16;
+    if (row >= I || col >= J) return;
+
+    wmma::fragment<wmma::matrix_a, 16, 16, 16, T, wmma::row_major> a_frag;
+    wmma::fragment<wmma::matrix_b, 16, 16, 16, T, wmma::row_major> b_frag;
+    wmma::fragment<wmma::accumulator, 16, 16, 16, float> c_frag;
+    wmma::fill_fragment(c_frag, 0.0f);
+
+    for (int k = 0; k < K; k += 16) {
+        wmma::load_matrix_sync(a_frag, A + static_cast<size_t>(row) * K + k, K);
+        wmma::load_matrix_sync(b_frag, B + static_cast<size_t>(k) * J + col, J);
+        wmma::mma_sync(c_frag, a_frag, b_frag, c_frag);
+    }
+    wmma::store_matrix_sync(C + static_cast<size_t>(row) * J + col, c_frag, J, wmma::mem_row_major);
+}
+#endif
+
+template <typename T>
+__global__ void matmul_wmma16(
+    const T* __restrict__ A, const T* __restrict__ B, float* __restrict__ C,
+    int I, int J, int K
+) {
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 700
+    // bfloat16 fragments only exist for sm_80 and newer.
+    if constexpr (!std::is_same<T, __nv_bfloat16>::value || __CUDA_ARCH__ >= 800) wmma16_tile(A, B, C, I, J, K);
+#endif
+}
+
+// TF32 tensor cores for float operands, 16x16x16 fragments of the operand type otherwise.
+static void launch_wmma(dim3 grid, const float* A, const float* B, float* C, int I, int J, int K) {
+    matmul_wmma<<<grid, WMMA_WARPS * 32>>>(A, B, C, I, J, K);
+}
+
+template <typename T>
+static void launch_wmma(dim3 grid, const T* A, const T* B, float* C, int I, int J, int K) {
+    matmul_wmma16<<<grid, WMMA_WARPS * 32>>>(A, B, C, I, J, K);
+}
+
+enum class CudaKernel { Tiled, Wmma };
+
+static const char* kernel_name(CudaKernel k) { return k == CudaKernel::Tiled ? "tiled" : "wmma"; }
+
+static bool wmma_supported(int I, int J, int K) {
+    int device = 0, major = 0;
+    CUDA_CHECK(cudaGetDevice(&device));
+    CUDA_CHECK(cudaDeviceGetAttribute(&major, cudaDevAttrComputeCapabilityMajor, device));
+    if (std::is_same<Input, float16>::value) return major >= 7 && I % 16 == 0 && J % 16 == 0 && K % 16 == 0;
+    return major >= 8 && I % 16 == 0 && J % 16 == 0 && K % (std::is_same<Input, float>::value ? 8 : 16) == 0;
+}
+
+// MATMUL_CUDA_KERNEL selects "tiled", "wmma", or "auto" (default: wmma where the device
+// and shape support it, tiled otherwise).
+static CudaKernel select_kernel(int I, int J, int K) {
+    std::string choice = std::getenv("MATMUL_CUDA_KERNEL") ? std::getenv("MATMUL_CUDA_KERNEL") : "auto";
+    if (choice == "tiled") return CudaKernel::Tiled;
+    if (choice != "auto" && choice != "wmma") std::cerr << "Unknown MATMUL_CUDA_KERNEL '" << choice << "', using auto" << std::endl;
+    if (wmma_supported(I, J, K)) return CudaKernel::Wmma;
+    if (choice == "wmma") std::cerr << "WMMA not supported for this device or shape, using tiled" << std::endl;
+    return CudaKernel::Tiled;
+}
+
+// Tolerance for comparing against the FP32 gold output. TF32 rounds inputs to 10 mantissa
+// bits (unit roundoff 2^-11), which bounds the error of each product. bfloat16 and half
+// inputs are already rounded before the upload, and their products are exact in FP32.
+static Tolerance kernel_tolerance(CudaKernel kernel, int K) {
+    if (kernel == CudaKernel::Wmma && std::is_same<Input, float>::value) return matmul_tolerance(K, 0x1p-11f);
+    return matmul_tolerance_for<Input>(K);
+}
+
+void matmul(
+    const DeviceInput* A, // I x K, device
+    const DeviceInput* B, // K x J, device
+    float* C,             // I x J, device, output
+    int I, int J, int K, CudaKernel kernel
+) {
+    if (kernel == CudaKernel::Wmma) {
+        dim3 grid((J + 31) / 32, (I + 31) / 32);
+        launch_wmma(grid, A, B, C, I, J, K);
+    } else {
+        dim3 grid((J + BLOCK_N - 1) / BLOCK_N, (I + BLOCK_M - 1) / BLOCK_M);
+        matmul_tiled<<<grid, TILED_THREADS>>>(A, B, C, I, J, K);
+    }
+    CUDA_CHECK(cudaGetLastError());
+}
+
+// Elapsed time between two recorded events in nanoseconds.
+static int64_t elapsed_ns(cudaEvent_t start, cudaEvent_t end) {
+    float ms = 0.0f;
+    CUDA_CHECK(cudaEventElapsedTime(&ms, start, end));
+    return static_cast<int64_t>(static_cast<double>(ms) * 1e6);
+}
+
+// Pinned host staging buffers, device buffers, and events, set up once per benchmark.
+struct CudaState {
+    size_t size_A, size_B, size_C;
+    Input *h_A, *h_B;
+    float* h_C;
+    DeviceInput *d_A, *d_B;
+    float* d_C;
+    cudaEvent_t ev_begin, ev_h2d, ev_kernel, ev_d2h;
+};
+
+static bool cuda_setup(CudaState& s, const BasicMatMulProblem<Input>& p) {
+    s.size_A = static_cast<size_t>(p.I) * p.K;
+    s.size_B = static_cast<size_t>(p.K) * p.J;
+    s.size_C = static_cast<size_t>(p.I) * p.J;
+
+    // Pinned host staging buffers, so H2D/D2H times reflect DMA rather than paging.
+    CUDA_CHECK(cudaMallocHost(&s.h_A, s.size_A * sizeof(Input)));
+    CUDA_CHECK(cudaMallocHost(&s.h_B, s.size_B * sizeof(Input)));
+    CUDA_CHECK(cudaMallocHost(&s.h_C, s.size_C * sizeof(float)));
+    std::copy(p.A, p.A + s.size_A, s.h_A);
+    std::copy(p.B, p.B + s.size_B, s.h_B);
+
+    CUDA_CHECK(cudaMalloc(&s.d_A, s.size_A * sizeof(Input)));
+    CUDA_CHECK(cudaMalloc(&s.d_B, s.size_B * sizeof(Input)));
+    CUDA_CHECK(cudaMalloc(&s.d_C, s.size_C * sizeof(float)));
+
+    CUDA_CHECK(cudaEventCreate(&s.ev_begin));
+    CUDA_CHECK(cudaEventCreate(&s.ev_h2d));
+    CUDA_CHECK(cudaEventCreate(&s.ev_kernel));
+    CUDA_CHECK(cudaEventCreate(&s.ev_d2h));
+    return true;
+}
+
+static void cuda_teardown(CudaState& s) {
+    CUDA_CHECK(cudaEventDestroy(s.ev_begin));
+    CUDA_CHECK(cudaEventDestroy(s.ev_h2d));
+    CUDA_CHECK(cudaEventDestroy(s.ev_kernel));
+    CUDA_CHECK(cudaEventDestroy(s.ev_d2h));
+    CUDA_CHECK(cudaFree(s.d_A));
+    CUDA_CHECK(cudaFree(s.d_B));
+    CUDA_CHECK(cudaFree(s.d_C));
+    CUDA_CHECK(cudaFreeHost(s.h_A));
+    CUDA_CHECK(cudaFreeHost(s.h_B));
+    CUDA_CHECK(cudaFreeHost(s.h_C));
+}
+
+// One run: copy A and B to the device, compute, copy C back. Both kernels overwrite every
+// element of C, so the initial C is not uploaded (the harness applies a beta epilogue on the
+// host). Each phase is timed separately with events on the default stream. The run's time
+// is the kernel time only (operands resident on the device, like the CPU competitors);
+// transfer times are recorded as phases (runtimes_h2d, runtimes_d2h).
+static void cuda_run(CudaState& s, float* C, int I, int J, int K, CudaKernel kernel, RunContext& ctx) {
+    CUDA_CHECK(cudaEventRecord(s.ev_begin));
+    CUDA_CHECK(cudaMemcpyAsync(s.d_A, s.h_A, s.size_A * sizeof(Input), cudaMemcpyHostToDevice));
+    CUDA_CHECK(cudaMemcpyAsync(s.d_B, s.h_B, s.size_B * sizeof(Input), cudaMemcpyHostToDevice));
+    CUDA_CHECK(cudaEventRecord(s.ev_h2d));
+    matmul(s.d_A, s.d_B, s.d_C, I, J, K, kernel);
+    CUDA_CHECK(cudaEventRecord(s.ev_kernel));
+    CUDA_CHECK(cudaMemcpyAsync(s.h_C, s.d_C, s.size_C * sizeof(float), cudaMemcpyDeviceToHost));
+    CUDA_CHECK(cudaEventRecord(s.ev_d2h));
+    CUDA_CHECK(cudaEventSynchronize(s.ev_d2h));
+    std::copy(s.h_C, s.h_C + s.size_C, C);
+    ctx.add_phase("h2d", elapsed_ns(s.ev_begin, s.ev_h2d));
+    ctx.add_phase("d2h", elapsed_ns(s.ev_kernel, s.ev_d2h));
+    ctx.set_time_ns(elapsed_ns(s.ev_h2d, s.ev_kernel));
+}
+
+int main(int argc, char* argv[]) {
+    CudaState state{};
+    CudaKernel kernel = CudaKernel::Tiled;
+
+    BasicMatMulKernel<Input> bench([&](const Input*, const Input*, float* C, int I, int J, int K, RunContext& ctx) {
+        cuda_run(state, C, I, J, K, kernel, ctx);
+    });
+    bench.setup = [&](const BasicMatMulProblem<Input>& p) {
+        kernel = select_kernel(p.I, p.J, p.K);
+        return cuda_setup(state, p);
+    };
+    bench.teardown = [&]() { cuda_teardown(state); };
+    bench.describe = [&](int, int, int) { return std::string(kernel_name(kernel)); };
+    bench.tolerance = [&](int, int, int K) { return kernel_tolerance(kernel, K); };
+    return harness_main(argc, argv, bench);
+}
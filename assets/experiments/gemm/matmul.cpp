@@ -0,0 +1,350 @@
+#include "harness.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Cache blocking (BLIS/GotoBLAS naming): a KC x NC block of B is packed once per
+// (jc, pc) iteration and should fit in L3; an MC x KC block of A is packed per ic
+// iteration and should fit in L2; one NR-wide sliver of packed B (KC x NR) stays in L1.
+#ifndef GEMM_MC
+#define GEMM_MC 96
+#endif
+
+#ifndef GEMM_KC
+#define GEMM_KC 256
+#endif
+
+#ifndef GEMM_NC
+#define GEMM_NC 4096
+#endif
+
+// Register blocking: the micro-kernel keeps an MR x NR tile of C in vector registers.
+#if defined(__AVX512F__)
+#define GEMM_MR 12
+#define GEMM_NR 32
+#elif defined(__AVX2__) && defined(__FMA__)
+#define GEMM_MR 6
+#define GEMM_NR 16
+#else
+#define GEMM_MR 4
+#define GEMM_NR 8
+#endif
+
+// Whether the epilogue is fused into the write-back (see setup()); 0 leaves it to the
+// harness's separate pass, for comparison (tasks/build/gemm_unfused).
+#ifndef GEMM_FUSE_EPILOGUE
+#define GEMM_FUSE_EPILOGUE 1
+#endif
+
+static_assert(GEMM_MC % GEMM_MR == 0, "GEMM_MC must be a multiple of GEMM_MR");
+static_assert(GEMM_NC % GEMM_NR == 0, "GEMM_NC must be a multiple of GEMM_NR");
+
+struct AlignedFree {
+    void operator()(float* p) const { std::free(p); }
+};
+using AlignedBuffer = std::unique_ptr<float[], AlignedFree>;
+
+inline AlignedBuffer make_aligned_buffer(size_t n) {
+    size_t bytes = (n * sizeof(float) + 63) / 64 * 64;
+    return AlignedBuffer(static_cast<float*>(std::aligned_alloc(64, bytes)));
+}
+
+// Pack an mc x kc block of A (row stride lda), times alpha, into MR-row panels. Within a
+// panel the MR values of one column are contiguous; rows past mc are zero-padded.
+static void pack_A(int mc, int kc, const float* A, int lda, float alpha, float* packed) {
+    for (int ir = 0; ir < mc; ir += GEMM_MR) {
+        const int m = std::min(GEMM_MR, mc - ir);
+        for (int p = 0; p < kc; ++p) {
+            for (int r = 0; r < m; ++r) packed[r] = alpha * A[static_cast<size_t>(ir + r) * lda + p];
+            for (int r = m; r < GEMM_MR; ++r) packed[r] = 0.0f;
+            packed += GEMM_MR;
+        }
+    }
+}
+
+// Pack a kc x nc block of B (row stride ldb) into NR-column panels. Within a panel the
+// NR values of one row are contiguous; columns past nc are zero-padded.
+static void pack_B(int kc, int nc, const float* B, int ldb, float* packed) {
+    for (int jr = 0; jr < nc; jr += GEMM_NR) {
+        const int n = std::min(GEMM_NR, nc - jr);
+        for (int p = 0; p < kc; ++p) {
+            const float* b_row = B + static_cast<size_t>(p) * ldb + jr;
+            for (int c = 0; c < n; ++c) packed[c] = b_row[c];
+            for (int c = n; c < GEMM_NR; ++c) packed[c] = 0.0f;
+            packed += GEMM_NR;
+        }
+    }
+}
+
+// GELU, 0.5 v (1 + erf(v / sqrt(2))), without libm so that a loop over a tile row
+// vectorizes: erf by Abramowitz & Stegun 7.1.26 (absolute error below 1.5e-7, far inside
+// the epilogue tolerance) and exp(-x^2) by range reduction to 2^n e^r and a degree-6
+// polynomial, both branch-free. For |v| above about 12.6 the exp term is set to 0 (so no
+// subnormals slow it down) and GELU(v) becomes v or 0, as it does in float.
+static inline float gelu(float v) {
+    const float x = std::fabs(v) * 0.70710678f;
+    const float t = 1.0f / (1.0f + 0.3275911f * x);
+    const float poly = t * (0.254829592f + t * (-0.284496736f + t * (1.421413741f + t * (-1.453152027f + t * 1.061405429f))));
+    // e^y for y = -x^2, clamped where 2^n would leave the normal range.
+    const float y = std::max(-x * x, -80.0f);
+    const float n = (y * 1.44269504f + 12582912.0f) - 12582912.0f;  // round to nearest
+    const float r = (y - n * 0.693145752f) - n * 1.42860677e-6f;
+    const float e_r = 1.0f + r * (1.0f + r * (0.5f + r * (1.0f / 6 + r * (1.0f / 24 + r * (1.0f / 120 + r * (1.0f / 720))))));
+    const float scale = float_from_bits(static_cast<uint32_t>(static_cast<int32_t>(n) + 127) << 23);
+    const float h = y > -80.0f ? 0.5f * v * poly * (e_r * scale) : 0.0f;  // 0.5 v erfc(x)
+    return v >= 0.0f ? v - h : h;
+}
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+
+#if defined(__AVX512F__)
+typedef __m512 vec_t;
+constexpr int VEC_WIDTH = 16;
+static inline vec_t vec_zero() { return _mm512_setzero_ps(); }
+static inline vec_t vec_load(const float* p) { return _mm512_loadu_ps(p); }
+static inline vec_t vec_load_aligned(const float* p) { return _mm512_load_ps(p); }
+static inline void vec_store(float* p, vec_t v) { _mm512_storeu_ps(p, v); }
+static inline vec_t vec_broadcast(const float* p) { return _mm512_set1_ps(*p); }
+static inline vec_t vec_fmadd(vec_t a, vec_t b, vec_t c) { return _mm512_fmadd_ps(a, b, c); }
+static inline vec_t vec_set1(float x) { return _mm512_set1_ps(x); }
+static inline vec_t vec_add(vec_t a, vec_t b) { return _mm512_add_ps(a, b); }
+static inline vec_t vec_mul(vec_t a, vec_t b) { return _mm512_mul_ps(a, b); }
+// Masked form: GCC 12 warns about the undefined pass-through of _mm512_max_ps once inlined.
+static inline vec_t vec_max(vec_t a, vec_t b) { return _mm512_mask_max_ps(a, 0xFFFF, a, b); }
+#else
+typedef __m256 vec_t;
+constexpr int VEC_WIDTH = 8;
+static inline vec_t vec_zero() { return _mm256_setzero_ps(); }
+static inline vec_t vec_load(const float* p) { return _mm256_loadu_ps(p); }
+static inline vec_t vec_load_aligned(const float* p) { return _mm256_load_ps(p); }
+static inline void vec_store(float* p, vec_t v) { _mm256_storeu_ps(p, v); }
+static inline vec_t vec_broadcast(const float* p) { return _mm256_broadcast_ss(p); }
+static inline vec_t vec_fmadd(vec_t a, vec_t b, vec_t c) { return _mm256_fmadd_ps(a, b, c); }
+static inline vec_t vec_set1(float x) { return _mm256_set1_ps(x); }
+static inline vec_t vec_add(vec_t a, vec_t b) { return _mm256_add_ps(a, b); }
+static inline vec_t vec_mul(vec_t a, vec_t b) { return _mm256_mul_ps(a, b); }
+static inline vec_t vec_max(vec_t a, vec_t b) { return _mm256_max_ps(a, b); }
+#endif
+
+constexpr int NR_VECS = GEMM_NR / VEC_WIDTH;
+
+// C[0:MR, 0:NR] (row stride ldc) = c_scale * C + A_panel * B_panel, where c_scale is 1
+// for a further K block, beta for the first, and 0 (C not read) for the first without
+// beta. The tile starts from C rather than adding C at the end, so each element is reduced
+// over k in the same order as the reference loop. The last K block also adds the NR bias
+// values at bias (if any) and applies the activation before C is stored.
+static inline void micro_kernel(
+    int kc, const float* __restrict a, const float* __restrict b,
+    float* __restrict c, int ldc, float c_scale, const float* bias, Activation activation
+) {
+    vec_t acc[GEMM_MR][NR_VECS];
+    const vec_t scale = vec_set1(c_scale);
+    #pragma GCC unroll 16
+    for (int r = 0; r < GEMM_MR; ++r) {
+        const float* c_row = c + static_cast<size_t>(r) * ldc;
+        for (int v = 0; v < NR_VECS; ++v) {
+            if (c_scale == 0.0f) acc[r][v] = vec_zero();
+            else if (c_scale == 1.0f) acc[r][v] = vec_load(c_row + v * VEC_WIDTH);
+            else acc[r][v] = vec_mul(scale, vec_load(c_row + v * VEC_WIDTH));
+        }
+    }
+
+    for (int p = 0; p < kc; ++p) {
+        vec_t b_vec[NR_VECS];
+        // Packed B panels start 64-byte aligned and advance by NR floats.
+        for (int v = 0; v < NR_VECS; ++v) b_vec[v] = vec_load_aligned(b + v * VEC_WIDTH);
+        #pragma GCC unroll 16
+        for (int r = 0; r < GEMM_MR; ++r) {
+            vec_t a_vec = vec_broadcast(a + r);
+            for (int v = 0; v < NR_VECS; ++v) acc[r][v] = vec_fmadd(a_vec, b_vec[v], acc[r][v]);
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    if (bias) {
+        vec_t bias_vec[NR_VECS];
+        for (int v = 0; v < NR_VECS; ++v) bias_vec[v] = vec_load(bias + v * VEC_WIDTH);
+        #pragma GCC unroll 16
+        for (int r = 0; r < GEMM_MR; ++r) {
+            for (int v = 0; v < NR_VECS; ++v) acc[r][v] = vec_add(acc[r][v], bias_vec[v]);
+        }
+    }
+    if (activation == Activation::ReLU) {
+        #pragma GCC unroll 16
+        for (int r = 0; r < GEMM_MR; ++r) {
+            for (int v = 0; v < NR_VECS; ++v) acc[r][v] = vec_max(acc[r][v], vec_zero());
+        }
+    }
+
+    #pragma GCC unroll 16
+    for (int r = 0; r < GEMM_MR; ++r) {
+        float* c_row = c + static_cast<size_t>(r) * ldc;
+        for (int v = 0; v < NR_VECS; ++v) vec_store(c_row + v * VEC_WIDTH, acc[r][v]);
+    }
+    // GELU runs over the stored tile while it is still in L1 (the loop vectorizes).
+    if (activation == Activation::GELU) {
+        for (int r = 0; r < GEMM_MR; ++r) {
+            float* c_row = c + static_cast<size_t>(r) * ldc;
+            for (int j = 0; j < GEMM_NR; ++j) c_row[j] = gelu(c_row[j]);
+        }
+    }
+}
+
+#else
+
+// Portable micro-kernel; the compiler vectorizes the inner loop over NR.
+static inline void micro_kernel(
+    int kc, const float* __restrict a, const float* __restrict b,
+    float* __restrict c, int ldc, float c_scale, const float* bias, Activation activation
+) {
+    float acc[GEMM_MR][GEMM_NR];
+    for (int r = 0; r < GEMM_MR; ++r)
+        for (int j = 0; j < GEMM_NR; ++j) acc[r][j] = c_scale != 0.0f ? c_scale * c[static_cast<size_t>(r) * ldc + j] : 0.0f;
+    for (int p = 0; p < kc; ++p) {
+        for (int r = 0; r < GEMM_MR; ++r)
+            for (int j = 0; j < GEMM_NR; ++j) acc[r][j] += a[r] * b[j];
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+    for (int r = 0; r < GEMM_MR; ++r) {
+        float* c_row = c + static_cast<size_t>(r) * ldc;
+        for (int j = 0; j < GEMM_NR; ++j) {
+            const float v = bias ? acc[r][j] + bias[j] : acc[r][j];
+            c_row[j] = activation == Activation::GELU ? gelu(v) : activate(activation, v);
+        }
+    }
+}
+
+#endif
+
+// Edge tiles (m < MR or n < NR) run the full micro-kernel on a scratch tile and copy
+// the valid part, so the hot path never branches on tile size.
+static inline void micro_kernel_edge(
+    int m, int n, int kc, const float* a, const float* b,
+    float* c, int ldc, float c_scale, const float* bias, Activation activation
+) {
+    alignas(64) float tile[GEMM_MR * GEMM_NR] = {};
+    for (int r = 0; r < m && c_scale != 0.0f; ++r)
+        for (int j = 0; j < n; ++j) tile[r * GEMM_NR + j] = c[static_cast<size_t>(r) * ldc + j];
+    micro_kernel(kc, a, b, tile, GEMM_NR, c_scale, bias, activation);
+    for (int r = 0; r < m; ++r)
+        for (int j = 0; j < n; ++j) c[static_cast<size_t>(r) * ldc + j] = tile[r * GEMM_NR + j];
+}
+
+// B is packed per (jc, pc) block unless it is stored pre-packed: in the blocked layout
+// with NR-column tiles (data_helper.h), a tile row of KC rows holds the packed panels of
+// every (jc, pc) block in the order pack_B() writes them, so the kernel reads them in
+// place and KC is the layout's tile height. Comparing runs on a row-major and a pre-packed
+// B (tasks gemm and gemm_prepacked) isolates the cost of packing B; the pack_B phase is
+// the time spent in pack_B() per run.
+//
+// The epilogue (C = act(alpha A B + beta C_init + bias)) is fused: alpha scales A as it is
+// packed, the first K block starts from beta * C, and the last one adds the bias and
+// applies the activation before storing C. The bias is kept zero-padded to whole NR
+// panels so that edge tiles read it like full ones.
+static TensorLayout layout_B;
+static AlignedBuffer packed_A, packed_B, padded_bias;
+static Epilogue epilogue;
+
+static bool setup(const MatMulProblem& problem) {
+    layout_B = problem.layout_B;
+    epilogue = GEMM_FUSE_EPILOGUE ? problem.epilogue : Epilogue{};
+    if (epilogue.bias) {
+        const size_t padded_J = static_cast<size_t>(problem.J + GEMM_NR - 1) / GEMM_NR * GEMM_NR;
+        padded_bias = make_aligned_buffer(padded_J);
+        if (!padded_bias) return false;
+        std::fill(padded_bias.get(), padded_bias.get() + padded_J, 0.0f);
+        std::copy(epilogue.bias, epilogue.bias + problem.J, padded_bias.get());
+    }
+    // Packing buffers are sized for the largest blocks and reused across runs.
+    const bool prepacked = layout_B.kind == LayoutKind::Blocked;
+    const int kc_max = prepacked ? layout_B.block_rows : GEMM_KC;
+    packed_A = make_aligned_buffer(static_cast<size_t>(GEMM_MC) * kc_max);
+    if (!prepacked) packed_B = make_aligned_buffer(static_cast<size_t>(GEMM_KC) * GEMM_NC);
+    return packed_A && (prepacked || packed_B);
+}
+
+void matmul(
+    const float* A, // I x K
+    const float* B, // K x J, row-major or pre-packed
+    float* C,       // I x J, C_init on entry
+    int I, int J, int K,
+    RunContext& ctx
+) {
+    const bool prepacked = layout_B.kind == LayoutKind::Blocked;
+    const int KC = prepacked ? layout_B.block_rows : GEMM_KC;
+    const size_t padded_J = static_cast<size_t>(J + GEMM_NR - 1) / GEMM_NR * GEMM_NR;
+    int64_t pack_B_ns = 0;
+
+    for (int jc = 0; jc < J; jc += GEMM_NC) {
+        const int nc = std::min(GEMM_NC, J - jc);
+        for (int pc = 0; pc < K; pc += KC) {
+            const int kc = std::min(KC, K - pc);
+            const float c_scale = pc > 0 ? 1.0f : epilogue.beta;
+            const bool last = pc + kc == K;
+            const float* bias = last && epilogue.bias ? padded_bias.get() + jc : nullptr;
+            const Activation activation = last ? epilogue.activation : Activation::None;
+            const float* b_block;
+            if (prepacked) {
+                b_block = B + pc * padded_J + static_cast<size_t>(jc) * kc;
+            } else {
+                TRACE_SCOPE("pack_B");
+                const auto start = std::chrono::steady_clock::now();
+                pack_B(kc, nc, B + static_cast<size_t>(pc) * J + jc, J, packed_B.get());
+                pack_B_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                b_block = packed_B.get();
+            }
+
+            for (int ic = 0; ic < I; ic += GEMM_MC) {
+                const int mc = std::min(GEMM_MC, I - ic);
+                {
+                    TRACE_SCOPE("pack_A");
+                    pack_A(mc, kc, A + static_cast<size_t>(ic) * K + pc, K, epilogue.alpha, packed_A.get());
+                }
+                TRACE_SCOPE("macro-kernel");
+
+                for (int jr = 0; jr < nc; jr += GEMM_NR) {
+                    const int n = std::min(GEMM_NR, nc - jr);
+                    const float* b_panel = b_block + static_cast<size_t>(jr) * kc;
+                    for (int ir = 0; ir < mc; ir += GEMM_MR) {
+                        const int m = std::min(GEMM_MR, mc - ir);
+                        const float* a_panel = packed_A.get() + static_cast<size_t>(ir) * kc;
+                        float* c_tile = C + static_cast<size_t>(ic + ir) * J + jc + jr;
+                        const float* b_bias = bias ? bias + jr : nullptr;
+                        if (m == GEMM_MR && n == GEMM_NR) {
+                            micro_kernel(kc, a_panel, b_panel, c_tile, J, c_scale, b_bias, activation);
+                        } else {
+                            micro_kernel_edge(m, n, kc, a_panel, b_panel, c_tile, J, c_scale, b_bias, activation);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    ctx.add_phase("pack_B", pack_B_ns);
+}
+
+int main(int argc, char* argv[]) {
+    MatMulKernel kernel(matmul);
+    kernel.setup = setup;
+    kernel.fuses_epilogue = GEMM_FUSE_EPILOGUE;
+    kernel.accepts_B = [](const TensorLayout& layout) {
+        return layout.row_major() || (layout.kind == LayoutKind::Blocked && layout.block_cols == GEMM_NR);
+    };
+    kernel.preferred_B = TensorLayout{LayoutKind::Blocked, GEMM_KC, GEMM_NR};
+    kernel.parameters = {{"GEMM_MC", GEMM_MC}, {"GEMM_KC", GEMM_KC}, {"GEMM_NC", GEMM_NC},
+                         {"GEMM_MR", GEMM_MR}, {"GEMM_NR", GEMM_NR}, {"GEMM_FUSE_EPILOGUE", GEMM_FUSE_EPILOGUE}};
+    kernel.describe = [](int, int, int) {
+        const std::string blocks = "MR " + std::to_string(GEMM_MR) + ", NR " + std::to_string(GEMM_NR);
+        if (layout_B.kind == LayoutKind::Blocked) {
+            return blocks + ", KC " + std::to_string(layout_B.block_rows) + ", B pre-packed";
+        }
+        return blocks + ", KC " + std::to_string(GEMM_KC) + ", B packed per block";
+    };
+    return harness_main(argc, argv, kernel);
+}
@@ -1,14 +1,5 @@
-#include "data_helper.h"
-#include <iostream>
-#include <fstream>
-#include <vector>
-#include <string>
-#include <cstdlib>
-#include <limits>
-#include <iomanip>
-#include <cmath>
+#include "harness.h"
 #include <algorithm>
-#include <chrono>
 
 #ifndef TILE_I
 #define TILE_I 32
@@ -22,33 +13,53 @@
 #define TILE_K 32
 #endif
 
-#ifndef WARMUP_RUNS
-#define WARMUP_RUNS 3
-#endif
+// Epilogue of the problem (C = act(alpha A B + beta C_init + bias)), set by setup() and
+// fused into the write-back of C: the kernels below take EPILOGUE = false for the plain
+// C = A * B and true otherwise.
+static Epilogue epilogue;
+
+// Start and end of the sum of one K tile of element (i, j) of C at c. Without the epilogue
+// the sum accumulates in C; with it, C accumulates beta * C_init + alpha * (tile sums) and
+// the last tile applies the bias and activation.
+template <bool EPILOGUE>
+static inline float tile_start(const float* c, bool first) {
+    if constexpr (EPILOGUE) return 0.0f;
+    else return first ? 0.0f : *c;
+}
 
-#ifndef EVAL_RUNS
-#define EVAL_RUNS 5
-#endif
+template <bool EPILOGUE>
+static inline void tile_end(float* c, float sum, bool first, bool last, int j) {
+    if constexpr (EPILOGUE) {
+        const float v = (first ? epilogue.initial(*c) : *c) + epilogue.alpha * sum;
+        *c = last ? epilogue.finish(v, j) : v;
+    } else {
+        *c = sum;
+    }
+}
 
-void matmul(
-    const std::vector<float>& A, // I x K
-    const std::vector<float>& B, // K x J
-    std::vector<float>& C,       // I x J, output
+// Tiled loop nest; the tile sizes are template parameters so that tuned configurations
+// (MATMUL_TUNED_TILES) can live next to the TILE_I/J/K default in one binary.
+template <int TI, int TJ, int TK, bool EPILOGUE>
+void matmul_tiled(
+    const float* A, // I x K
+    const float* B, // K x J
+    float* C,       // I x J, output
     int I, int J, int K
 ) {
-    for (int ii = 0; ii < I; ii += TILE_I) {
-        int i_max = std::min(ii + TILE_I, I);
-        for (int jj = 0; jj < J; jj += TILE_J) {
-            int j_max = std::min(jj + TILE_J, J);
-            for (int kk = 0; kk < K; kk += TILE_K) {
-                int k_max = std::min(kk + TILE_K, K);
+    for (int ii = 0; ii < I; ii += TI) {
+        TRACE_SCOPE("row block");
+        int i_max = std::min(ii + TI, I);
+        for (int jj = 0; jj < J; jj += TJ) {
+            int j_max = std::min(jj + TJ, J);
+            for (int kk = 0; kk < K; kk += TK) {
+                int k_max = std::min(kk + TK, K);
                 for (int i = ii; i < i_max; ++i) {
                     for (int j = jj; j < j_max; ++j) {
-                        float sum = (kk == 0) ? 0.0f : C[i * J + j];
+                        float sum = tile_start<EPILOGUE>(&C[i * J + j], kk == 0);
                         for (int k = kk; k < k_max; ++k) {
                             sum += A[i * K + k] * B[k * J + j];
                         }
-                        C[i * J + j] = sum;
+                        tile_end<EPILOGUE>(&C[i * J + j], sum, kk == 0, k_max == K, j);
                     }
                 }
             }
@@ -56,138 +67,117 @@ void matmul(
     }
 }
 
-int main(int argc, char* argv[]) {
-    if (argc < 5) {
-        std::cerr << "Usage: " << argv[0] << " <input_A.txt> <input_B.txt> <input_C.txt> <output_C.txt>" << std::endl;
-        return 1;
-    }
-
-    std::string file_A = argv[1];
-    std::string file_B = argv[2];
-    std::string file_init_C = argv[3];
-    std::string file_expected_C = argv[4];
-
-    std::vector<float> A;
-    std::vector<int> dim_A;
-    if (!read_matrix(file_A, A, dim_A)) {
-        std::cerr << "Failed to read " << file_A << std::endl;
-        return 2;
-    }
-    if (dim_A.size() != 2) {
-        std::cerr << "Expected 2D matrix in " << file_A << std::endl;
-        return 2;
-    }
-    int I = dim_A[0], K = dim_A[1];
-
-    std::vector<float> B;
-    std::vector<int> dim_B;
-    if (!read_matrix(file_B, B, dim_B)) {
-        std::cerr << "Failed to read " << file_B << std::endl;
-        return 2;
-    }
-    if (dim_B.size() != 2 || dim_B[0] != K) {
-        std::cerr << "Mismatched K dimension between " << file_A << " (" << K << ") and " << file_B << "\n";
-        return 2;
-    }
-    int J = dim_B[1];
-
-    // Read initial C
-    std::vector<float> init_C;
-    std::vector<int> dim_init_C;
-    if (!read_matrix(file_init_C, init_C, dim_init_C)) {
-        std::cerr << "Failed to read " << file_init_C << std::endl;
-        return 2;
-    }
-    if (dim_init_C.size() != 2 || dim_init_C[0] != I || dim_init_C[1] != J) {
-        std::cerr << "Initial C dims don't match input dims " << I << "x" << J << std::endl;
-        return 2;
-    }
-
-    std::vector<float> expected_C;
-    std::vector<int> dim_C;
-    if (!read_matrix(file_expected_C, expected_C, dim_C)) {
-        std::cerr << "Failed to read " << file_expected_C << std::endl;
-        return 2;
-    }
-    if (dim_C.size() != 2 || dim_C[0] != I || dim_C[1] != J) {
-        std::cerr << "Expected output C dims don't match input dims " << I << "x" << J << std::endl;
-        return 2;
-    }
+template <bool EPILOGUE>
+void matmul_generic(
+    const float* A, // I x K
+    const float* B, // K x J
+    float* C,       // I x J, output
+    int I, int J, int K
+) {
+    matmul_tiled<TILE_I, TILE_J, TILE_K, EPILOGUE>(A, B, C, I, J, K);
+}
 
-    constexpr int num_warmup = WARMUP_RUNS;
-    constexpr int num_evals = EVAL_RUNS;
-    std::vector<float> calc_C(I * J, 0.0f);
-    std::vector<int64_t> warmup_times_ns;
-
-    for (int w = 0; w < num_warmup; ++w) {
-        std::copy(init_C.begin(), init_C.end(), calc_C.begin());
-        auto start = std::chrono::high_resolution_clock::now();
-        matmul(A, B, calc_C, I, J, K);
-        auto end = std::chrono::high_resolution_clock::now();
-        int64_t duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
-        warmup_times_ns.push_back(duration_ns);
-    }
+// Compile-time specialization for fixed problem shapes. Build with e.g.
+//   -DMATMUL_FIXED_SHAPES="FIXED_SHAPE(10,500,64) FIXED_SHAPE(512,512,512)"
+// to instantiate matmul_fixed<I, J, K> for each shape; matmul() dispatches on the runtime
+// dimensions and falls back to matmul_generic() for any other shape.
+
+// Tile size for a compile-time dimension: the dimension itself if it fits in one tile,
+// otherwise the largest divisor of dim in [pref / 2, pref] (so there are no remainder
+// tiles), or 0 if there is none.
+constexpr int fixed_tile(int dim, int pref) {
+    if (dim <= pref) return dim;
+    for (int t = pref; t >= pref / 2 && t > 0; --t)
+        if (dim % t == 0) return t;
+    return 0;
+}
 
-    std::vector<int64_t> eval_times_ns;
-    int64_t total_time_ns = 0;
-    int64_t min_time_ns = std::numeric_limits<int64_t>::max();
-    int64_t max_time_ns = 0;
-    for (int t = 0; t < num_evals; ++t) {
-        std::copy(init_C.begin(), init_C.end(), calc_C.begin());
-        auto start = std::chrono::high_resolution_clock::now();
-        matmul(A, B, calc_C, I, J, K);
-        auto end = std::chrono::high_resolution_clock::now();
-        int64_t duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
-        eval_times_ns.push_back(duration_ns);
-        total_time_ns += duration_ns;
-        if (duration_ns < min_time_ns) min_time_ns = duration_ns;
-        if (duration_ns > max_time_ns) max_time_ns = duration_ns;
+template <int I, int J, int K, bool EPILOGUE>
+void matmul_fixed(const float* __restrict A, const float* __restrict B, float* __restrict C) {
+    constexpr int TI = fixed_tile(I, TILE_I);
+    constexpr int TJ = fixed_tile(J, TILE_J);
+    constexpr int TK = fixed_tile(K, TILE_K);
+    if constexpr (TI == 0 || TJ == 0 || TK == 0) {
+        // No remainder-free tiling for this shape; constant dims still help the generic loop.
+        matmul_generic<EPILOGUE>(A, B, C, I, J, K);
+    } else {
+        for (int ii = 0; ii < I; ii += TI) {
+            TRACE_SCOPE("row block");
+            for (int jj = 0; jj < J; jj += TJ) {
+                for (int kk = 0; kk < K; kk += TK) {
+                    for (int i = ii; i < ii + TI; ++i) {
+                        for (int j = jj; j < jj + TJ; ++j) {
+                            float sum = tile_start<EPILOGUE>(&C[i * J + j], kk == 0);
+                            for (int k = kk; k < kk + TK; ++k) {
+                                sum += A[i * K + k] * B[k * J + j];
+                            }
+                            tile_end<EPILOGUE>(&C[i * J + j], sum, kk == 0, kk + TK == K, j);
+                        }
+                    }
+                }
+            }
+        }
     }
-    double avg_time_ns = static_cast<double>(total_time_ns) / num_evals;
-
-    int num_mismatches = 0;
-    float max_diff = 0;
-    size_t worst_idx = static_cast<size_t>(-1);
-
-    bool equal = compare_matrices(calc_C, expected_C, dim_C, num_mismatches, max_diff, worst_idx);
+}
 
-    std::ofstream logfs("comparison.log");
-    logfs << std::setprecision(std::numeric_limits<float>::max_digits10);
+// Per-shape tile sizes found by the tuning task (tasks/tune/MatMul). Build with e.g.
+//   -DMATMUL_TUNED_TILES="TUNED_TILES(512,512,512, 64,128,256)"
+// to use tiles 64x128x256 for a 512x512x512 problem; other shapes use TILE_I/J/K.
 
-    if (equal) {
-        logfs << "PASS: Calculated C matches expected output (" << I << "x" << J << ").\n";
-        logfs << "Max diff: " << max_diff << "\n";
-        std::cout << "PASS: Calculated C matches expected output (" << I << "x" << J << ")." << std::endl;
-        std::cout << "Max diff: " << max_diff << std::endl;
-    } else {
-        std::vector<int> worst_idx_vec = linear_to_index(worst_idx, dim_C);
-        logfs << "FAIL: " << num_mismatches << " element(s) mismatched (max diff = " << max_diff << ").\n";
-        logfs << "Max diff: " << max_diff << " at index ";
-        for (size_t i = 0; i < worst_idx_vec.size(); ++i) logfs << (i ? "," : "") << worst_idx_vec[i];
-        logfs << "\n";
-        logfs << "Max diff sample: calc_C = " << calc_C[worst_idx] << ", expected_C = " << expected_C[worst_idx] << '\n';
-        std::cout << "FAIL: See comparison.log for details" << std::endl;
-        std::cout << "Max diff: " << max_diff << std::endl;
-    }
+// Name of the kernel matmul() uses for the given shape.
+const char* matmul_kernel_name(int I, int J, int K) {
+#ifdef MATMUL_FIXED_SHAPES
+#define FIXED_SHAPE(i, j, k) if (I == (i) && J == (j) && K == (k)) return "fixed " #i "x" #j "x" #k;
+    MATMUL_FIXED_SHAPES
+#undef FIXED_SHAPE
+#endif
+#ifdef MATMUL_TUNED_TILES
+#define TUNED_TILES(i, j, k, ti, tj, tk) if (I == (i) && J == (j) && K == (k)) return "tuned " #ti "x" #tj "x" #tk;
+    MATMUL_TUNED_TILES
+#undef TUNED_TILES
+#endif
+    (void)I; (void)J; (void)K;
+    return "generic";
+}
 
-    logfs.close();
+template <bool EPILOGUE>
+void matmul_shape(
+    const float* A, // I x K
+    const float* B, // K x J
+    float* C,       // I x J, output
+    int I, int J, int K
+) {
+#ifdef MATMUL_FIXED_SHAPES
+#define FIXED_SHAPE(i, j, k) if (I == (i) && J == (j) && K == (k)) { matmul_fixed<(i), (j), (k), EPILOGUE>(A, B, C); return; }
+    MATMUL_FIXED_SHAPES
+#undef FIXED_SHAPE
+#endif
+#ifdef MATMUL_TUNED_TILES
+#define TUNED_TILES(i, j, k, ti, tj, tk) if (I == (i) && J == (j) && K == (k)) { matmul_tiled<(ti), (tj), (tk), EPILOGUE>(A, B, C, I, J, K); return; }
+    MATMUL_TUNED_TILES
+#undef TUNED_TILES
+#endif
+    matmul_generic<EPILOGUE>(A, B, C, I, J, K);
+}
 
-    std::ofstream ofs_eval("runtimes");
-    for (int64_t t : eval_times_ns) {
-        ofs_eval << t << "\n";
-    }
-    ofs_eval.close();
+void matmul(
+    const float* A, // I x K
+    const float* B, // K x J
+    float* C,       // I x J, C_init on entry
+    int I, int J, int K
+) {
+    if (epilogue.identity()) matmul_shape<false>(A, B, C, I, J, K);
+    else matmul_shape<true>(A, B, C, I, J, K);
+}
 
-    std::ofstream ofs_warmup("runtimes_warmup");
-    for (int64_t t : warmup_times_ns) {
-        ofs_warmup << t << "\n";
-    }
-    ofs_warmup.close();
-
-    std::cout << "Timing (ns): avg = " << static_cast<int64_t>(avg_time_ns)
-              << ", min = " << min_time_ns
-              << ", max = " << max_time_ns << std::endl;
-    std::cout << "MatMul (" << I << "x" << K << ") x (" << K << "x" << J << "): "
-              << num_evals << " evals, " << num_warmup << " warmups\n";
-    return equal ? 0 : 1;
+int main(int argc, char* argv[]) {
+    MatMulKernel kernel(matmul);
+    kernel.describe = [](int I, int J, int K) { return std::string(matmul_kernel_name(I, J, K)); };
+    kernel.setup = [](const MatMulProblem& problem) {
+        epilogue = problem.epilogue;
+        return true;
+    };
+    kernel.fuses_epilogue = true;
+    kernel.parameters = {{"TILE_I", TILE_I}, {"TILE_J", TILE_J}, {"TILE_K", TILE_K}};
+    return harness_main(argc, argv, kernel);
 }
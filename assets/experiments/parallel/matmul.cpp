@@ -0,0 +1,384 @@
+#include "harness.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <pthread.h>
+#include <sched.h>
+
+#ifndef TILE_I
+#define TILE_I 32
+#endif
+
+#ifndef TILE_J
+#define TILE_J 32
+#endif
+
+#ifndef TILE_K
+#define TILE_K 32
+#endif
+
+// Runtime configuration, read from the environment so one binary serves every node:
+//   MATMUL_THREADS   number of threads (default: CPUs in the process affinity mask,
+//                    which SLURM limits to the allocated cores)
+//   MATMUL_SCHEDULE  "static" (2D partition of the C tile grid), "steal" (per-thread
+//                    tile ranges with work stealing), or "numa" (threads split over the
+//                    NUMA nodes, each node's threads take a static 2D partition of the
+//                    node's row block of C); default static
+//   MATMUL_PINNING   "none", "compact" (consecutive allowed CPUs) or "scatter"
+//                    (round-robin over sockets); default compact. The numa schedule
+//                    always pins threads to the CPUs of their node ("node").
+// With the numa schedule, the row blocks are the ones the harness placed A and C by
+// (MATMUL_NUMA=partition), and threads read their node's replica of B if there is one.
+enum class Schedule { Static, Steal, Numa };
+enum class Pinning { None, Compact, Scatter, Node };
+
+struct ParallelConfig {
+    int threads = 1;
+    Schedule schedule = Schedule::Static;
+    Pinning pinning = Pinning::Compact;
+    // Numa schedule: node n (of topology) runs threads [node_threads[n], node_threads[n + 1]).
+    NumaTopology topology;
+    std::vector<int> node_threads;
+};
+
+static const char* schedule_name(Schedule s) {
+    switch (s) {
+        case Schedule::Static: return "static";
+        case Schedule::Steal: return "steal";
+        default: return "numa";
+    }
+}
+
+static const char* pinning_name(Pinning p) {
+    switch (p) {
+        case Pinning::None: return "none";
+        case Pinning::Compact: return "compact";
+        case Pinning::Scatter: return "scatter";
+        default: return "node";
+    }
+}
+
+static int cpu_package(int cpu) {
+    std::ifstream ifs("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/physical_package_id");
+    int package = 0;
+    if (!(ifs >> package)) return 0;
+    return package;
+}
+
+// Order allowed CPUs so that thread t is pinned to cpus[t % cpus.size()].
+static std::vector<int> pinning_order(const ParallelConfig& cfg) {
+    std::vector<int> cpus = affinity_cpus();
+    if (cfg.pinning == Pinning::Node) {
+        std::vector<int> order;
+        for (int n = 0; n < cfg.topology.size(); ++n) {
+            const std::vector<int>& node_cpus = cfg.topology.cpus[n];
+            for (int t = cfg.node_threads[n]; t < cfg.node_threads[n + 1]; ++t)
+                order.push_back(node_cpus[static_cast<size_t>(t - cfg.node_threads[n]) % node_cpus.size()]);
+        }
+        return order;
+    }
+    if (cfg.pinning != Pinning::Scatter) return cpus;
+
+    std::vector<std::vector<int>> by_package;
+    for (int c : cpus) {
+        size_t p = static_cast<size_t>(cpu_package(c));
+        if (p >= by_package.size()) by_package.resize(p + 1);
+        by_package[p].push_back(c);
+    }
+    std::vector<int> order;
+    for (size_t round = 0; order.size() < cpus.size(); ++round) {
+        for (const auto& pkg : by_package)
+            if (round < pkg.size()) order.push_back(pkg[round]);
+    }
+    return order;
+}
+
+static ParallelConfig config_from_env() {
+    ParallelConfig cfg;
+    cfg.threads = static_cast<int>(affinity_cpus().size());
+    if (const char* v = std::getenv("MATMUL_THREADS")) {
+        int n = std::atoi(v);
+        if (n > 0) cfg.threads = n;
+    }
+    if (const char* v = std::getenv("MATMUL_SCHEDULE")) {
+        std::string s = v;
+        if (s == "steal") cfg.schedule = Schedule::Steal;
+        else if (s == "numa") cfg.schedule = Schedule::Numa;
+        else if (s != "static") std::cerr << "Unknown MATMUL_SCHEDULE '" << s << "', using static" << std::endl;
+    }
+    if (const char* v = std::getenv("MATMUL_PINNING")) {
+        std::string s = v;
+        if (s == "none") cfg.pinning = Pinning::None;
+        else if (s == "scatter") cfg.pinning = Pinning::Scatter;
+        else if (s != "compact") std::cerr << "Unknown MATMUL_PINNING '" << s << "', using compact" << std::endl;
+    }
+    if (cfg.schedule == Schedule::Numa) {
+        // Every node gets one thread and the rest in proportion to its CPUs.
+        cfg.pinning = Pinning::Node;
+        cfg.topology = numa_topology();
+        const int nodes = cfg.topology.size();
+        cfg.threads = std::max(cfg.threads, nodes);
+        size_t total_cpus = 0, cpus_before = 0;
+        for (const auto& cpus : cfg.topology.cpus) total_cpus += cpus.size();
+        for (int n = 0; n <= nodes; ++n) {
+            cfg.node_threads.push_back(n + static_cast<int>((cfg.threads - nodes) * cpus_before / total_cpus));
+            if (n < nodes) cpus_before += cfg.topology.cpus[n].size();
+        }
+    }
+    return cfg;
+}
+
+static void pin_current_thread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// Let the calling thread run on all CPUs of the process again.
+static void unpin_current_thread() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : affinity_cpus()) CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// Persistent pool so thread creation is not part of the timed region. The calling
+// thread takes part as thread 0 (pinned for the lifetime of the pool).
+class ThreadPool {
+public:
+    explicit ThreadPool(const ParallelConfig& cfg) : num_threads_(cfg.threads) {
+        std::vector<int> cpus;
+        if (cfg.pinning != Pinning::None) cpus = pinning_order(cfg);
+        pinned_caller_ = !cpus.empty();
+        if (pinned_caller_) pin_current_thread(cpus[0]);
+        for (int t = 1; t < num_threads_; ++t) {
+            int cpu = cpus.empty() ? -1 : cpus[static_cast<size_t>(t) % cpus.size()];
+            workers_.emplace_back([this, t, cpu] { worker_loop(t, cpu); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_cv_.notify_all();
+        for (auto& w : workers_) w.join();
+        if (pinned_caller_) unpin_current_thread();
+    }
+
+    int size() const { return num_threads_; }
+
+    // Run fn(thread_id) on every thread and wait for all of them.
+    void run(const std::function<void(int)>& fn) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &fn;
+            pending_ = num_threads_ - 1;
+            ++generation_;
+        }
+        start_cv_.notify_all();
+        fn(0);
+        TRACE_SCOPE("wait for workers");
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return pending_ == 0; });
+        job_ = nullptr;
+    }
+
+private:
+    void worker_loop(int id, int cpu) {
+        if (cpu >= 0) pin_current_thread(cpu);
+        TRACE_THREAD_NAME("worker " + std::to_string(id));
+        unsigned long seen = 0;
+        while (true) {
+            const std::function<void(int)>* job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                if (stop_) return;
+                seen = generation_;
+                job = job_;
+            }
+            (*job)(id);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--pending_ == 0) done_cv_.notify_one();
+            }
+        }
+    }
+
+    int num_threads_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable start_cv_, done_cv_;
+    const std::function<void(int)>* job_ = nullptr;
+    unsigned long generation_ = 0;
+    int pending_ = 0;
+    bool stop_ = false;
+    bool pinned_caller_ = false;
+};
+
+// Configuration of the current problem and its pool. setup() reads the environment again
+// for every problem, so that the cases of a benchmark server (matmul --serve) run with
+// their own MATMUL_THREADS, MATMUL_SCHEDULE, and MATMUL_PINNING.
+static ParallelConfig config;
+static std::unique_ptr<ThreadPool> pool;
+
+// Switch to the environment's configuration; the pool is rebuilt only if that differs.
+static void configure_from_env() {
+    ParallelConfig cfg = config_from_env();
+    if (pool && cfg.threads == config.threads && cfg.schedule == config.schedule && cfg.pinning == config.pinning)
+        return;
+    pool.reset();
+    config = std::move(cfg);
+    pool.reset(new ThreadPool(config));
+}
+
+// One TILE_I x TILE_J tile of C over the full K range (the tiled loop nest of the
+// optimized competitor); tiles are independent, so threads never share C elements.
+static inline void matmul_tile(
+    const float* A, const float* B, float* C,
+    int I, int J, int K, int ii, int jj
+) {
+    int i_max = std::min(ii + TILE_I, I);
+    int j_max = std::min(jj + TILE_J, J);
+    for (int kk = 0; kk < K; kk += TILE_K) {
+        int k_max = std::min(kk + TILE_K, K);
+        for (int i = ii; i < i_max; ++i) {
+            for (int j = jj; j < j_max; ++j) {
+                float sum = (kk == 0) ? 0.0f : C[static_cast<size_t>(i) * J + j];
+                for (int k = kk; k < k_max; ++k) {
+                    sum += A[static_cast<size_t>(i) * K + k] * B[static_cast<size_t>(k) * J + j];
+                }
+                C[static_cast<size_t>(i) * J + j] = sum;
+            }
+        }
+    }
+}
+
+// Choose a rows x cols thread grid (rows * cols == threads) that minimizes the largest
+// number of tiles per thread.
+static void thread_grid(int threads, int tiles_i, int tiles_j, int& rows, int& cols) {
+    rows = threads;
+    cols = 1;
+    long best = std::numeric_limits<long>::max();
+    for (int r = 1; r <= threads; ++r) {
+        if (threads % r != 0) continue;
+        int c = threads / r;
+        long load = static_cast<long>((tiles_i + r - 1) / r) * ((tiles_j + c - 1) / c);
+        if (load < best) {
+            best = load;
+            rows = r;
+            cols = c;
+        }
+    }
+}
+
+// Static 2D partition of the tile grid of the rows x cols problem over threads; thread t
+// computes its part.
+static void static_tiles(const float* A, const float* B, float* C, int rows, int J, int K, int threads, int t) {
+    const int tiles_i = (rows + TILE_I - 1) / TILE_I;
+    const int tiles_j = (J + TILE_J - 1) / TILE_J;
+    int grid_rows, grid_cols;
+    thread_grid(threads, tiles_i, tiles_j, grid_rows, grid_cols);
+    const int r = t / grid_cols, c = t % grid_cols;
+    const int ti_begin = static_cast<int>(static_cast<long>(tiles_i) * r / grid_rows);
+    const int ti_end = static_cast<int>(static_cast<long>(tiles_i) * (r + 1) / grid_rows);
+    const int tj_begin = static_cast<int>(static_cast<long>(tiles_j) * c / grid_cols);
+    const int tj_end = static_cast<int>(static_cast<long>(tiles_j) * (c + 1) / grid_cols);
+    TRACE_SCOPE("tiles");
+    for (int ti = ti_begin; ti < ti_end; ++ti)
+        for (int tj = tj_begin; tj < tj_end; ++tj)
+            matmul_tile(A, B, C, rows, J, K, ti * TILE_I, tj * TILE_J);
+}
+
+// Placement of the problem's operands, from setup().
+static MatMulProblem problem;
+
+// Per-thread range of linearized tile indices; padded so counters don't share a line.
+struct alignas(64) TileRange {
+    std::atomic<long> next{0};
+    long end = 0;
+};
+
+void matmul(
+    const float* A, // I x K
+    const float* B, // K x J
+    float* C,       // I x J, output
+    int I, int J, int K
+) {
+    const int threads = pool->size();
+    const int tiles_i = (I + TILE_I - 1) / TILE_I;
+    const int tiles_j = (J + TILE_J - 1) / TILE_J;
+
+    if (config.schedule == Schedule::Static) {
+        pool->run([&](int t) { static_tiles(A, B, C, I, J, K, threads, t); });
+        return;
+    }
+
+    if (config.schedule == Schedule::Numa) {
+        // Row blocks as the harness placed them, else split the same way.
+        const int nodes = config.topology.size();
+        const bool placed = problem.numa && problem.numa->mode == NumaMode::Partition &&
+                            problem.numa->topology.size() == nodes;
+        const std::vector<int> row_begin = placed ? problem.numa->row_begin
+                                                  : numa_row_partition(I, config.topology, TILE_I);
+        const bool replicated = B == problem.B && static_cast<int>(problem.B_replicas.size()) == nodes;
+        pool->run([&](int t) {
+            const int n = static_cast<int>(std::upper_bound(config.node_threads.begin(), config.node_threads.end(), t) -
+                                           config.node_threads.begin()) - 1;
+            const int first_row = row_begin[n];
+            static_tiles(A + static_cast<size_t>(first_row) * K, replicated ? problem.B_replicas[n] : B,
+                         C + static_cast<size_t>(first_row) * J, row_begin[n + 1] - first_row, J, K,
+                         config.node_threads[n + 1] - config.node_threads[n], t - config.node_threads[n]);
+        });
+        return;
+    }
+
+    // Work stealing: each thread starts on its own contiguous (row-major) tile range and,
+    // once that is drained, claims remaining tiles from the other threads' ranges.
+    const long num_tiles = static_cast<long>(tiles_i) * tiles_j;
+    std::vector<TileRange> ranges(static_cast<size_t>(threads));
+    for (int t = 0; t < threads; ++t) {
+        ranges[t].next.store(num_tiles * t / threads, std::memory_order_relaxed);
+        ranges[t].end = num_tiles * (t + 1) / threads;
+    }
+    pool->run([&](int t) {
+        for (int v = 0; v < threads; ++v) {
+            TileRange& range = ranges[(t + v) % threads];
+            long tile = range.next.fetch_add(1, std::memory_order_relaxed);
+            if (tile >= range.end) continue;
+            // One event per range a thread takes tiles from: its own, then the ones it steals from.
+            TRACE_SCOPE(v == 0 ? "tiles" : "stolen tiles");
+            do {
+                matmul_tile(A, B, C, I, J, K,
+                            static_cast<int>(tile / tiles_j) * TILE_I,
+                            static_cast<int>(tile % tiles_j) * TILE_J);
+            } while ((tile = range.next.fetch_add(1, std::memory_order_relaxed)) < range.end);
+        }
+    });
+}
+
+int main(int argc, char* argv[]) {
+    MatMulKernel kernel(matmul);
+    kernel.setup = [](const MatMulProblem& p) {
+        problem = p;
+        configure_from_env();
+        return true;
+    };
+    kernel.describe = [](int, int, int) {
+        std::string s = std::to_string(config.threads) + " threads, schedule " + schedule_name(config.schedule);
+        if (config.schedule == Schedule::Numa) s += " (" + std::to_string(config.topology.size()) + " nodes)";
+        return s + ", pinning " + pinning_name(config.pinning);
+    };
+    kernel.threads = [] { return config.threads; };
+    kernel.parameters = {{"TILE_I", TILE_I}, {"TILE_J", TILE_J}, {"TILE_K", TILE_K}};
+    return harness_main(argc, argv, kernel);
+}
@@ -0,0 +1,64 @@
+#include "spmm_harness.h"
+#include <omp.h>
+
+// Row-parallel CSR times dense: row i of C is the sum of a_ik * (row k of B) over the
+// nonzeros of row i of A, accumulated in SPMM_TILE_J-wide panels of C that stay in L1
+// while the rows of B stream through. Rows are split over the OpenMP threads into
+// contiguous ranges of (about) equal nonzero counts, set up once, since the row lengths of
+// a sparse matrix vary too much for equal row counts to balance.
+
+#ifndef SPMM_TILE_J
+#define SPMM_TILE_J 512
+#endif
+
+static std::vector<int> row_split;  // part t is rows row_split[t] .. row_split[t + 1] - 1
+
+void spmm(const SparseView& A, const float* __restrict B, float* __restrict C, int J) {
+    // One thread per part is asked for, but the team may be smaller (OMP_DYNAMIC, thread
+    // limits), so every thread takes the parts of its index modulo the team size.
+    const int parts = static_cast<int>(row_split.size()) - 1;
+    #pragma omp parallel num_threads(parts)
+    for (int t = omp_get_thread_num(); t < parts; t += omp_get_num_threads()) {
+        for (int i = row_split[t]; i < row_split[t + 1]; ++i) {
+            float* c_row = C + static_cast<size_t>(i) * J;
+            for (int jj = 0; jj < J; jj += SPMM_TILE_J) {
+                const int width = std::min(SPMM_TILE_J, J - jj);
+                float* __restrict c = c_row + jj;
+                #pragma omp simd
+                for (int j = 0; j < width; ++j) c[j] = 0.0f;
+                for (int64_t p = A.row_ptr[i]; p < A.row_ptr[i + 1]; ++p) {
+                    const float a = A.values[p];
+                    const float* __restrict b = B + static_cast<size_t>(A.col_idx[p]) * J + jj;
+                    #pragma omp simd
+                    for (int j = 0; j < width; ++j) c[j] += a * b[j];
+                }
+            }
+        }
+    }
+}
+
+static bool setup(const SparseView& A, int) {
+    if (!A.csr()) {
+        std::cerr << "spmm_csr needs a CSR matrix, not " << sparse_format_name(A.block_rows, A.block_cols) << std::endl;
+        return false;
+    }
+    // Part t starts at the first row with at least t / threads of the nonzeros before it.
+    const int threads = omp_get_max_threads();
+    row_split.assign(threads + 1, A.rows);
+    int i = 0;
+    for (int t = 0; t < threads; ++t) {
+        const int64_t first = static_cast<int64_t>(static_cast<double>(A.row_ptr[A.rows]) * t / threads);
+        while (i < A.rows && A.row_ptr[i] < first) ++i;
+        row_split[t] = t == 0 ? 0 : i;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    SpMMKernel kernel(spmm);
+    kernel.setup = setup;
+    kernel.describe = [](const SparseView&, int) {
+        return "CSR, " + std::to_string(omp_get_max_threads()) + " thread(s), nonzero-balanced rows";
+    };
+    return spmm_harness_main(argc, argv, kernel);
+}
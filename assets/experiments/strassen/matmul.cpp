@@ -0,0 +1,229 @@
+#include "harness.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Strassen's algorithm in Winograd's variant (7 products and 15 additions per level)
+// down to a cutoff, below which the tiled loop nest of optimized/ takes over. The
+// recursion halves I, J, and K at every level while all three exceed the cutoff
+// (MATMUL_STRASSEN_CUTOFF, default STRASSEN_CUTOFF), so a depth d saves a factor (8/7)^d
+// of the multiplications. Shapes that do not halve d times are zero-padded to multiples of
+// 2^d (not to a power of two). Every level uses three temporaries, all carved from one
+// workspace allocated in setup(), so runs allocate nothing. The extra additions make the
+// result less accurate than an O(IJK) kernel's; comparison.log and runtimes_meta report the
+// errors (see strassen_tolerance() for the bound the results are checked against).
+
+#ifndef STRASSEN_CUTOFF
+#define STRASSEN_CUTOFF 128
+#endif
+
+#ifndef TILE_I
+#define TILE_I 32
+#endif
+
+#ifndef TILE_J
+#define TILE_J 32
+#endif
+
+#ifndef TILE_K
+#define TILE_K 32
+#endif
+
+// Error growth per recursion level allowed on top of matmul_tolerance(); see strassen_tolerance().
+#ifndef STRASSEN_LEVEL_GROWTH
+#define STRASSEN_LEVEL_GROWTH 2.0f
+#endif
+
+static int cutoff = STRASSEN_CUTOFF;
+static int depth = 0;
+static int padded_I, padded_J, padded_K;
+static std::vector<float> workspace;  // padded operands, then the temporaries of every level
+static float *pad_A, *pad_B, *pad_C, *temporaries;
+
+// C (m x n) = A (m x k) * B (k x n), each with its own row stride: the tiles of
+// optimized/, with the j loop innermost so that it vectorizes.
+static void multiply_tiled(int m, int n, int k, const float* __restrict A, int lda, const float* __restrict B, int ldb,
+                           float* __restrict C, int ldc) {
+    for (int i = 0; i < m; ++i) std::fill(C + static_cast<size_t>(i) * ldc, C + static_cast<size_t>(i) * ldc + n, 0.0f);
+    for (int ii = 0; ii < m; ii += TILE_I) {
+        const int i_max = std::min(ii + TILE_I, m);
+        for (int jj = 0; jj < n; jj += TILE_J) {
+            const int j_max = std::min(jj + TILE_J, n);
+            for (int kk = 0; kk < k; kk += TILE_K) {
+                const int k_max = std::min(kk + TILE_K, k);
+                for (int i = ii; i < i_max; ++i) {
+                    float* c_row = C + static_cast<size_t>(i) * ldc;
+                    for (int p = kk; p < k_max; ++p) {
+                        const float a = A[static_cast<size_t>(i) * lda + p];
+                        const float* b_row = B + static_cast<size_t>(p) * ldb;
+                        for (int j = jj; j < j_max; ++j) c_row[j] += a * b_row[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Z = X + sign * Y over m x n elements; Z may be X or Y.
+static void add(int m, int n, const float* X, int ldx, const float* Y, int ldy, float* Z, int ldz, float sign) {
+    for (int i = 0; i < m; ++i) {
+        const float* x = X + static_cast<size_t>(i) * ldx;
+        const float* y = Y + static_cast<size_t>(i) * ldy;
+        float* z = Z + static_cast<size_t>(i) * ldz;
+        for (int j = 0; j < n; ++j) z[j] = x[j] + sign * y[j];
+    }
+}
+
+// Temporaries of one level of an m x n x k product: X (m/2 x k/2), Y (k/2 x n/2), P (m/2 x n/2).
+static size_t level_elements(int m, int n, int k) {
+    const size_t m2 = m / 2, n2 = n / 2, k2 = k / 2;
+    return m2 * k2 + k2 * n2 + m2 * n2;
+}
+
+// C = A * B for dimensions divisible by 2^levels; ws holds the temporaries of this level
+// followed by those of the levels below. The schedule keeps four of the seven products in
+// the quadrants of C and needs only one temporary product (P):
+//   S1 = A21 + A22, S2 = S1 - A11, S3 = A11 - A21, S4 = A12 - S2
+//   T1 = B12 - B11, T2 = B22 - T1, T3 = B22 - B12, T4 = T2 - B21
+//   M1 = A11 B11, M2 = A12 B21, M3 = S4 B22, M4 = A22 T4, M5 = S1 T1, M6 = S2 T2, M7 = S3 T3
+//   C11 = M1 + M2, C12 = U2 + M5 + M3, C21 = U2 + M7 - M4, C22 = U2 + M7 + M5 (U2 = M1 + M6)
+static void winograd(int m, int n, int k, const float* A, int lda, const float* B, int ldb, float* C, int ldc,
+                     float* ws, int levels) {
+    if (levels == 0) {
+        multiply_tiled(m, n, k, A, lda, B, ldb, C, ldc);
+        return;
+    }
+    const int m2 = m / 2, n2 = n / 2, k2 = k / 2;
+    const float *A11 = A, *A12 = A + k2, *A21 = A + static_cast<size_t>(m2) * lda, *A22 = A21 + k2;
+    const float *B11 = B, *B12 = B + n2, *B21 = B + static_cast<size_t>(k2) * ldb, *B22 = B21 + n2;
+    float *C11 = C, *C12 = C + n2, *C21 = C + static_cast<size_t>(m2) * ldc, *C22 = C21 + n2;
+    float* X = ws;
+    float* Y = X + static_cast<size_t>(m2) * k2;
+    float* P = Y + static_cast<size_t>(k2) * n2;
+    float* next = P + static_cast<size_t>(m2) * n2;
+    auto mul = [&](const float* L, int ldl, const float* R, int ldr, float* D, int ldd) {
+        winograd(m2, n2, k2, L, ldl, R, ldr, D, ldd, next, levels - 1);
+    };
+
+    add(m2, k2, A11, lda, A21, lda, X, k2, -1);  // S3
+    add(k2, n2, B22, ldb, B12, ldb, Y, n2, -1);  // T3
+    mul(X, k2, Y, n2, C21, ldc);                 // C21 = M7
+    add(m2, k2, A21, lda, A22, lda, X, k2, 1);   // S1
+    add(k2, n2, B12, ldb, B11, ldb, Y, n2, -1);  // T1
+    mul(X, k2, Y, n2, C22, ldc);                 // C22 = M5
+    add(m2, k2, X, k2, A11, lda, X, k2, -1);     // S2
+    add(k2, n2, B22, ldb, Y, n2, Y, n2, -1);     // T2
+    mul(X, k2, Y, n2, C12, ldc);                 // C12 = M6
+    add(m2, k2, A12, lda, X, k2, X, k2, -1);     // S4
+    mul(X, k2, B22, ldb, P, n2);                 // P = M3
+    mul(A11, lda, B11, ldb, C11, ldc);           // C11 = M1
+    add(m2, n2, C12, ldc, C11, ldc, C12, ldc, 1);  // C12 = U2 = M1 + M6
+    add(m2, n2, C21, ldc, C12, ldc, C21, ldc, 1);  // C21 = U3 = U2 + M7
+    add(m2, n2, C12, ldc, C22, ldc, C12, ldc, 1);  // C12 = U4 = U2 + M5
+    add(m2, n2, C22, ldc, C21, ldc, C22, ldc, 1);  // C22 = U7 = U3 + M5 (done)
+    add(m2, n2, C12, ldc, P, n2, C12, ldc, 1);     // C12 = U5 = U4 + M3 (done)
+    add(k2, n2, Y, n2, B21, ldb, Y, n2, -1);       // T4
+    mul(A22, lda, Y, n2, P, n2);                   // P = M4
+    add(m2, n2, C21, ldc, P, n2, C21, ldc, -1);    // C21 = U6 = U3 - M4 (done)
+    mul(A12, lda, B21, ldb, P, n2);                // P = M2
+    add(m2, n2, C11, ldc, P, n2, C11, ldc, 1);     // C11 = U1 = M1 + M2 (done)
+}
+
+// Copy the rows x cols matrix src (row stride lds) into dst (row stride ldd).
+static void copy_matrix(int rows, int cols, const float* src, int lds, float* dst, int ldd) {
+    for (int r = 0; r < rows; ++r) {
+        std::copy(src + static_cast<size_t>(r) * lds, src + static_cast<size_t>(r) * lds + cols,
+                  dst + static_cast<size_t>(r) * ldd);
+    }
+}
+
+static int round_up(int n, int multiple) { return (n + multiple - 1) / multiple * multiple; }
+
+static bool setup(const MatMulProblem& problem) {
+    if (const char* env = std::getenv("MATMUL_STRASSEN_CUTOFF")) cutoff = std::atoi(env);
+    if (cutoff < 1) {
+        std::cerr << "MATMUL_STRASSEN_CUTOFF must be positive" << std::endl;
+        return false;
+    }
+    const int I = problem.I, J = problem.J, K = problem.K;
+    // depth is the fewest halvings that bring the smallest dimension, rounded up at every
+    // level, down to the cutoff (capped at 20): the products of the last level all had
+    // dimensions above it, and the leaves have at least one at or below it. Odd dimensions
+    // do not stop the recursion; they are zero-padded to multiples of 2^depth below.
+    depth = 0;
+    while ((std::min({I, J, K}) + (1 << depth) - 1) >> depth > cutoff && depth < 20) ++depth;
+    padded_I = round_up(I, 1 << depth);
+    padded_J = round_up(J, 1 << depth);
+    padded_K = round_up(K, 1 << depth);
+
+    // Padded copies only where a dimension of the operand grew; their padding stays zero.
+    const size_t size_A = padded_I != I || padded_K != K ? size_t(padded_I) * padded_K : 0;
+    const size_t size_B = padded_K != K || padded_J != J ? size_t(padded_K) * padded_J : 0;
+    const size_t size_C = padded_I != I || padded_J != J ? size_t(padded_I) * padded_J : 0;
+    size_t size_temporaries = 0;
+    for (int l = 0; l < depth; ++l) {
+        size_temporaries += level_elements(padded_I >> l, padded_J >> l, padded_K >> l);
+    }
+    workspace.assign(size_A + size_B + size_C + size_temporaries, 0.0f);
+    pad_A = size_A ? workspace.data() : nullptr;
+    pad_B = size_B ? workspace.data() + size_A : nullptr;
+    pad_C = size_C ? workspace.data() + size_A + size_B : nullptr;
+    temporaries = workspace.data() + size_A + size_B + size_C;
+    return true;
+}
+
+void matmul(
+    const float* A, // I x K
+    const float* B, // K x J
+    float* C,       // I x J, output
+    int I, int J, int K
+) {
+    const float* a = A;
+    const float* b = B;
+    float* c = C;
+    int lda = K, ldb = J, ldc = J;
+    if (pad_A) {
+        copy_matrix(I, K, A, K, pad_A, padded_K);
+        a = pad_A;
+        lda = padded_K;
+    }
+    if (pad_B) {
+        copy_matrix(K, J, B, J, pad_B, padded_J);
+        b = pad_B;
+        ldb = padded_J;
+    }
+    if (pad_C) {
+        c = pad_C;
+        ldc = padded_J;
+    }
+    winograd(padded_I, padded_J, padded_K, a, lda, b, ldb, c, ldc, temporaries, depth);
+    if (pad_C) copy_matrix(I, J, pad_C, padded_J, C, J);
+}
+
+// The first-order error bound of Winograd's variant (Higham, Accuracy and Stability of
+// Numerical Algorithms, 23.2.2) grows by up to 18x per level, but in norm and for worst-case
+// signs; on the generated inputs the growth per level is far smaller. The results are
+// checked against matmul_tolerance() widened by STRASSEN_LEVEL_GROWTH per level, which
+// still catches wrong quadrants or signs (errors of the order of C itself).
+static Tolerance strassen_tolerance(int K) {
+    Tolerance tol = matmul_tolerance(K);
+    for (int l = 0; l < depth; ++l) tol.rel *= STRASSEN_LEVEL_GROWTH;
+    return tol;
+}
+
+int main(int argc, char* argv[]) {
+    MatMulKernel kernel(matmul);
+    kernel.setup = setup;
+    kernel.tolerance = [](int, int, int K) { return strassen_tolerance(K); };
+    kernel.parameters = {{"STRASSEN_CUTOFF", STRASSEN_CUTOFF}, {"STRASSEN_LEVEL_GROWTH", STRASSEN_LEVEL_GROWTH},
+                         {"TILE_I", TILE_I}, {"TILE_J", TILE_J}, {"TILE_K", TILE_K}};
+    kernel.describe = [](int I, int J, int K) {
+        std::string s = "Winograd, cutoff " + std::to_string(cutoff) + ", depth " + std::to_string(depth);
+        if (padded_I != I || padded_J != J || padded_K != K) {
+            s += ", padded to " + std::to_string(padded_I) + "x" + std::to_string(padded_J) + "x" + std::to_string(padded_K);
+        }
+        return s;
+    };
+    return harness_main(argc, argv, kernel);
+}
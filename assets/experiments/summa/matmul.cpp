@@ -0,0 +1,139 @@
+#include "distributed_harness.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <omp.h>
+
+// SUMMA (van de Geijn and Watts) on the q x q process grid of distributed_harness.h: at
+// every step, the ranks of grid column k broadcast an SUMMA_PANEL-wide column panel of
+// their A block along their grid row, the ranks of grid row k broadcast the matching row
+// panel of their B block down their grid column, and every rank adds the panels' product
+// to its C block. With c = MATMUL_MPI_LAYERS > 1 this is the 2.5D algorithm (Solomonik
+// and Demmel): layer 0 broadcasts its A and B blocks to the other layers, every layer runs
+// the SUMMA steps of its own 1/c of the K blocks, and the partial C blocks are summed onto
+// layer 0, trading c times the memory for a sqrt(c) smaller broadcast volume per rank.
+// The broadcasts are blocking, so the "communication" phase (broadcasts, replication, and
+// reduction) and the "compute" phase (the local panel products) add up to the run.
+// MATMUL_THREADS sets the OpenMP threads per rank (default: OpenMP's, e.g. OMP_NUM_THREADS).
+
+#ifndef SUMMA_PANEL
+#define SUMMA_PANEL 256
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static int threads = 1;
+static std::vector<float> A_panel, B_panel;  // received panels
+static std::vector<float> A_copy, B_copy;    // replicated blocks on layers > 0
+static std::vector<float> C_partial;         // partial C on layers > 0
+
+// C (rows x cols) += A (rows x width) * B (width x cols), all row-major.
+static void multiply_panels(const float* A, const float* B, float* C, int rows, int cols, int width) {
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < rows; ++i) {
+        float* c_row = C + static_cast<size_t>(i) * cols;
+        for (int k = 0; k < width; ++k) {
+            const float a = A[static_cast<size_t>(i) * width + k];
+            const float* b_row = B + static_cast<size_t>(k) * cols;
+            #pragma omp simd
+            for (int j = 0; j < cols; ++j) c_row[j] += a * b_row[j];
+        }
+    }
+}
+
+template <typename F>
+static void timed(int64_t& total_ns, F fn) {
+    const auto start = Clock::now();
+    fn();
+    total_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+static bool setup(const MatMulBlocks& blocks) {
+    threads = omp_get_max_threads();
+    if (const char* v = std::getenv("MATMUL_THREADS")) {
+        const int n = std::atoi(v);
+        if (n > 0) threads = n;
+    }
+    omp_set_num_threads(threads);
+    const ProcessGrid& grid = *blocks.grid;
+    const int rows = blocks.rows(), cols = blocks.cols();
+    A_panel.resize(static_cast<size_t>(rows) * SUMMA_PANEL);
+    B_panel.resize(static_cast<size_t>(SUMMA_PANEL) * cols);
+    if (grid.layer > 0) {
+        const int K = blocks.K, q = grid.q;
+        A_copy.resize(static_cast<size_t>(rows) * (block_begin(K, q, grid.col + 1) - block_begin(K, q, grid.col)));
+        B_copy.resize(static_cast<size_t>(block_begin(K, q, grid.row + 1) - block_begin(K, q, grid.row)) * cols);
+        C_partial.resize(static_cast<size_t>(rows) * cols);
+    }
+    return true;
+}
+
+static void summa(const MatMulBlocks& blocks, RunContext& ctx) {
+    const ProcessGrid& grid = *blocks.grid;
+    const int q = grid.q, K = blocks.K;
+    const int rows = blocks.rows(), cols = blocks.cols();
+    const int ka0 = block_begin(K, q, grid.col);  // first column of this rank's A block
+    const int kb0 = block_begin(K, q, grid.row);  // first row of this rank's B block
+    int64_t compute_ns = 0, communication_ns = 0;
+
+    const float* A = blocks.A;
+    const float* B = blocks.B;
+    float* C = blocks.C;
+    if (grid.layers > 1) {
+        // Replicate the layer-0 blocks (MPI only reads the root's buffer).
+        timed(communication_ns, [&] {
+            float* A_root = grid.layer == 0 ? const_cast<float*>(blocks.A) : A_copy.data();
+            float* B_root = grid.layer == 0 ? const_cast<float*>(blocks.B) : B_copy.data();
+            const int size_A = rows * (block_begin(K, q, grid.col + 1) - ka0);
+            const int size_B = (block_begin(K, q, grid.row + 1) - kb0) * cols;
+            MPI_Bcast(A_root, size_A, MPI_FLOAT, 0, grid.layer_comm);
+            MPI_Bcast(B_root, size_B, MPI_FLOAT, 0, grid.layer_comm);
+        });
+        if (grid.layer > 0) {
+            A = A_copy.data();
+            B = B_copy.data();
+            C = C_partial.data();
+        }
+    }
+    timed(compute_ns, [&] { std::fill(C, C + static_cast<size_t>(rows) * cols, 0.0f); });
+
+    // This layer's K blocks; block k of A's columns is on grid column k, of B's rows on grid row k.
+    const int per_layer = q / grid.layers;
+    for (int k = grid.layer * per_layer; k < (grid.layer + 1) * per_layer; ++k) {
+        const int k0 = block_begin(K, q, k), k1 = block_begin(K, q, k + 1);
+        for (int p = k0; p < k1; p += SUMMA_PANEL) {
+            const int width = std::min(SUMMA_PANEL, k1 - p);
+            float* B_step = grid.row == k ? const_cast<float*>(B) + static_cast<size_t>(p - kb0) * cols : B_panel.data();
+            timed(communication_ns, [&] {
+                if (grid.col == k) copy_block(A, k1 - k0, 0, rows, p - ka0, p - ka0 + width, A_panel.data());
+                MPI_Bcast(A_panel.data(), rows * width, MPI_FLOAT, k, grid.row_comm);
+                MPI_Bcast(B_step, width * cols, MPI_FLOAT, k, grid.col_comm);
+            });
+            timed(compute_ns, [&] { multiply_panels(A_panel.data(), B_step, C, rows, cols, width); });
+        }
+    }
+
+    if (grid.layers > 1) {
+        timed(communication_ns, [&] {
+            const int size_C = rows * cols;
+            if (grid.layer == 0) MPI_Reduce(MPI_IN_PLACE, C, size_C, MPI_FLOAT, MPI_SUM, 0, grid.layer_comm);
+            else MPI_Reduce(C, nullptr, size_C, MPI_FLOAT, MPI_SUM, 0, grid.layer_comm);
+        });
+    }
+    ctx.add_phase("compute", compute_ns);
+    ctx.add_phase("communication", communication_ns);
+}
+
+int main(int argc, char* argv[]) {
+    DistributedMatMulKernel kernel(summa);
+    kernel.setup = setup;
+    kernel.describe = [](const MatMulBlocks& blocks) {
+        const ProcessGrid& grid = *blocks.grid;
+        std::string s = grid.layers > 1 ? "2.5D SUMMA " : "SUMMA ";
+        s += std::to_string(grid.q) + "x" + std::to_string(grid.q);
+        if (grid.layers > 1) s += "x" + std::to_string(grid.layers);
+        return s + " grid, panel " + std::to_string(SUMMA_PANEL) + ", " + std::to_string(threads) + " thread(s) per rank";
+    };
+    kernel.threads = [] { return threads; };
+    return distributed_harness_main(argc, argv, kernel);
+}
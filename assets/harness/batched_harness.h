@@ -0,0 +1,392 @@
+#ifndef BATCHED_HARNESS_H
+#define BATCHED_HARNESS_H
+
+// Benchmark harness for BatchedMatMul competitors: every timed run computes a batch of
+// independent small matmuls C_b = A_b * B_b, b = 0 .. count-1, from the 3D tensors of the
+// batched data generator. A competitor provides the batch kernel and registers it:
+//
+//     void matmul_batched(const MatMulBatch& batch) { ... }
+//     REGISTER_BATCHED_MATMUL_KERNEL(matmul_batched)
+//
+// Runs are measured as in harness.h (MATMUL_CACHE hot or cold, MATMUL_CI_TARGET, ...,
+// MATMUL_VERIFY) and throughput is reported in problems per second. The operands are
+// laid out according to
+//   MATMUL_BATCH_LAYOUT=<l>  strided (default): the problems of an operand lie back to back
+//                            in one allocation; pointer: every problem's A, B, and C is a
+//                            separate allocation, made in shuffled order, so kernels can only
+//                            reach them through the pointer arrays
+// Rotating cache mode is not supported: a batch already cycles through many operand sets.
+// Neither is MATMUL_NUMA: threads take whole problems, which first touch already places.
+// Nor is MATMUL_EPILOGUE.
+// Operands live in an Arena as in harness.h (MATMUL_HUGE_PAGES).
+
+#include "harness.h"
+
+#include <numeric>
+
+// One batch of problems with a common shape. The pointer arrays are valid in both
+// layouts; strided kernels may use the strides instead.
+struct MatMulBatch {
+    int count;              // number of problems
+    int I, J, K;            // shape of every problem
+    const float* const* A;  // count pointers to I x K matrices
+    const float* const* B;  // count pointers to K x J matrices
+    float* const* C;        // count pointers to I x J matrices, initialized from init_C
+    bool shared_B;          // all B[b] point to the same matrix
+    bool strided;           // A[b] = A[0] + b * stride_A, and likewise for B and C
+    size_t stride_A, stride_B, stride_C;  // in elements; stride_B is 0 for a shared B
+};
+
+enum class BatchLayout { Strided, Pointer };
+
+inline bool batch_layout_from_env(BatchLayout& layout) {
+    layout = BatchLayout::Strided;
+    if (const char* env = std::getenv("MATMUL_BATCH_LAYOUT")) {
+        const std::string name = env;
+        if (name == "pointer") layout = BatchLayout::Pointer;
+        else if (name != "strided") {
+            std::cerr << "Invalid MATMUL_BATCH_LAYOUT '" << name << "' (expected strided or pointer)" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+using BatchedMatMulFn = void (*)(const MatMulBatch& batch);
+using BatchedMatMulTimedFn = std::function<void(const MatMulBatch& batch, RunContext& ctx)>;
+
+// A competitor's batch kernel: C[b] (initialized from init_C) = A[b] * B[b] for every
+// problem. Only run is required; the hooks mirror MatMulKernel.
+struct BatchedMatMulKernel {
+    BatchedMatMulKernel(BatchedMatMulFn fn) : run([fn](const MatMulBatch& batch, RunContext&) { fn(batch); }) {}
+    BatchedMatMulKernel(BatchedMatMulTimedFn fn) : run(std::move(fn)) {}
+
+    BatchedMatMulTimedFn run;
+    std::function<std::string(const MatMulBatch& batch)> describe;
+    // Comparison tolerance (default: matmul_tolerance(K)).
+    std::function<Tolerance(const MatMulBatch& batch)> tolerance;
+    // Called once before the warmups and after the evals.
+    std::function<bool(const MatMulBatch& batch)> setup;
+    std::function<void()> teardown;
+    // CPU threads run() computes with, recorded as threads= in runtimes_meta (default 1).
+    std::function<int()> threads;
+};
+
+// The operands of the timed runs in either layout, allocated from an Arena. In the
+// pointer layout every problem is a separate allocation; a shared B stays a single matrix.
+class BatchOperands {
+public:
+    // Check valid() after construction.
+    BatchOperands(const TensorView& A, const TensorView& B, const TensorView& init_C, BatchLayout layout,
+                  Arena& arena)
+        : init_C_(init_C.data()) {
+        const std::vector<int>& dims = A.dims();
+        count_ = dims[0];
+        I_ = dims[1];
+        K_ = dims[2];
+        J_ = B.dims()[2];
+        shared_B_ = B.dims()[0] == 1;
+        size_A_ = size_t(I_) * K_;
+        size_B_ = size_t(K_) * J_;
+        size_C_ = size_t(I_) * J_;
+        strided_ = layout == BatchLayout::Strided;
+
+        A_.resize(count_);
+        B_.resize(count_);
+        C_.resize(count_);
+        if (strided_) {
+            const Span<float> all_A = arena.copy_of(A.data(), A.size());
+            const Span<float> all_B = arena.copy_of(B.data(), B.size());
+            const Span<float> all_C = arena.copy_of(init_C.data(), init_C.size());
+            if (all_A.empty() || all_B.empty() || all_C.empty()) return;
+            for (int b = 0; b < count_; ++b) {
+                A_[b] = all_A.data() + b * size_A_;
+                B_[b] = all_B.data() + (shared_B_ ? 0 : b * size_B_);
+                C_[b] = all_C.data() + b * size_C_;
+            }
+            valid_ = true;
+            return;
+        }
+        // Allocate in a shuffled problem order so that neighbouring problems are not
+        // neighbours in memory.
+        std::vector<int> order(count_);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), std::mt19937(count_));
+        const Span<float> shared = shared_B_ ? arena.copy_of(B.data(), size_B_) : Span<float>();
+        for (int b : order) {
+            const Span<float> block_A = arena.copy_of(A.data() + b * size_A_, size_A_);
+            const Span<float> block_B = shared_B_ ? shared : arena.copy_of(B.data() + b * size_B_, size_B_);
+            const Span<float> block_C = arena.copy_of(init_C.data() + b * size_C_, size_C_);
+            if (block_A.empty() || block_B.empty() || block_C.empty()) return;
+            A_[b] = block_A.data();
+            B_[b] = block_B.data();
+            C_[b] = block_C.data();
+        }
+        valid_ = true;
+    }
+
+    bool valid() const { return valid_; }
+
+    // Reset every C to init_C.
+    void reset() {
+        for (int b = 0; b < count_; ++b) std::copy(init_C_ + b * size_C_, init_C_ + (b + 1) * size_C_, C_[b]);
+    }
+
+    MatMulBatch batch() const {
+        return MatMulBatch{count_, I_, J_, K_, A_.data(), B_.data(), C_.data(), shared_B_, strided_,
+                           strided_ ? size_A_ : 0, strided_ && !shared_B_ ? size_B_ : 0, strided_ ? size_C_ : 0};
+    }
+
+    // The computed C of every problem, back to back.
+    std::vector<float> result() const {
+        std::vector<float> C(count_ * size_C_);
+        for (int b = 0; b < count_; ++b) std::copy(C_[b], C_[b] + size_C_, C.begin() + b * size_C_);
+        return C;
+    }
+
+private:
+    const float* init_C_;
+    int count_, I_, J_, K_;
+    bool shared_B_, strided_;
+    size_t size_A_, size_B_, size_C_;
+    bool valid_ = false;
+    std::vector<const float*> A_, B_;
+    std::vector<float*> C_;
+};
+
+// Load a 3D tensor and check its dimensions against the expected ones (-1: any).
+inline bool load_batch(const std::string& filename, TensorView& view, int count, int rows, int cols,
+                       const std::string& what) {
+    if (!load_tensor(filename, view)) {
+        std::cerr << "Failed to read " << filename << std::endl;
+        return false;
+    }
+    const std::vector<int>& dims = view.dims();
+    if (dims.size() != 3 || (count >= 0 && dims[0] != count) || (rows >= 0 && dims[1] != rows) ||
+        (cols >= 0 && dims[2] != cols)) {
+        std::cerr << what << " in " << filename << " has unexpected dimensions" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Compulsory memory traffic of a batch: every A and distinct B read once, every C read
+// and written once.
+inline double batched_matmul_min_bytes(int count, int I, int J, int K, bool shared_B) {
+    const double batch_B = shared_B ? 1 : count;
+    return sizeof(float) * (static_cast<double>(count) * I * K + batch_B * K * J + 2.0 * count * I * J);
+}
+
+// Write problems_per_second (one value per eval run, in the order of runtimes) and print
+// the achieved rate.
+inline bool write_problems_per_second(const std::vector<int64_t>& runtimes_ns, int count) {
+    std::ofstream ofs("problems_per_second");
+    double best = 0, sum_ns = 0;
+    for (int64_t t : runtimes_ns) {
+        const double rate = t > 0 ? count * 1e9 / static_cast<double>(t) : 0;
+        ofs << rate << "\n";
+        best = std::max(best, rate);
+        sum_ns += static_cast<double>(t);
+    }
+    const double avg = sum_ns > 0 ? count * 1e9 * runtimes_ns.size() / sum_ns : 0;
+    std::cout << "Problems/s: avg = " << avg << ", max = " << best << std::endl;
+    return ofs.good();
+}
+
+inline int batched_harness_main(int argc, char* argv[], const BatchedMatMulKernel& kernel) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <input_A> <input_B> <input_C> [<output_C>]" << std::endl;
+        return 1;
+    }
+    HarnessOptions options;
+    BatchLayout layout;
+    if (!harness_options_from_env(options) || !batch_layout_from_env(layout)) return 1;
+    if (options.cache == CacheMode::Rotating) {
+        std::cerr << "MATMUL_CACHE=rotating is not supported for batches (use hot or cold)" << std::endl;
+        return 1;
+    }
+    if (options.numa != NumaMode::Off) {
+        std::cerr << "MATMUL_NUMA is not supported for batches (use off)" << std::endl;
+        return 1;
+    }
+    if (options.has_epilogue()) {
+        std::cerr << "MATMUL_EPILOGUE is not supported for batches (use none)" << std::endl;
+        return 1;
+    }
+
+    TensorView A, B, init_C, expected_C;
+    if (!load_batch(argv[1], A, -1, -1, -1, "A")) return 2;
+    const int count = A.dims()[0], I = A.dims()[1], K = A.dims()[2];
+    if (!load_batch(argv[2], B, -1, K, -1, "B (K must match A)")) return 2;
+    if (B.dims()[0] != 1 && B.dims()[0] != count) {
+        std::cerr << "B in " << argv[2] << " must hold one matrix or one per problem" << std::endl;
+        return 2;
+    }
+    const int J = B.dims()[2];
+    if (!load_batch(argv[3], init_C, count, I, J, "Initial C")) return 2;
+    const bool have_gold = argc > 4 && access(argv[4], R_OK) == 0;
+    if (options.verify == VerifyMode::Auto) options.verify = have_gold ? VerifyMode::Full : VerifyMode::Freivalds;
+    if (options.verify == VerifyMode::Full &&
+        !load_batch(argc > 4 ? argv[4] : "", expected_C, count, I, J, "Expected C")) {
+        std::cerr << "Full verification needs the expected C (or use MATMUL_VERIFY=freivalds)" << std::endl;
+        return 2;
+    }
+
+    Arena arena(options.huge_pages);
+    BatchOperands operands(A, B, init_C, layout, arena);
+    if (!operands.valid()) return 2;
+    const MatMulBatch batch = operands.batch();
+    if (kernel.setup && !kernel.setup(batch)) {
+        std::cerr << "Kernel setup failed" << std::endl;
+        return 2;
+    }
+
+    FrequencyInfo freq = frequency_info();
+    freq.clock_ghz_before = estimate_clock_ghz();
+
+    std::unique_ptr<CacheFlusher> flusher;
+    if (options.cache == CacheMode::Cold) flusher.reset(new CacheFlusher());
+
+    PerfCounters perf;
+    perf.open_from_env();
+
+    auto run_once = [&](RunSeries& series, bool counted) {
+        operands.reset();
+        if (flusher) flusher->flush();
+        RunContext ctx;
+        if (counted) perf.start();
+        auto start = std::chrono::high_resolution_clock::now();
+        kernel.run(batch, ctx);
+        auto end = std::chrono::high_resolution_clock::now();
+        if (counted) perf.stop();
+        const int64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        series.add(ctx.time_ns() >= 0 ? ctx.time_ns() : wall_ns, ctx);
+    };
+
+    RunSeries warmup, eval;
+    const double ci_rel = run_series(options, warmup, eval, run_once);
+    flusher.reset();
+    if (kernel.teardown) kernel.teardown();
+    freq.clock_ghz_after = estimate_clock_ghz();
+
+    const std::vector<int64_t>& eval_times_ns = eval.times_ns;
+    const int num_evals = static_cast<int>(eval_times_ns.size());
+    const Tolerance tolerance = kernel.tolerance ? kernel.tolerance(batch) : matmul_tolerance(K);
+    const std::string description = kernel.describe ? kernel.describe(batch) : "";
+    const std::vector<float> calc_C = operands.result();
+    const size_t size_C = size_t(I) * J;
+
+    std::ofstream logfs("comparison.log");
+    logfs << std::setprecision(std::numeric_limits<float>::max_digits10);
+    if (!description.empty()) logfs << "Kernel: " << description << "\n";
+    logfs << "Batch: " << count << " problems, layout " << (batch.strided ? "strided" : "pointer")
+          << (batch.shared_B ? ", shared B" : "") << "\n";
+    bool equal;
+    // Accuracy of the result, as runtimes_meta lines next to the runtimes they trade against.
+    std::ostringstream accuracy;
+    accuracy << std::setprecision(std::numeric_limits<float>::max_digits10);
+    if (options.verify == VerifyMode::Full) {
+        const ComparisonStats stats = compare_tensors(calc_C.data(), expected_C.data(), expected_C.size(), tolerance);
+        equal = stats.passed();
+        accuracy << "max_abs_error=" << stats.max_abs << "\n";
+        accuracy << "max_rel_error=" << stats.max_rel << "\n";
+        accuracy << "max_ulp_error=" << stats.max_ulp << "\n";
+        if (equal) {
+            logfs << "PASS: Calculated C matches expected output (" << count << "x" << I << "x" << J << ").\n";
+            std::cout << "PASS: Calculated C matches expected output (" << count << "x" << I << "x" << J << ")." << std::endl;
+        } else {
+            logfs << "FAIL: " << stats.mismatches << " element(s) mismatched (max abs error = " << stats.max_abs << ").\n";
+            std::cout << "FAIL: See comparison.log for details" << std::endl;
+        }
+        write_comparison(logfs, stats, calc_C.data(), expected_C.data(), expected_C.dims(), tolerance);
+        std::cout << "Max diff: " << stats.max_abs << " (rel " << stats.max_rel << ", " << stats.max_ulp << " ULP)" << std::endl;
+    } else {
+        // Every problem gets its own probes, from one seed.
+        std::random_device rd;
+        const uint64_t seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+        FreivaldsStats total;
+        total.seed = seed;
+        int worst_problem = 0;
+        for (int b = 0; b < count; ++b) {
+            const FreivaldsStats stats = freivalds_check(batch.A[b], batch.B[b], calc_C.data() + b * size_C, I, J, K,
+                                                         tolerance, options.freivalds_probes, seed + b);
+            total.probes += stats.probes;
+            total.failed_probes += stats.failed_probes;
+            total.resolution = std::max(total.resolution, stats.resolution);
+            if (stats.max_ratio > total.max_ratio || b == 0) {
+                total.max_ratio = stats.max_ratio;
+                total.worst_row = stats.worst_row;
+                worst_problem = b;
+            }
+        }
+        equal = total.passed();
+        if (equal) {
+            logfs << "PASS: Calculated C (" << count << "x" << I << "x" << J << ") passed " << total.probes << " Freivalds probe(s).\n";
+            std::cout << "PASS: Calculated C (" << count << "x" << I << "x" << J << ") passed " << total.probes << " Freivalds probe(s)." << std::endl;
+        } else {
+            logfs << "FAIL: " << total.failed_probes << " of " << total.probes << " Freivalds probe(s) failed.\n";
+            std::cout << "FAIL: See comparison.log for details" << std::endl;
+        }
+        logfs << "Verification: freivalds, probes per problem: " << options.freivalds_probes << ", seed: " << seed
+              << " (+ problem index)\n";
+        logfs << "Tolerance: abs = " << tolerance.abs << ", rel = " << tolerance.rel << "\n";
+        logfs << "Max residual / tolerance bound: " << total.max_ratio << " at problem " << worst_problem
+              << ", row " << total.worst_row << "\n";
+        logfs << "Resolution: single-element errors of up to " << total.resolution << " tolerances can pass\n";
+        std::cout << "Max residual: " << total.max_ratio << " of the tolerance bound" << std::endl;
+        accuracy << "max_residual_ratio=" << total.max_ratio << "\n";
+        accuracy << "freivalds_resolution=" << total.resolution << "\n";
+    }
+    logfs.close();
+
+    if (!eval.write("runtimes") || !warmup.write("runtimes_warmup")) {
+        std::cerr << "Failed to write runtimes" << std::endl;
+    }
+    if (!perf.write_csv("perf_counters.csv", eval_times_ns)) {
+        std::cerr << "Failed to write perf_counters.csv" << std::endl;
+    }
+    if (!write_throughput_metrics(eval_times_ns, count * matmul_flops(I, J, K),
+                                  batched_matmul_min_bytes(count, I, J, K, batch.shared_B)) ||
+        !write_problems_per_second(eval_times_ns, count)) {
+        std::cerr << "Failed to write gflops/metrics/problems_per_second" << std::endl;
+    }
+
+    std::ofstream meta("runtimes_meta");
+    write_runs_meta(meta, options, eval_times_ns, ci_rel, freq);
+    meta << "batch=" << count << "\n";
+    meta << "layout=" << (batch.strided ? "strided" : "pointer") << "\n";
+    meta << "shared_B=" << (batch.shared_B ? 1 : 0) << "\n";
+    meta << "huge_pages=" << huge_pages_name(arena.huge_pages()) << "\n";
+    meta << "arena_bytes=" << arena.reserved_bytes() << "\n";
+    meta << "verify=" << (options.verify == VerifyMode::Full ? "full" : "freivalds") << "\n";
+    if (!description.empty()) meta << "kernel=" << description << "\n";
+    meta << "threads=" << (kernel.threads ? kernel.threads() : 1) << "\n";
+    meta << "tolerance_abs=" << tolerance.abs << "\n";
+    meta << "tolerance_rel=" << tolerance.rel << "\n";
+    meta << accuracy.str();
+    meta.close();
+    if (!write_run_record(JsonObject().add("routine", "BatchedMatMul").add("batch", count).add("I", I).add("J", J).add("K", K),
+                          equal, warmup, eval)) {
+        std::cerr << "Failed to write run.json" << std::endl;
+    }
+
+    const size_t outliers = tukey_outliers(eval_times_ns).size();
+    print_timing(eval_times_ns);
+    std::cout << "BatchedMatMul " << count << " x (" << I << "x" << K << ") x (" << K << "x" << J << "): "
+              << num_evals << " evals, " << options.warmup_runs << " warmups, "
+              << (batch.strided ? "strided" : "pointer") << " layout" << (batch.shared_B ? ", shared B" : "");
+    if (!description.empty()) std::cout << ", kernel = " << description;
+    std::cout << "\n";
+    std::cout << "95% CI of the mean: +-" << ci_rel * 100 << "%, " << outliers << " outlier(s), cache = "
+              << cache_mode_name(options.cache) << std::endl;
+    warn_about_frequency(freq);
+    return equal ? 0 : 1;
+}
+
+// Define main() for a competitor whose batch kernel needs nothing beyond the plain signature.
+#define REGISTER_BATCHED_MATMUL_KERNEL(fn)                                      \
+    int main(int argc, char* argv[]) {                                          \
+        return batched_harness_main(argc, argv, BatchedMatMulKernel(fn));       \
+    }
+
+#endif /* BATCHED_HARNESS_H */
@@ -0,0 +1,420 @@
+#ifndef DISTRIBUTED_HARNESS_H
+#define DISTRIBUTED_HARNESS_H
+
+// Harness for distributed MatMul competitors on MPI ranks (built with mpicxx). The ranks
+// form a q x q x c process grid, c = MATMUL_MPI_LAYERS (default 1), so the number of ranks
+// must be q * q * c with c dividing q. Rank (row, col) of layer 0 holds block (row, col) of
+// A, B, and C, copied straight from the input files (a binary file is mapped, so a rank
+// only reads the pages of its own block); the ranks of the other layers start without
+// blocks, as for a 2.5D algorithm that replicates the inputs itself. A competitor computes
+// C = A * B into the layer-0 C blocks:
+//
+//     void matmul(const MatMulBlocks& blocks, RunContext& ctx) { ... }
+//     REGISTER_DISTRIBUTED_MATMUL_KERNEL(matmul)
+//
+// A run's time is that of the slowest rank, from a common barrier, and every phase a kernel
+// records (e.g. "compute" and "communication", written to runtimes_<phase>) is likewise
+// the maximum over the ranks; kernels must record the same phases on every rank. Each
+// layer-0 rank verifies its own C block, against its block of the gold C or with Freivalds
+// probes on its rows of A and columns of B, and rank 0 writes the run outputs as harness.h
+// does. MATMUL_CACHE=hot and cold are supported (every rank flushes its own caches); with
+// MATMUL_CI_TARGET the evals are bounded by MATMUL_MAX_RUNS only, since the ranks'
+// clocks would not agree on when MATMUL_MAX_SECONDS has passed.
+
+#include "harness.h"
+
+#include <mpi.h>
+
+#include <set>
+
+// Process grid of the ranks of MPI_COMM_WORLD: rank = (layer * q + row) * q + col.
+struct ProcessGrid {
+    int rank = 0, size = 1;
+    int q = 1, layers = 1;
+    int row = 0, col = 0, layer = 0;
+    MPI_Comm row_comm = MPI_COMM_NULL;    // ranks of this grid row and layer, ordered by col
+    MPI_Comm col_comm = MPI_COMM_NULL;    // ranks of this grid column and layer, ordered by row
+    MPI_Comm layer_comm = MPI_COMM_NULL;  // ranks at (row, col) of every layer, ordered by layer
+};
+
+// Start of part p when n items are split into parts nearly equal contiguous parts.
+inline int block_begin(int n, int parts, int p) {
+    return static_cast<int>(static_cast<long>(n) * p / parts);
+}
+
+inline bool make_process_grid(ProcessGrid& grid) {
+    MPI_Comm_rank(MPI_COMM_WORLD, &grid.rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &grid.size);
+    if (const char* env = std::getenv("MATMUL_MPI_LAYERS")) grid.layers = std::atoi(env);
+    grid.q = grid.layers > 0 ? static_cast<int>(std::lround(std::sqrt(grid.size / grid.layers))) : 0;
+    if (grid.layers < 1 || grid.q < 1 || grid.q * grid.q * grid.layers != grid.size || grid.q % grid.layers != 0) {
+        if (grid.rank == 0) {
+            std::cerr << "Invalid process grid: " << grid.size << " rank(s) are not q x q x " << grid.layers
+                      << " with " << grid.layers << " (MATMUL_MPI_LAYERS) dividing q" << std::endl;
+        }
+        return false;
+    }
+    const int per_layer = grid.q * grid.q;
+    grid.layer = grid.rank / per_layer;
+    grid.row = grid.rank % per_layer / grid.q;
+    grid.col = grid.rank % grid.q;
+    MPI_Comm_split(MPI_COMM_WORLD, grid.layer * grid.q + grid.row, grid.col, &grid.row_comm);
+    MPI_Comm_split(MPI_COMM_WORLD, grid.layer * grid.q + grid.col, grid.row, &grid.col_comm);
+    MPI_Comm_split(MPI_COMM_WORLD, grid.row * grid.q + grid.col, grid.layer, &grid.layer_comm);
+    return true;
+}
+
+// This rank's part of a distributed problem, valid from setup() until the harness returns.
+// On layer 0, A is block (row, col) of A: rows [block_begin(I, q, row), ... (row + 1)) and
+// columns [block_begin(K, q, col), ... (col + 1)); B is block (row, col) of B (the K range
+// of row, the J range of col); C is block (row, col) of C, holding init_C when a run
+// starts. All are row-major with the block's width as row length, and null on layers > 0.
+struct MatMulBlocks {
+    const ProcessGrid* grid;
+    int I, J, K;
+    const float* A;
+    const float* B;
+    float* C;
+
+    int row_begin() const { return block_begin(I, grid->q, grid->row); }
+    int rows() const { return block_begin(I, grid->q, grid->row + 1) - row_begin(); }
+    int col_begin() const { return block_begin(J, grid->q, grid->col); }
+    int cols() const { return block_begin(J, grid->q, grid->col + 1) - col_begin(); }
+};
+
+using DistributedMatMulFn = std::function<void(const MatMulBlocks& blocks, RunContext& ctx)>;
+
+// A distributed competitor's kernel, called on every rank. Only run is required.
+struct DistributedMatMulKernel {
+    DistributedMatMulKernel(DistributedMatMulFn fn) : run(std::move(fn)) {}
+
+    DistributedMatMulFn run;
+    // Kernel variant, printed and logged by rank 0.
+    std::function<std::string(const MatMulBlocks& blocks)> describe;
+    // Comparison tolerance (default: matmul_tolerance(K)).
+    std::function<Tolerance(const MatMulBlocks& blocks)> tolerance;
+    // Called on every rank before the warmups (e.g. buffer allocation) and after the evals;
+    // the benchmark stops if setup fails on any rank.
+    std::function<bool(const MatMulBlocks& blocks)> setup;
+    std::function<void()> teardown;
+    // CPU threads run() computes with on each rank, recorded as threads= in runtimes_meta
+    // (default 1).
+    std::function<int()> threads;
+};
+
+// True on every rank if ok is true on every rank.
+inline bool all_ranks(bool ok) {
+    int local = ok ? 1 : 0, all = 0;
+    MPI_Allreduce(&local, &all, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    return all != 0;
+}
+
+// Open a row-major 2D tensor file without reading its payload: binary files are mapped
+// without the checksum pass, which would read every page; text files are parsed. Failures
+// are reported if report is set (rank 0), since every rank opens the same files.
+inline bool open_matrix(const std::string& filename, TensorView& view, int rows, int cols, const std::string& what,
+                        bool report) {
+    const bool ok = is_binary_tensor(filename) ? view.map_binary(filename, false) : view.read_text(filename);
+    if (!ok || view.dims().size() != 2 || (rows >= 0 && view.dims()[0] != rows) ||
+        (cols >= 0 && view.dims()[1] != cols) || !view.layout().row_major()) {
+        if (report) std::cerr << "Failed to load " << what << " from " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Copy rows [r0, r1) and columns [c0, c1) of the row-major matrix src (cols columns wide)
+// to dst (c1 - c0 columns wide).
+inline void copy_block(const float* src, int cols, int r0, int r1, int c0, int c1, float* dst) {
+    for (int r = r0; r < r1; ++r) {
+        std::copy(src + static_cast<size_t>(r) * cols + c0, src + static_cast<size_t>(r) * cols + c1,
+                  dst + static_cast<size_t>(r - r0) * (c1 - c0));
+    }
+}
+
+// Distinct hosts of the ranks (rank 0's result; 0 elsewhere).
+inline int count_nodes(const ProcessGrid& grid) {
+    char name[MPI_MAX_PROCESSOR_NAME] = {};
+    int length = 0;
+    MPI_Get_processor_name(name, &length);
+    std::vector<char> names(grid.rank == 0 ? static_cast<size_t>(grid.size) * MPI_MAX_PROCESSOR_NAME : 0);
+    MPI_Gather(name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, names.data(), MPI_MAX_PROCESSOR_NAME, MPI_CHAR, 0, MPI_COMM_WORLD);
+    std::set<std::string> hosts;
+    for (int r = 0; grid.rank == 0 && r < grid.size; ++r) {
+        hosts.insert(std::string(names.data() + static_cast<size_t>(r) * MPI_MAX_PROCESSOR_NAME));
+    }
+    return static_cast<int>(hosts.size());
+}
+
+// Gather a trivially copyable value of every rank on rank 0.
+template <typename T>
+inline std::vector<T> gather_to_root(const ProcessGrid& grid, const T& value) {
+    std::vector<T> values(grid.rank == 0 ? grid.size : 0);
+    MPI_Gather(&value, sizeof(T), MPI_BYTE, values.data(), sizeof(T), MPI_BYTE, 0, MPI_COMM_WORLD);
+    return values;
+}
+
+inline int distributed_benchmark(int argc, char* argv[], const DistributedMatMulKernel& kernel) {
+    ProcessGrid grid;
+    MPI_Comm_rank(MPI_COMM_WORLD, &grid.rank);
+    const bool root = grid.rank == 0;
+    if (argc < 4) {
+        if (root) std::cerr << "Usage: " << argv[0] << " <input_A> <input_B> <input_C> [<output_C>]" << std::endl;
+        return 1;
+    }
+    HarnessOptions options;
+    if (!harness_options_from_env(options)) return 1;
+    if (options.cache == CacheMode::Rotating || options.numa != NumaMode::Off || options.has_epilogue()) {
+        if (root) {
+            std::cerr << "MATMUL_CACHE=rotating, MATMUL_NUMA, and MATMUL_EPILOGUE are not supported for distributed runs"
+                      << std::endl;
+        }
+        return 1;
+    }
+    options.max_seconds = std::numeric_limits<double>::infinity();
+    if (!make_process_grid(grid)) return 1;
+    const int q = grid.q;
+    const bool holds_blocks = grid.layer == 0;
+
+    TensorView A, B, init_C;
+    bool ok = open_matrix(argv[1], A, -1, -1, "A", root);
+    const int I = ok ? A.dims()[0] : 0, K = ok ? A.dims()[1] : 0;
+    ok = ok && open_matrix(argv[2], B, K, -1, "B (K must match A)", root);
+    const int J = ok ? B.dims()[1] : 0;
+    ok = ok && open_matrix(argv[3], init_C, I, J, "Initial C", root);
+    if (!all_ranks(ok)) return 2;
+    const bool have_gold = argc > 4 && access(argv[4], R_OK) == 0;
+    if (options.verify == VerifyMode::Auto) options.verify = have_gold ? VerifyMode::Full : VerifyMode::Freivalds;
+    if (options.verify == VerifyMode::Full && !have_gold) {
+        if (root) std::cerr << "Full verification needs the expected C (or use MATMUL_VERIFY=freivalds)" << std::endl;
+        return 2;
+    }
+
+    // Blocks of layer 0, in the arena like the operands of harness.h.
+    Arena arena(options.huge_pages);
+    MatMulBlocks blocks{&grid, I, J, K, nullptr, nullptr, nullptr};
+    const int r0 = blocks.row_begin(), r1 = r0 + blocks.rows();
+    const int c0 = blocks.col_begin(), c1 = c0 + blocks.cols();
+    const int ka0 = block_begin(K, q, grid.col), ka1 = block_begin(K, q, grid.col + 1);
+    const int kb0 = block_begin(K, q, grid.row), kb1 = block_begin(K, q, grid.row + 1);
+    const size_t size_C = static_cast<size_t>(r1 - r0) * (c1 - c0);
+    Span<float> A_block, B_block, init_C_block, C_block;
+    if (holds_blocks) {
+        A_block = arena.allocate<float>(static_cast<size_t>(r1 - r0) * (ka1 - ka0));
+        B_block = arena.allocate<float>(static_cast<size_t>(kb1 - kb0) * (c1 - c0));
+        init_C_block = arena.allocate<float>(size_C);
+        C_block = arena.allocate<float>(size_C);
+        ok = !A_block.empty() && !B_block.empty() && !init_C_block.empty() && !C_block.empty();
+        if (ok) {
+            copy_block(A.data(), K, r0, r1, ka0, ka1, A_block.data());
+            copy_block(B.data(), J, kb0, kb1, c0, c1, B_block.data());
+            copy_block(init_C.data(), J, r0, r1, c0, c1, init_C_block.data());
+            blocks.A = A_block.data();
+            blocks.B = B_block.data();
+            blocks.C = C_block.data();
+        }
+    }
+    if (!all_ranks(ok)) return 2;
+    if (!all_ranks(!kernel.setup || kernel.setup(blocks))) {
+        if (root) std::cerr << "Kernel setup failed" << std::endl;
+        return 2;
+    }
+
+    FrequencyInfo freq = frequency_info();
+    freq.clock_ghz_before = estimate_clock_ghz();
+
+    std::unique_ptr<CacheFlusher> flusher;
+    if (options.cache == CacheMode::Cold) flusher.reset(new CacheFlusher());
+
+    // One run: reset C, prepare the caches, and time the kernel from a common barrier; the
+    // run time and every phase are the maximum over the ranks.
+    auto run_once = [&](RunSeries& series, bool) {
+        if (holds_blocks) std::copy(init_C_block.begin(), init_C_block.end(), C_block.data());
+        if (flusher) flusher->flush();
+        RunContext ctx;
+        MPI_Barrier(MPI_COMM_WORLD);
+        auto start = std::chrono::high_resolution_clock::now();
+        kernel.run(blocks, ctx);
+        auto end = std::chrono::high_resolution_clock::now();
+        const int64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        std::vector<int64_t> local{ctx.time_ns() >= 0 ? ctx.time_ns() : wall_ns};
+        for (const auto& phase : ctx.phases()) local.push_back(phase.second);
+        std::vector<int64_t> slowest(local.size());
+        MPI_Allreduce(local.data(), slowest.data(), static_cast<int>(local.size()), MPI_INT64_T, MPI_MAX, MPI_COMM_WORLD);
+        RunContext reduced;
+        for (size_t p = 0; p < ctx.phases().size(); ++p) reduced.add_phase(ctx.phases()[p].first, slowest[p + 1]);
+        series.add(slowest[0], reduced);
+    };
+
+    RunSeries warmup, eval;
+    const double ci_rel = run_series(options, warmup, eval, run_once);
+    flusher.reset();
+    if (kernel.teardown) kernel.teardown();
+    freq.clock_ghz_after = estimate_clock_ghz();
+
+    const std::vector<int64_t>& eval_times_ns = eval.times_ns;
+    const int num_evals = static_cast<int>(eval_times_ns.size());
+    const Tolerance tolerance = kernel.tolerance ? kernel.tolerance(blocks) : matmul_tolerance(K);
+    const std::string description = kernel.describe ? kernel.describe(blocks) : "";
+    const int nodes = count_nodes(grid);
+
+    // Every layer-0 rank checks its own block; rank 0 merges the results.
+    bool equal = true;
+    std::ofstream logfs;
+    // Accuracy of the result, merged on rank 0, as runtimes_meta lines.
+    std::ostringstream accuracy;
+    accuracy << std::setprecision(std::numeric_limits<float>::max_digits10);
+    if (root) {
+        logfs.open("comparison.log");
+        logfs << std::setprecision(std::numeric_limits<float>::max_digits10);
+        if (!description.empty()) logfs << "Kernel: " << description << "\n";
+        logfs << "Grid: " << q << "x" << q << "x" << grid.layers << " (" << grid.size << " ranks on " << nodes
+              << " node(s))\n";
+    }
+    if (options.verify == VerifyMode::Full) {
+        ComparisonStats stats;
+        if (holds_blocks) {
+            TensorView expected_C;
+            ok = open_matrix(argv[4], expected_C, I, J, "Expected C", true);
+            if (ok) {
+                std::vector<float> expected_block(size_C);
+                copy_block(expected_C.data(), J, r0, r1, c0, c1, expected_block.data());
+                stats = compare_tensors(C_block.data(), expected_block.data(), size_C, tolerance);
+                if (stats.worst_idx != static_cast<size_t>(-1)) {
+                    const size_t width = static_cast<size_t>(c1 - c0);
+                    stats.worst_idx = (r0 + stats.worst_idx / width) * J + c0 + stats.worst_idx % width;
+                }
+            }
+        }
+        if (!all_ranks(ok)) return 2;
+        const std::vector<ComparisonStats> all = gather_to_root(grid, stats);
+        if (root) {
+            ComparisonStats total;
+            for (const ComparisonStats& s : all) total.merge(s);
+            equal = total.passed();
+            if (equal) {
+                logfs << "PASS: Calculated C matches expected output (" << I << "x" << J << ").\n";
+                std::cout << "PASS: Calculated C matches expected output (" << I << "x" << J << ")." << std::endl;
+            } else {
+                logfs << "FAIL: " << total.mismatches << " element(s) mismatched (max abs error = " << total.max_abs
+                      << ").\n";
+                std::cout << "FAIL: See comparison.log for details" << std::endl;
+            }
+            logfs << "Tolerance: abs = " << tolerance.abs << ", rel = " << tolerance.rel << "\n";
+            logfs << "Max abs error: " << total.max_abs << " at (" << total.worst_idx / J << ", " << total.worst_idx % J
+                  << "), max rel error: " << total.max_rel << ", max ULP: " << total.max_ulp << "\n";
+            std::cout << "Max diff: " << total.max_abs << " (rel " << total.max_rel << ", " << total.max_ulp << " ULP)"
+                      << std::endl;
+            accuracy << "max_abs_error=" << total.max_abs << "\n";
+            accuracy << "max_rel_error=" << total.max_rel << "\n";
+            accuracy << "max_ulp_error=" << total.max_ulp << "\n";
+        }
+    } else {
+        uint64_t seed = 0;
+        if (root) {
+            std::random_device rd;
+            seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+        }
+        MPI_Bcast(&seed, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+        FreivaldsStats stats;
+        if (holds_blocks) {
+            // C_block = (rows r0..r1 of A) * (columns c0..c1 of B), probed with seed + rank.
+            std::vector<float> A_rows(static_cast<size_t>(r1 - r0) * K), B_cols(static_cast<size_t>(K) * (c1 - c0));
+            copy_block(A.data(), K, r0, r1, 0, K, A_rows.data());
+            copy_block(B.data(), J, 0, K, c0, c1, B_cols.data());
+            stats = freivalds_check(A_rows.data(), B_cols.data(), C_block.data(), r1 - r0, c1 - c0, K, tolerance,
+                                    options.freivalds_probes, seed + grid.rank);
+            stats.worst_row += r0;
+        }
+        const std::vector<FreivaldsStats> all = gather_to_root(grid, stats);
+        if (root) {
+            FreivaldsStats total;
+            for (const FreivaldsStats& s : all) {
+                total.probes += s.probes;
+                total.failed_probes += s.failed_probes;
+                total.resolution = std::max(total.resolution, s.resolution);
+                if (s.max_ratio > total.max_ratio) {
+                    total.max_ratio = s.max_ratio;
+                    total.worst_row = s.worst_row;
+                }
+            }
+            equal = total.passed();
+            if (equal) {
+                logfs << "PASS: Calculated C (" << I << "x" << J << ") passed " << total.probes << " Freivalds probe(s).\n";
+                std::cout << "PASS: Calculated C (" << I << "x" << J << ") passed " << total.probes << " Freivalds probe(s)." << std::endl;
+            } else {
+                logfs << "FAIL: " << total.failed_probes << " of " << total.probes << " Freivalds probe(s) failed.\n";
+                std::cout << "FAIL: See comparison.log for details" << std::endl;
+            }
+            logfs << "Verification: freivalds per block, probes per block: " << options.freivalds_probes
+                  << ", seed: " << seed << " (+ rank)\n";
+            logfs << "Tolerance: abs = " << tolerance.abs << ", rel = " << tolerance.rel << "\n";
+            logfs << "Max residual / tolerance bound: " << total.max_ratio << " at row " << total.worst_row << "\n";
+            logfs << "Resolution: single-element errors of up to " << total.resolution << " tolerances can pass\n";
+            std::cout << "Max residual: " << total.max_ratio << " of the tolerance bound" << std::endl;
+            accuracy << "max_residual_ratio=" << total.max_ratio << "\n";
+            accuracy << "freivalds_resolution=" << total.resolution << "\n";
+        }
+    }
+    if (!root) return 0;
+    logfs.close();
+
+    if (!eval.write("runtimes") || !warmup.write("runtimes_warmup")) {
+        std::cerr << "Failed to write runtimes" << std::endl;
+    }
+    if (!write_matmul_metrics(eval_times_ns, I, J, K)) {
+        std::cerr << "Failed to write gflops/metrics" << std::endl;
+    }
+
+    std::ofstream meta("runtimes_meta");
+    write_runs_meta(meta, options, eval_times_ns, ci_rel, freq);
+    meta << "ranks=" << grid.size << "\n";
+    meta << "nodes=" << nodes << "\n";
+    meta << "grid=" << q << "x" << q << "x" << grid.layers << "\n";
+    meta << "verify=" << (options.verify == VerifyMode::Full ? "full" : "freivalds") << "\n";
+    if (!description.empty()) meta << "kernel=" << description << "\n";
+    meta << "threads=" << (kernel.threads ? kernel.threads() : 1) << "\n";
+    meta << "tolerance_abs=" << tolerance.abs << "\n";
+    meta << "tolerance_rel=" << tolerance.rel << "\n";
+    meta << accuracy.str();
+    meta.close();
+    if (!write_run_record(JsonObject().add("routine", "MatMul").add("I", I).add("J", J).add("K", K).add("ranks", grid.size),
+                          equal, warmup, eval)) {
+        std::cerr << "Failed to write run.json" << std::endl;
+    }
+
+    const size_t outliers = tukey_outliers(eval_times_ns).size();
+    print_timing(eval_times_ns);
+    for (const auto& phase : eval.phases) {
+        int64_t total_ns = 0, phase_ns = 0;
+        for (int64_t t : eval_times_ns) total_ns += t;
+        for (int64_t t : phase.second) phase_ns += t;
+        std::cout << "Phase " << phase.first << " (slowest rank): avg = " << phase_ns / num_evals << " ns, "
+                  << 100.0 * phase_ns / std::max<int64_t>(total_ns, 1) << "% of the run" << std::endl;
+    }
+    std::cout << "MatMul (" << I << "x" << K << ") x (" << K << "x" << J << "): " << num_evals << " evals, "
+              << options.warmup_runs << " warmups, " << grid.size << " ranks on " << nodes << " node(s)";
+    if (!description.empty()) std::cout << ", kernel = " << description;
+    std::cout << "\n";
+    std::cout << "95% CI of the mean: +-" << ci_rel * 100 << "%, " << outliers << " outlier(s), cache = "
+              << cache_mode_name(options.cache) << std::endl;
+    warn_about_frequency(freq);
+    return equal ? 0 : 1;
+}
+
+// Run the benchmark between MPI_Init and MPI_Finalize. Every rank returns the same status
+// except for verification failures, which rank 0 reports.
+inline int distributed_harness_main(int argc, char* argv[], const DistributedMatMulKernel& kernel) {
+    MPI_Init(&argc, &argv);
+    const int status = distributed_benchmark(argc, argv, kernel);
+    MPI_Finalize();
+    return status;
+}
+
+// Define main() for a distributed competitor that needs nothing beyond run().
+#define REGISTER_DISTRIBUTED_MATMUL_KERNEL(fn)                                   \
+    int main(int argc, char* argv[]) {                                           \
+        return distributed_harness_main(argc, argv, DistributedMatMulKernel(fn)); \
+    }
+
+#endif /* DISTRIBUTED_HARNESS_H */
@@ -0,0 +1,1173 @@
+#ifndef HARNESS_H
+#define HARNESS_H
+
+// Shared benchmark harness for MatMul competitors. A competitor provides the kernel and
+// registers it; the harness loads the inputs, runs warmups and timed evals, checks the
+// result against the gold output, and writes the run outputs (runtimes, runtimes_warmup,
+// comparison.log, metrics, ...) and run.json, the structured record of the run with the
+// build and node it used (run_record.h), to the current directory:
+//
+//     void matmul(const float* A, const float* B, float* C, int I, int J, int K) { ... }
+//     REGISTER_MATMUL_KERNEL(matmul)
+//
+// Competitors that need more (a kernel description, a custom tolerance, device setup, or
+// their own timing) fill in a MatMulKernel and call harness_main() from main().
+//
+// The kernel's operand type may also be bfloat16, float16, or int8_t (C stays float): the
+// harness converts the float inputs before the runs (int8_t with per-tensor scales, see
+// BasicMatMulProblem), verifies against the float data with matmul_tolerance_for(), and
+// counts the narrower operands in the metrics.
+//
+// B may be stored pre-transposed or pre-packed (a TensorLayout other than row-major, see
+// data_helper.h); the kernel then gets it as stored and declares the layouts it reads in
+// MatMulKernel::accepts_B. A and C are always row-major. `matmul --B-layout` prints the
+// layout the kernel prefers, so a task can pick the matching input file.
+//
+// The matmul may carry an epilogue, C = act(alpha A B + beta C_init + bias) (Epilogue in
+// data_helper.h), for which the data task writes the matching initial C, bias, and gold
+// output. Kernels that set MatMulKernel::fuses_epilogue apply it in their write-back;
+// for the others the harness runs it as a separate pass after run(), timed with the run
+// and recorded as the phase runtimes_epilogue.
+//
+// The operands a kernel sees (A, B, and C, including rotating copies) live in an Arena
+// (arena.h): they start ARENA_ALIGNMENT-aligned (64 bytes), so rows are aligned whenever
+// the row length is a multiple of 16 floats, and they are backed by huge pages where the
+// system provides them.
+//
+// Builds with -DMATMUL_TRACE=1 also write trace.json, a Chrome trace of the warmups and
+// evals with the phases the kernel marks with TRACE_SCOPE (trace.h), one track per thread.
+//
+// `matmul --serve <manifest>` is a benchmark server: it runs every case the manifest lists
+// (input files and an output directory per line, see read_serve_manifest()) in one
+// process, reading the next case's inputs on a background thread while the current one
+// runs, so process start-up and input parsing drop out of a sweep's critical path.
+//
+// Measurement is configured through the environment:
+//   MATMUL_CACHE=<mode>     hot (default): operands stay cached between runs; cold: a buffer
+//                           larger than the last-level cache is written before every run;
+//                           rotating: runs cycle through several copies of the operands
+//   MATMUL_ROTATE_BUFFERS=<n>  operand copies in rotating mode (default: enough to exceed
+//                           twice the last-level cache)
+//   MATMUL_CI_TARGET=<r>    repeat evals until the 95% confidence interval of the mean is
+//                           within +-r of the mean (e.g. 0.02); 0 (default) runs EVAL_RUNS
+//   MATMUL_MAX_RUNS=<n>     upper bound on adaptive evals (default 100)
+//   MATMUL_MAX_SECONDS=<s>  upper bound on the time spent in adaptive evals (default 60)
+//   MATMUL_PERF=ON          record hardware performance counters (perf_counters.h)
+//   MATMUL_VERIFY=<mode>    full: compare against the gold output C; freivalds: randomized
+//                           check C r = A (B r) without gold C; auto (default): full if the
+//                           gold output was given and exists, freivalds otherwise
+//   MATMUL_FREIVALDS_PROBES=<n>  probe vectors of the freivalds check (default 3)
+//   MATMUL_HUGE_PAGES=<mode>  off, thp (default: transparent huge pages via madvise), or
+//                           hugetlb (MAP_HUGETLB, falls back to thp) for the operand arena
+//   MATMUL_NUMA=<mode>      off (default): pages stay where they were first touched;
+//                           interleave: all operands page by page over the NUMA nodes;
+//                           partition: row block n of A and C on node n (numa.h)
+//   MATMUL_NUMA_B=<mode>    B in partition mode: replicate (default, one copy per node,
+//                           see BasicMatMulProblem) or interleave
+//   MATMUL_EPILOGUE=<spec>  epilogue the data was generated with, e.g. alpha=1,beta=1,bias,gelu
+//                           (default none; see parse_epilogue() in data_helper.h)
+//   MATMUL_BIAS=<file>      the 1 x J bias of an epilogue with bias
+//   MATMUL_PREFETCH=<mode>  server mode: on (default) reads the next case's inputs during
+//                           the current case; off reads them after it
+//
+// The compiler command line is recorded in run.json if the build passes it in as
+// -DMATMUL_BUILD_FLAGS="..." (the build tasks do, see tasks/build/run_env.sh).
+
+#include "arena.h"
+#include "data_helper.h"
+#include "numa.h"
+#include "perf_counters.h"
+#include "run_record.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef WARMUP_RUNS
+#define WARMUP_RUNS 3
+#endif
+
+// Number of evals, or the minimum number of evals with MATMUL_CI_TARGET.
+#ifndef EVAL_RUNS
+#define EVAL_RUNS 5
+#endif
+
+// Cache state of the operands when a timed run starts.
+enum class CacheMode { Hot, Cold, Rotating };
+
+inline const char* cache_mode_name(CacheMode mode) {
+    switch (mode) {
+        case CacheMode::Hot: return "hot";
+        case CacheMode::Cold: return "cold";
+        case CacheMode::Rotating: return "rotating";
+    }
+    return "unknown";
+}
+
+// How the computed C is verified.
+enum class VerifyMode { Auto, Full, Freivalds };
+
+struct HarnessOptions {
+    int warmup_runs = WARMUP_RUNS;
+    int min_runs = EVAL_RUNS;
+    int max_runs = 100;
+    double ci_target = 0;
+    double max_seconds = 60;
+    CacheMode cache = CacheMode::Hot;
+    int rotate_buffers = 0;  // 0: derived from the last-level cache size
+    VerifyMode verify = VerifyMode::Auto;
+    int freivalds_probes = 3;
+    HugePages huge_pages = HugePages::Transparent;
+    NumaMode numa = NumaMode::Off;
+    NumaB numa_B = NumaB::Replicate;
+    Epilogue epilogue{};      // bias is set once harness_main() has loaded bias_file
+    bool epilogue_bias = false;
+    std::string bias_file;
+    bool prefetch = true;     // server mode: read the next case during the current one
+
+    bool has_epilogue() const { return epilogue_bias || !epilogue.identity(); }
+};
+
+// Read the MATMUL_* settings. Returns false (with a message) on invalid values.
+inline bool harness_options_from_env(HarnessOptions& options) {
+    if (const char* env = std::getenv("MATMUL_CACHE")) {
+        const std::string mode = env;
+        if (mode == "hot") options.cache = CacheMode::Hot;
+        else if (mode == "cold") options.cache = CacheMode::Cold;
+        else if (mode == "rotating") options.cache = CacheMode::Rotating;
+        else {
+            std::cerr << "Invalid MATMUL_CACHE '" << mode << "' (expected hot, cold, or rotating)" << std::endl;
+            return false;
+        }
+    }
+    if (const char* env = std::getenv("MATMUL_VERIFY")) {
+        const std::string mode = env;
+        if (mode == "auto") options.verify = VerifyMode::Auto;
+        else if (mode == "full") options.verify = VerifyMode::Full;
+        else if (mode == "freivalds") options.verify = VerifyMode::Freivalds;
+        else {
+            std::cerr << "Invalid MATMUL_VERIFY '" << mode << "' (expected auto, full, or freivalds)" << std::endl;
+            return false;
+        }
+    }
+    if (!huge_pages_from_env(options.huge_pages)) return false;
+    if (!numa_options_from_env(options.numa, options.numa_B)) return false;
+    if (options.numa == NumaMode::Partition && options.numa_B == NumaB::Replicate && options.cache == CacheMode::Rotating) {
+        std::cerr << "MATMUL_NUMA_B=replicate needs a single operand set (use MATMUL_NUMA_B=interleave with "
+                  << "MATMUL_CACHE=rotating)" << std::endl;
+        return false;
+    }
+    if (const char* env = std::getenv("MATMUL_EPILOGUE")) {
+        if (!parse_epilogue(env, options.epilogue, options.epilogue_bias)) {
+            std::cerr << "Invalid MATMUL_EPILOGUE '" << env << "' (expected none or e.g. alpha=1,beta=1,bias,gelu)"
+                      << std::endl;
+            return false;
+        }
+    }
+    if (const char* env = std::getenv("MATMUL_BIAS")) options.bias_file = env;
+    if (options.epilogue_bias && options.bias_file.empty()) {
+        std::cerr << "MATMUL_EPILOGUE with bias needs the bias values in MATMUL_BIAS" << std::endl;
+        return false;
+    }
+    if (const char* env = std::getenv("MATMUL_PREFETCH")) {
+        const std::string mode = env;
+        if (mode == "on") options.prefetch = true;
+        else if (mode == "off") options.prefetch = false;
+        else {
+            std::cerr << "Invalid MATMUL_PREFETCH '" << mode << "' (expected on or off)" << std::endl;
+            return false;
+        }
+    }
+    if (const char* env = std::getenv("MATMUL_FREIVALDS_PROBES")) options.freivalds_probes = std::atoi(env);
+    if (const char* env = std::getenv("MATMUL_ROTATE_BUFFERS")) options.rotate_buffers = std::atoi(env);
+    if (const char* env = std::getenv("MATMUL_CI_TARGET")) options.ci_target = std::atof(env);
+    if (const char* env = std::getenv("MATMUL_MAX_RUNS")) options.max_runs = std::atoi(env);
+    if (const char* env = std::getenv("MATMUL_MAX_SECONDS")) options.max_seconds = std::atof(env);
+    if (options.ci_target < 0 || options.max_runs < options.min_runs || options.max_seconds < 0 ||
+        options.rotate_buffers < 0 || options.freivalds_probes < 1) {
+        std::cerr << "Invalid MATMUL_CI_TARGET, MATMUL_MAX_RUNS, MATMUL_MAX_SECONDS, MATMUL_ROTATE_BUFFERS, "
+                  << "or MATMUL_FREIVALDS_PROBES "
+                  << "(max runs must be at least EVAL_RUNS = " << options.min_runs << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Two-sided 95% Student t quantile for the given degrees of freedom.
+inline double t_quantile_95(int df) {
+    static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df < 1) return std::numeric_limits<double>::infinity();
+    return df <= 30 ? table[df - 1] : 1.960 + 2.4 / df;
+}
+
+// Half-width of the 95% confidence interval of the mean, relative to the mean.
+inline double ci_halfwidth_rel(const std::vector<int64_t>& times) {
+    const size_t n = times.size();
+    if (n < 2) return std::numeric_limits<double>::infinity();
+    double mean = 0;
+    for (int64_t t : times) mean += static_cast<double>(t);
+    mean /= n;
+    double var = 0;
+    for (int64_t t : times) var += (t - mean) * (t - mean);
+    var /= n - 1;
+    return mean > 0 ? t_quantile_95(static_cast<int>(n) - 1) * std::sqrt(var / n) / mean : 0;
+}
+
+// Linear-interpolated quantile (q in [0, 1]) of unsorted values.
+inline double quantile(std::vector<int64_t> values, double q) {
+    std::sort(values.begin(), values.end());
+    const double pos = q * (values.size() - 1);
+    const size_t lo = static_cast<size_t>(pos);
+    const size_t hi = std::min(lo + 1, values.size() - 1);
+    return values[lo] + (pos - lo) * (values[hi] - values[lo]);
+}
+
+// Indices of runs outside Tukey's fences (1.5 interquartile ranges beyond the quartiles).
+// Outliers are reported, not removed: runtimes always holds every eval.
+inline std::vector<size_t> tukey_outliers(const std::vector<int64_t>& times) {
+    std::vector<size_t> outliers;
+    if (times.size() < 4) return outliers;
+    const double q1 = quantile(times, 0.25), q3 = quantile(times, 0.75);
+    const double lo = q1 - 1.5 * (q3 - q1), hi = q3 + 1.5 * (q3 - q1);
+    for (size_t i = 0; i < times.size(); ++i)
+        if (times[i] < lo || times[i] > hi) outliers.push_back(i);
+    return outliers;
+}
+
+// Size of the last-level cache in bytes (64 MiB if unknown).
+inline size_t last_level_cache_bytes() {
+    long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (llc <= 0) llc = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    return llc > 0 ? static_cast<size_t>(llc) : (size_t(64) << 20);
+}
+
+// Evicts the operands from the caches by writing a buffer twice the size of the
+// last-level cache.
+class CacheFlusher {
+public:
+    CacheFlusher() : buffer_(2 * last_level_cache_bytes() / sizeof(uint64_t)) {}
+
+    void flush() {
+        for (uint64_t& v : buffer_) v += 1;
+        sink_ = buffer_[buffer_.size() / 2];
+    }
+
+private:
+    std::vector<uint64_t> buffer_;
+    volatile uint64_t sink_ = 0;
+};
+
+// CPU frequency scaling state of the node. Frequency changes between or during runs are a
+// common source of noise; the harness warns about settings that allow them.
+struct FrequencyInfo {
+    std::string governor = "unknown";  // cpufreq governor of cpu0
+    std::string turbo = "unknown";     // on, off, or unknown
+    double clock_ghz_before = 0;       // estimated core clock before the warmups
+    double clock_ghz_after = 0;        // ... and after the evals
+};
+
+inline std::string read_first_line(const std::string& path) {
+    std::ifstream ifs(path);
+    std::string line;
+    std::getline(ifs, line);
+    return line;
+}
+
+// Estimate the core clock from the time of a chain of dependent integer multiplies
+// (3 cycles latency on current x86 cores; add chains are folded by some renamers).
+// Returns 0 where the probe is not available.
+inline double estimate_clock_ghz() {
+#if defined(__x86_64__)
+    constexpr long iters = 5000000;
+    uint64_t x = 3;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iters; ++i) {
+        asm volatile("imul %0, %0\n\timul %0, %0\n\timul %0, %0\n\timul %0, %0\n\t"
+                     "imul %0, %0\n\timul %0, %0\n\timul %0, %0\n\timul %0, %0" : "+r"(x));
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds > 0 ? 3.0 * 8 * iters / seconds * 1e-9 : 0;
+#else
+    return 0;
+#endif
+}
+
+inline FrequencyInfo frequency_info() {
+    FrequencyInfo info;
+    const std::string governor = read_first_line("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+    if (!governor.empty()) info.governor = governor;
+    const std::string no_turbo = read_first_line("/sys/devices/system/cpu/intel_pstate/no_turbo");
+    const std::string boost = read_first_line("/sys/devices/system/cpu/cpufreq/boost");
+    if (!no_turbo.empty()) info.turbo = no_turbo == "1" ? "off" : "on";
+    else if (!boost.empty()) info.turbo = boost == "1" ? "on" : "off";
+    return info;
+}
+
+inline void warn_about_frequency(const FrequencyInfo& info) {
+    if (info.governor != "performance" && info.governor != "unknown")
+        std::cerr << "Warning: cpufreq governor is '" << info.governor << "', not 'performance'" << std::endl;
+    if (info.turbo == "on")
+        std::cerr << "Warning: turbo boost is enabled; clocks may vary with load and temperature" << std::endl;
+    if (info.clock_ghz_before > 0 && info.clock_ghz_after > 0 &&
+        std::fabs(info.clock_ghz_after / info.clock_ghz_before - 1) > 0.05)
+        std::cerr << "Warning: estimated clock changed from " << info.clock_ghz_before << " to "
+                  << info.clock_ghz_after << " GHz during the benchmark" << std::endl;
+}
+
+// Per-run context for kernels that measure themselves (e.g. with GPU events). By default
+// the harness times run() with a wall clock.
+class RunContext {
+public:
+    // Use this as the run's time instead of the wall-clock time of run().
+    void set_time_ns(int64_t ns) { time_ns_ = ns; }
+    // Record the time of an additional phase; written to runtimes_<name>.
+    void add_phase(const std::string& name, int64_t ns) { phases_.emplace_back(name, ns); }
+
+    int64_t time_ns() const { return time_ns_; }
+    const std::vector<std::pair<std::string, int64_t>>& phases() const { return phases_; }
+
+private:
+    int64_t time_ns_ = -1;
+    std::vector<std::pair<std::string, int64_t>> phases_;
+};
+
+// Inputs of a benchmark, valid from setup() until the harness returns. For int8_t
+// operands, the float inputs are A ~ scale_A * A and B ~ scale_B * B, so a kernel computes
+// C = scale_A * scale_B * (A * B); the scales are 1 for floating-point types.
+// numa describes the placement of the operands (MATMUL_NUMA); in partition mode with
+// MATMUL_NUMA_B=replicate, B_replicas[n] is a copy of B on node n of numa->topology, which
+// threads on that node may read instead of the B a run is passed. B (and every copy of it)
+// is stored in layout_B. epilogue is the one the result must carry; a kernel that fuses
+// it reads it here (in setup()).
+template <typename T>
+struct BasicMatMulProblem {
+    const T* A;          // I x K
+    const T* B;          // K x J, in layout_B
+    const float* init_C; // I x J, C before each run
+    int I, J, K;
+    TensorLayout layout_B{};
+    float scale_A = 1.0f, scale_B = 1.0f;
+    const NumaPlacement* numa = nullptr;
+    std::vector<const T*> B_replicas{};
+    Epilogue epilogue{};
+};
+
+using MatMulProblem = BasicMatMulProblem<float>;
+
+// The operands the timed runs use. In hot and cold mode there is one set: A and B are
+// the loaded inputs and C is reset to init_C before every run. In rotating mode there are
+// several copies of A, B, and C and each run uses the next one, so a run's operands were
+// last touched several runs ago; a C copy is reset when the run after its own starts,
+// not right before its next use, so the reset does not warm it either.
+template <typename T>
+class OperandSets {
+public:
+    // The copies are allocated from arena; check valid() after construction.
+    OperandSets(const BasicMatMulProblem<T>& p, CacheMode mode, int buffers, Arena& arena)
+        : p_(p), size_A_(size_t(p.I) * p.K), size_B_(layout_elements(p.layout_B, p.K, p.J)), size_C_(size_t(p.I) * p.J) {
+        if (mode == CacheMode::Rotating) {
+            if (buffers == 0) {
+                const size_t set_bytes = (size_A_ + size_B_) * sizeof(T) + size_C_ * sizeof(float);
+                buffers = static_cast<int>(std::min<size_t>(2 * last_level_cache_bytes() / set_bytes + 1, 64));
+            }
+            sets_ = std::max(buffers, 2);
+            A_ = arena.allocate<T>(sets_ * size_A_);
+            B_ = arena.allocate<T>(sets_ * size_B_);
+            if (A_.empty() || B_.empty()) return;
+            for (int s = 0; s < sets_; ++s) {
+                first_touch_copy(A_.subspan(s * size_A_, size_A_), p.A);
+                first_touch_copy(B_.subspan(s * size_B_, size_B_), p.B);
+            }
+        }
+        C_ = arena.allocate<float>(sets_ * size_C_);
+        if (C_.empty()) return;
+        for (int s = 0; s < sets_; ++s) first_touch_copy(C_.subspan(s * size_C_, size_C_), p.init_C);
+        valid_ = true;
+    }
+
+    bool valid() const { return valid_; }
+    int count() const { return sets_; }
+    size_t size_B() const { return size_B_; }  // elements of B in its layout
+    bool rotating() const { return sets_ > 1; }
+
+    // Operands of the next run; C holds init_C.
+    void next(const T*& A, const T*& B, float*& C) {
+        if (!rotating() || current_ >= 0) {
+            const int reset = rotating() ? current_ : 0;
+            std::copy(p_.init_C, p_.init_C + size_C_, C_.data() + reset * size_C_);
+        }
+        current_ = (current_ + 1) % sets_;
+        A = rotating() ? A_.data() + current_ * size_A_ : p_.A;
+        B = rotating() ? B_.data() + current_ * size_B_ : p_.B;
+        C = C_.data() + current_ * size_C_;
+    }
+
+    // C of the most recent run.
+    const float* result() const { return C_.data() + std::max(current_, 0) * size_C_; }
+
+    // Operands of set s (e.g. to place their pages).
+    const T* set_A(int s) const { return rotating() ? A_.data() + s * size_A_ : p_.A; }
+    const T* set_B(int s) const { return rotating() ? B_.data() + s * size_B_ : p_.B; }
+    const float* set_C(int s) const { return C_.data() + s * size_C_; }
+
+private:
+    BasicMatMulProblem<T> p_;
+    size_t size_A_, size_B_, size_C_;
+    int sets_ = 1;
+    int current_ = -1;
+    bool valid_ = false;
+    Span<T> A_, B_;
+    Span<float> C_;
+};
+
+template <typename T>
+using BasicMatMulFn = void (*)(const T* A, const T* B, float* C, int I, int J, int K);
+template <typename T>
+using BasicMatMulTimedFn = std::function<void(const T* A, const T* B, float* C, int I, int J, int K, RunContext& ctx)>;
+
+// A competitor's kernel: C (initialized from init_C) = A * B, or with fuses_epilogue
+// C = problem.epilogue(A * B, init_C). Only run is required.
+template <typename T>
+struct BasicMatMulKernel {
+    BasicMatMulKernel(BasicMatMulFn<T> fn)
+        : run([fn](const T* A, const T* B, float* C, int I, int J, int K, RunContext&) { fn(A, B, C, I, J, K); }) {}
+    BasicMatMulKernel(BasicMatMulTimedFn<T> fn) : run(std::move(fn)) {}
+
+    BasicMatMulTimedFn<T> run;
+    // Kernel variant used for a shape, printed and logged (e.g. "tuned 64x128x32").
+    std::function<std::string(int I, int J, int K)> describe;
+    // Comparison tolerance for a shape (default: matmul_tolerance_for<T>(K, scales)).
+    std::function<Tolerance(int I, int J, int K)> tolerance;
+    // Called once before the warmups (e.g. device allocation and upload) and after the evals.
+    std::function<bool(const BasicMatMulProblem<T>& problem)> setup;
+    std::function<void()> teardown;
+    // Whether run() reads B in a layout (default: row-major only), and the layout it reads
+    // fastest (printed by --B-layout).
+    std::function<bool(const TensorLayout& layout)> accepts_B;
+    TensorLayout preferred_B{};
+    // Whether run() applies problem.epilogue itself. Otherwise run() writes A * B to a
+    // scratch matrix and the harness applies the epilogue in a separate pass.
+    bool fuses_epilogue = false;
+    // CPU threads run() computes with, recorded as threads= in runtimes_meta (default 1).
+    std::function<int()> threads;
+    // Compile-time parameters of the kernel (e.g. {"TILE_I", TILE_I}), recorded in run.json.
+    KernelParameters parameters;
+};
+
+using MatMulFn = BasicMatMulFn<float>;
+using MatMulTimedFn = BasicMatMulTimedFn<float>;
+using MatMulKernel = BasicMatMulKernel<float>;
+
+template <typename T>
+inline BasicMatMulKernel<T> make_matmul_kernel(BasicMatMulFn<T> fn) {
+    return BasicMatMulKernel<T>(fn);
+}
+
+// Operand of element type T for the kernel, first-touched in the arena: float inputs are
+// copied, other types converted (with the quantization scale for int8_t). Returns an
+// empty span if the arena cannot provide the memory.
+template <typename T>
+inline Span<const T> kernel_operand(Span<const float> input, Arena& arena, float& scale) {
+    scale = quantization_scale<T>(input.data(), input.size());
+    Span<T> operand = arena.allocate<T>(input.size());
+    if (operand.empty()) return operand;
+    parallel_ranges(parallel_parts(input.size(), size_t(1) << 20), input.size(), [&](size_t, size_t begin, size_t end) {
+        convert_elements(input.data() + begin, operand.data() + begin, end - begin, scale);
+    });
+    return operand;
+}
+
+// Place the operand sets as options.numa asks (after their first touch; mbind moves the
+// pages) and describe the result in placement. Partition mode with replicated B adds one
+// copy of B per node to B_replicas. Returns false if the arena cannot provide the replicas;
+// a kernel without NUMA support only leads to a warning.
+template <typename T>
+inline bool place_operands(const HarnessOptions& options, const OperandSets<T>& operands, int I, int J, int K,
+                           Arena& arena, NumaPlacement& placement, std::vector<const T*>& B_replicas) {
+    placement.mode = options.numa;
+    placement.b = options.numa_B;
+    placement.topology = numa_topology();
+    const NumaTopology& topology = placement.topology;
+    if (options.numa == NumaMode::Off) return true;
+    const size_t size_A = size_t(I) * K, size_B = operands.size_B();
+    bool placed = true;
+    if (options.numa == NumaMode::Partition) {
+        placement.row_begin = numa_row_partition(I, topology, NUMA_ROW_GRANULARITY);
+    }
+    for (int s = 0; s < operands.count(); ++s) {
+        if (options.numa == NumaMode::Interleave) {
+            placed &= numa_place(operands.set_A(s), size_A * sizeof(T), topology.nodes);
+            placed &= numa_place(operands.set_B(s), size_B * sizeof(T), topology.nodes);
+            placed &= numa_place(operands.set_C(s), size_t(I) * J * sizeof(float), topology.nodes);
+            continue;
+        }
+        for (int n = 0; n < topology.size(); ++n) {
+            const int begin = placement.row_begin[n], rows = placement.row_begin[n + 1] - begin;
+            placed &= numa_place(operands.set_A(s) + size_t(begin) * K, size_t(rows) * K * sizeof(T), {topology.nodes[n]});
+            placed &= numa_place(operands.set_C(s) + size_t(begin) * J, size_t(rows) * J * sizeof(float),
+                                 {topology.nodes[n]});
+        }
+        if (options.numa_B == NumaB::Interleave) {
+            placed &= numa_place(operands.set_B(s), size_B * sizeof(T), topology.nodes);
+        }
+    }
+    if (options.numa == NumaMode::Partition && options.numa_B == NumaB::Replicate) {
+        // Bound before the copy writes them, so every page is allocated on its node.
+        for (int n = 0; n < topology.size(); ++n) {
+            Span<T> replica = arena.allocate<T>(size_B);
+            if (replica.empty()) return false;
+            placed &= numa_place(replica.data(), size_B * sizeof(T), {topology.nodes[n]});
+            std::copy(operands.set_B(0), operands.set_B(0) + size_B, replica.data());
+            B_replicas.push_back(replica.data());
+        }
+    }
+    if (!placed) std::cerr << "Warning: mbind failed; operands keep their first-touch placement" << std::endl;
+    return true;
+}
+
+// Write the NUMA topology and where the pages of the first operand set are (sampled, per
+// node in topology order) to filename as key=value lines.
+template <typename T>
+inline bool write_numa_placement(const std::string& filename, const NumaPlacement& placement,
+                                 const OperandSets<T>& operands, const std::vector<const T*>& B_replicas,
+                                 int I, int J, int K) {
+    const NumaTopology& topology = placement.topology;
+    auto pages = [&](const void* addr, size_t bytes) {
+        std::string list;
+        for (size_t count : numa_page_histogram(addr, bytes, topology)) list += (list.empty() ? "" : ",") + std::to_string(count);
+        return list;
+    };
+    std::ofstream ofs(filename);
+    ofs << "mode=" << numa_mode_name(placement.mode) << "\n";
+    if (placement.mode == NumaMode::Partition) ofs << "B=" << numa_b_name(placement.b) << "\n";
+    ofs << "nodes=" << format_cpulist(topology.nodes) << "\n";
+    for (int n = 0; n < topology.size(); ++n) {
+        ofs << "node" << topology.nodes[n] << "_cpus=" << format_cpulist(topology.cpus[n]) << "\n";
+        if (!placement.row_begin.empty()) {
+            ofs << "node" << topology.nodes[n] << "_rows=" << placement.row_begin[n] << "-" << placement.row_begin[n + 1]
+                << "\n";
+        }
+    }
+    ofs << "A_pages=" << pages(operands.set_A(0), size_t(I) * K * sizeof(T)) << "\n";
+    ofs << "B_pages=" << pages(operands.set_B(0), operands.size_B() * sizeof(T)) << "\n";
+    for (size_t n = 0; n < B_replicas.size(); ++n) {
+        ofs << "B_replica" << n << "_pages=" << pages(B_replicas[n], operands.size_B() * sizeof(T)) << "\n";
+    }
+    ofs << "C_pages=" << pages(operands.set_C(0), size_t(I) * J * sizeof(float)) << "\n";
+    return static_cast<bool>(ofs);
+}
+
+inline bool write_times(const std::string& filename, const std::vector<int64_t>& times) {
+    std::ofstream ofs(filename);
+    for (int64_t t : times) ofs << t << "\n";
+    return ofs.good();
+}
+
+// Load a 2D tensor and check its dimensions against the expected ones (-1: any). Unless
+// any_layout is set, the matrix must be row-major.
+inline bool load_matrix(const std::string& filename, TensorView& view, int rows, int cols, const std::string& what,
+                        bool any_layout = false) {
+    if (!load_tensor(filename, view)) {
+        std::cerr << "Failed to read " << filename << std::endl;
+        return false;
+    }
+    const std::vector<int>& dims = view.dims();
+    if (dims.size() != 2 || (rows >= 0 && dims[0] != rows) || (cols >= 0 && dims[1] != cols)) {
+        std::cerr << what << " in " << filename << " has unexpected dimensions" << std::endl;
+        return false;
+    }
+    if (!any_layout && !view.layout().row_major()) {
+        std::cerr << what << " in " << filename << " must be rowmajor, not " << layout_name(view.layout()) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Times of one series of runs (warmups or evals): the run times and any kernel phases.
+struct RunSeries {
+    std::vector<int64_t> times_ns;
+    std::vector<std::pair<std::string, std::vector<int64_t>>> phases;
+
+    void add(int64_t time_ns, const RunContext& ctx) {
+        times_ns.push_back(time_ns);
+        for (const auto& phase : ctx.phases()) {
+            auto it = std::find_if(phases.begin(), phases.end(), [&](const auto& p) { return p.first == phase.first; });
+            if (it == phases.end()) it = phases.insert(phases.end(), {phase.first, {}});
+            it->second.push_back(phase.second);
+        }
+    }
+
+    bool write(const std::string& prefix) const {
+        bool ok = write_times(prefix, times_ns);
+        for (const auto& phase : phases) ok = write_times(prefix + "_" + phase.first, phase.second) && ok;
+        return ok;
+    }
+
+    // The times as record fields <prefix>_ns and <prefix>_phases (see write_run_record()).
+    void add_to(JsonObject& record, const std::string& prefix) const {
+        record.add(prefix + "_ns", times_ns);
+        JsonObject phase_times;
+        for (const auto& phase : phases) phase_times.add(phase.first, phase.second);
+        record.add(prefix + "_phases", phase_times);
+    }
+};
+
+// Write run.json, the structured record of a run, after the other run outputs: the task
+// and problem (e.g. routine and dimensions), whether the result verified, the eval and
+// warmup times, the metrics and runtimes_meta just written (as objects), and the build
+// and node of the run (run_record.h).
+inline bool write_run_record(const JsonObject& problem, bool passed, const RunSeries& warmup, const RunSeries& eval,
+                             const KernelParameters& parameters = {}) {
+    JsonObject record;
+    record.add("schema", 1);
+    record.add("task", task_record());
+    record.add("problem", problem);
+    record.add("passed", passed);
+    eval.add_to(record, "eval");
+    warmup.add_to(record, "warmup");
+    record.add("metrics", key_values_record("metrics", true));
+    record.add("meta", key_values_record("runtimes_meta", false));
+    record.add("build", build_record(parameters));
+    record.add("environment", environment_record());
+    std::ofstream ofs("run.json");
+    ofs << record.str() << "\n";
+    return ofs.good();
+}
+
+// Run the warmups, then the evals: EVAL_RUNS of them, or with MATMUL_CI_TARGET until the
+// confidence interval is narrow enough (within MATMUL_MAX_RUNS and MATMUL_MAX_SECONDS).
+// run_once(series, counted) performs and records one run. Returns the relative CI
+// half-width of the evals.
+template <typename F>
+inline double run_series(const HarnessOptions& options, RunSeries& warmup, RunSeries& eval, F run_once) {
+    for (int w = 0; w < options.warmup_runs; ++w) run_once(warmup, false);
+
+    double ci_rel = std::numeric_limits<double>::infinity();
+    auto eval_start = std::chrono::steady_clock::now();
+    while (true) {
+        run_once(eval, true);
+        const int runs = static_cast<int>(eval.times_ns.size());
+        if (runs < options.min_runs) continue;
+        ci_rel = ci_halfwidth_rel(eval.times_ns);
+        if (options.ci_target <= 0 || ci_rel <= options.ci_target || runs >= options.max_runs) break;
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - eval_start).count();
+        if (elapsed >= options.max_seconds) break;
+    }
+    return ci_rel;
+}
+
+// How the runtimes were measured, as key=value lines of runtimes_meta; callers append
+// their routine's own keys.
+inline void write_runs_meta(std::ostream& meta, const HarnessOptions& options, const std::vector<int64_t>& times_ns,
+                            double ci_rel, const FrequencyInfo& freq) {
+    const std::vector<size_t> outliers = tukey_outliers(times_ns);
+    meta << "warmup_runs=" << options.warmup_runs << "\n";
+    meta << "eval_runs=" << times_ns.size() << "\n";
+    meta << "cache=" << cache_mode_name(options.cache) << "\n";
+    meta << "ci_target=" << options.ci_target << "\n";
+    meta << "ci_halfwidth_rel=" << ci_rel << "\n";
+    meta << "outliers=" << outliers.size() << "\n";
+    meta << "outlier_runs=";
+    for (size_t i = 0; i < outliers.size(); ++i) meta << (i ? "," : "") << outliers[i];
+    meta << "\n";
+    meta << "governor=" << freq.governor << "\n";
+    meta << "turbo=" << freq.turbo << "\n";
+    meta << "clock_ghz_before=" << freq.clock_ghz_before << "\n";
+    meta << "clock_ghz_after=" << freq.clock_ghz_after << "\n";
+}
+
+// Print the average, minimum, and maximum eval time.
+inline void print_timing(const std::vector<int64_t>& times_ns) {
+    int64_t total_ns = 0;
+    int64_t min_ns = std::numeric_limits<int64_t>::max();
+    int64_t max_ns = 0;
+    for (int64_t t : times_ns) {
+        total_ns += t;
+        min_ns = std::min(min_ns, t);
+        max_ns = std::max(max_ns, t);
+    }
+    const double avg_ns = static_cast<double>(total_ns) / times_ns.size();
+    std::cout << "Timing (ns): avg = " << static_cast<int64_t>(avg_ns)
+              << ", min = " << min_ns
+              << ", max = " << max_ns << std::endl;
+}
+
+// Operands of one benchmark case as read from its input files, and the time that took.
+struct MatMulInputs {
+    TensorView A, B, init_C, expected_C, bias;
+    int64_t load_ns = 0;
+    int64_t wait_ns = -1;  // server mode: time the case waited for its inputs
+};
+
+// Read the inputs of a case: paths are A, B, initial C, and an optional gold output C
+// (empty: none). Resolves MATMUL_VERIFY=auto from whether the gold output exists.
+// Returns 0, or the exit status of the failure (with a message).
+template <typename T>
+inline int load_matmul_inputs(const BasicMatMulKernel<T>& kernel, const std::string& path_A, const std::string& path_B,
+                              const std::string& path_C, const std::string& path_gold, HarnessOptions& options,
+                              MatMulInputs& in) {
+    const auto start = std::chrono::steady_clock::now();
+    if (!load_matrix(path_A, in.A, -1, -1, "A")) return 2;
+    const int I = in.A.dims()[0], K = in.A.dims()[1];
+    if (!load_matrix(path_B, in.B, K, -1, "B (K must match A)", true)) return 2;
+    const int J = in.B.dims()[1];
+    const TensorLayout layout_B = in.B.layout();
+    if (!(kernel.accepts_B ? kernel.accepts_B(layout_B) : layout_B.row_major())) {
+        std::cerr << "The kernel does not read B in layout " << layout_name(layout_B) << " (it prefers "
+                  << layout_name(kernel.preferred_B) << ")" << std::endl;
+        return 2;
+    }
+    if (!load_matrix(path_C, in.init_C, I, J, "Initial C")) return 2;
+    // Without a gold output (e.g. sizes the data task skips gold generation for), verify
+    // with Freivalds probes.
+    const bool have_gold = !path_gold.empty() && access(path_gold.c_str(), R_OK) == 0;
+    if (options.verify == VerifyMode::Auto) options.verify = have_gold ? VerifyMode::Full : VerifyMode::Freivalds;
+    if (options.verify == VerifyMode::Full && !load_matrix(path_gold, in.expected_C, I, J, "Expected C")) {
+        std::cerr << "Full verification needs the expected C (or use MATMUL_VERIFY=freivalds)" << std::endl;
+        return 2;
+    }
+    if (options.verify == VerifyMode::Freivalds && options.epilogue.activation != Activation::None) {
+        std::cerr << "Freivalds probes cannot check the " << activation_name(options.epilogue.activation)
+                  << " activation (verify against the gold output)" << std::endl;
+        return 2;
+    }
+    if (options.epilogue_bias && !load_matrix(options.bias_file, in.bias, 1, J, "The bias")) return 2;
+    in.load_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
+
+// Run the benchmark of one case on its loaded inputs and write the run outputs to the
+// current directory. Returns 0 if the result verified, 1 if not, 2 on errors.
+template <typename T>
+inline int benchmark_matmul(const BasicMatMulKernel<T>& kernel, const HarnessOptions& options, const MatMulInputs& in) {
+    const TensorView &A = in.A, &B = in.B, &init_C = in.init_C, &expected_C = in.expected_C, &bias = in.bias;
+    const int I = A.dims()[0], K = A.dims()[1], J = B.dims()[1];
+    const TensorLayout layout_B = B.layout();
+
+    Arena arena(options.huge_pages);
+    BasicMatMulProblem<T> problem{nullptr, nullptr, init_C.data(), I, J, K, layout_B};
+    const Span<const T> kernel_A = kernel_operand<T>(A.span(), arena, problem.scale_A);
+    const Span<const T> kernel_B = kernel_operand<T>(B.span(), arena, problem.scale_B);
+    OperandSets<T> operands(BasicMatMulProblem<T>{kernel_A.data(), kernel_B.data(), init_C.data(), I, J, K, layout_B},
+                            options.cache, options.rotate_buffers, arena);
+    if (kernel_A.empty() || kernel_B.empty() || !operands.valid()) return 2;
+    problem.A = kernel_A.data();
+    problem.B = kernel_B.data();
+    // An epilogue the kernel does not fuse runs on the product the kernel writes to a
+    // scratch matrix, reading the run's C for beta * C_init and writing the result there.
+    problem.epilogue = options.epilogue;
+    const bool epilogue_pass = options.has_epilogue() && !kernel.fuses_epilogue;
+    Span<float> kernel_bias, product;
+    if (options.epilogue_bias) {
+        kernel_bias = arena.allocate<float>(J);
+        if (kernel_bias.empty()) return 2;
+        first_touch_copy(kernel_bias, bias.data());
+        problem.epilogue.bias = kernel_bias.data();
+    }
+    if (epilogue_pass) {
+        product = arena.allocate<float>(size_t(I) * J);
+        if (product.empty()) return 2;
+        first_touch_copy(product, init_C.data());
+    }
+    NumaPlacement placement;
+    if (!place_operands(options, operands, I, J, K, arena, placement, problem.B_replicas)) return 2;
+    problem.numa = &placement;
+    if (kernel.setup && !kernel.setup(problem)) {
+        std::cerr << "Kernel setup failed" << std::endl;
+        return 2;
+    }
+
+    FrequencyInfo freq = frequency_info();
+    freq.clock_ghz_before = estimate_clock_ghz();
+
+    std::unique_ptr<CacheFlusher> flusher;
+    if (options.cache == CacheMode::Cold) flusher.reset(new CacheFlusher());
+
+    // Opened before the warmups so that threads the kernel starts are counted too.
+    PerfCounters perf;
+    perf.open_from_env();
+
+    // One run: reset C, prepare the caches, and time the kernel (and the epilogue pass).
+    auto run_once = [&](RunSeries& series, bool counted) {
+        const T *run_A, *run_B;
+        float* run_C;
+        operands.next(run_A, run_B, run_C);
+        if (flusher) {
+            TRACE_SCOPE("flush caches");
+            flusher->flush();
+        }
+        RunContext ctx;
+        if (counted) perf.start();
+        auto start = std::chrono::high_resolution_clock::now();
+        {
+            TRACE_SCOPE(counted ? "eval" : "warmup");
+            kernel.run(run_A, run_B, epilogue_pass ? product.data() : run_C, I, J, K, ctx);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        int64_t epilogue_ns = 0;
+        if (epilogue_pass) {
+            {
+                TRACE_SCOPE("epilogue");
+                apply_epilogue(problem.epilogue, product.data(), run_C, run_C, I, J);
+            }
+            const auto done = std::chrono::high_resolution_clock::now();
+            epilogue_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(done - end).count();
+            ctx.add_phase("epilogue", epilogue_ns);
+            end = done;
+        }
+        if (counted) perf.stop();
+        const int64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        series.add(ctx.time_ns() >= 0 ? ctx.time_ns() + epilogue_ns : wall_ns, ctx);
+    };
+
+    TRACE_THREAD_NAME("harness");
+    RunSeries warmup, eval;
+    const double ci_rel = run_series(options, warmup, eval, run_once);
+    flusher.reset();
+    if (kernel.teardown) kernel.teardown();
+    freq.clock_ghz_after = estimate_clock_ghz();
+
+    const std::vector<int64_t>& eval_times_ns = eval.times_ns;
+    const int num_evals = static_cast<int>(eval_times_ns.size());
+
+    Tolerance tolerance = kernel.tolerance ? kernel.tolerance(I, J, K)
+                                           : matmul_tolerance_for<T>(K, problem.scale_A, problem.scale_B);
+    if (options.has_epilogue()) {
+        tolerance = epilogue_tolerance(tolerance, problem.epilogue, product_abs_bound(A.data(), B.data(), B.size(), I, K),
+                                       max_abs_value(init_C.data(), init_C.size()),
+                                       max_abs_value(bias.data(), options.epilogue_bias ? J : 0));
+    }
+    const std::string description = kernel.describe ? kernel.describe(I, J, K) : "";
+    const float* calc_C = operands.result();
+
+    std::ofstream logfs("comparison.log");
+    logfs << std::setprecision(std::numeric_limits<float>::max_digits10);
+    if (!description.empty()) logfs << "Kernel: " << description << "\n";
+    logfs << "Operands: " << ElementTraits<T>::name;
+    if (ElementTraits<T>::quantized) logfs << " (scale_A = " << problem.scale_A << ", scale_B = " << problem.scale_B << ")";
+    logfs << "\n";
+    logfs << "B layout: " << layout_name(layout_B) << "\n";
+    if (options.has_epilogue()) {
+        logfs << "Epilogue: " << epilogue_name(problem.epilogue) << (epilogue_pass ? " (separate pass)" : " (fused)") << "\n";
+    }
+    bool equal;
+    // Accuracy of the result, as runtimes_meta lines next to the runtimes they trade against.
+    std::ostringstream accuracy;
+    accuracy << std::setprecision(std::numeric_limits<float>::max_digits10);
+    if (options.verify == VerifyMode::Full) {
+        const ComparisonStats stats = compare_tensors(calc_C, expected_C.data(), expected_C.size(), tolerance);
+        equal = stats.passed();
+        if (equal) {
+            logfs << "PASS: Calculated C matches expected output (" << I << "x" << J << ").\n";
+            std::cout << "PASS: Calculated C matches expected output (" << I << "x" << J << ")." << std::endl;
+        } else {
+            logfs << "FAIL: " << stats.mismatches << " element(s) mismatched (max abs error = " << stats.max_abs << ").\n";
+            std::cout << "FAIL: See comparison.log for details" << std::endl;
+        }
+        write_comparison(logfs, stats, calc_C, expected_C.data(), expected_C.dims(), tolerance);
+        std::cout << "Max diff: " << stats.max_abs << " (rel " << stats.max_rel << ", " << stats.max_ulp << " ULP)" << std::endl;
+        accuracy << "max_abs_error=" << stats.max_abs << "\n";
+        accuracy << "max_rel_error=" << stats.max_rel << "\n";
+        accuracy << "max_ulp_error=" << stats.max_ulp << "\n";
+    } else {
+        std::random_device rd;
+        const uint64_t seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+        // The probes read B row-major.
+        std::vector<float> B_rows;
+        if (!layout_B.row_major()) {
+            B_rows.resize(size_t(K) * J);
+            from_layout(B.data(), layout_B, K, J, B_rows.data());
+        }
+        const FreivaldsStats stats = freivalds_check(A.data(), B_rows.empty() ? B.data() : B_rows.data(), calc_C, I, J,
+                                                     K, tolerance, options.freivalds_probes, seed, init_C.data(),
+                                                     problem.epilogue);
+        equal = stats.passed();
+        if (equal) {
+            logfs << "PASS: Calculated C (" << I << "x" << J << ") passed " << stats.probes << " Freivalds probe(s).\n";
+            std::cout << "PASS: Calculated C (" << I << "x" << J << ") passed " << stats.probes << " Freivalds probe(s)." << std::endl;
+        } else {
+            logfs << "FAIL: " << stats.failed_probes << " of " << stats.probes << " Freivalds probe(s) failed.\n";
+            std::cout << "FAIL: See comparison.log for details" << std::endl;
+        }
+        logfs << "Verification: freivalds, probes: " << stats.probes << ", seed: " << stats.seed << "\n";
+        logfs << "Tolerance: abs = " << tolerance.abs << ", rel = " << tolerance.rel << "\n";
+        logfs << "Max residual / tolerance bound: " << stats.max_ratio << " at row " << stats.worst_row << "\n";
+        logfs << "Resolution: single-element errors of up to " << stats.resolution << " tolerances can pass\n";
+        std::cout << "Max residual: " << stats.max_ratio << " of the tolerance bound" << std::endl;
+        accuracy << "max_residual_ratio=" << stats.max_ratio << "\n";
+        accuracy << "freivalds_resolution=" << stats.resolution << "\n";
+    }
+    logfs.close();
+
+    if (!eval.write("runtimes") || !warmup.write("runtimes_warmup")) {
+        std::cerr << "Failed to write runtimes" << std::endl;
+    }
+    if (!perf.write_csv("perf_counters.csv", eval_times_ns)) {
+        std::cerr << "Failed to write perf_counters.csv" << std::endl;
+    }
+    if (!write_matmul_metrics(eval_times_ns, I, J, K, sizeof(T))) {
+        std::cerr << "Failed to write gflops/metrics" << std::endl;
+    }
+    if (!write_numa_placement("numa_placement", placement, operands, problem.B_replicas, I, J, K)) {
+        std::cerr << "Failed to write numa_placement" << std::endl;
+    }
+
+    std::ofstream meta("runtimes_meta");
+    write_runs_meta(meta, options, eval_times_ns, ci_rel, freq);
+    meta << "operands=" << ElementTraits<T>::name << "\n";
+    meta << "layout_B=" << layout_name(layout_B) << "\n";
+    meta << "verify=" << (options.verify == VerifyMode::Full ? "full" : "freivalds") << "\n";
+    meta << "operand_sets=" << operands.count() << "\n";
+    meta << "huge_pages=" << huge_pages_name(arena.huge_pages()) << "\n";
+    meta << "arena_bytes=" << arena.reserved_bytes() << "\n";
+    meta << "numa=" << numa_mode_name(placement.mode) << "\n";
+    if (placement.mode == NumaMode::Partition) meta << "numa_B=" << numa_b_name(placement.b) << "\n";
+    meta << "numa_nodes=" << placement.topology.size() << "\n";
+    if (!description.empty()) meta << "kernel=" << description << "\n";
+    meta << "threads=" << (kernel.threads ? kernel.threads() : 1) << "\n";
+    meta << "epilogue=" << epilogue_name(problem.epilogue) << "\n";
+    if (options.has_epilogue()) meta << "epilogue_fused=" << (epilogue_pass ? 0 : 1) << "\n";
+    meta << "load_ns=" << in.load_ns << "\n";
+    if (in.wait_ns >= 0) {
+        meta << "served=1\n";
+        meta << "prefetch=" << (options.prefetch ? "on" : "off") << "\n";
+        meta << "load_wait_ns=" << in.wait_ns << "\n";
+    }
+    meta << "tolerance_abs=" << tolerance.abs << "\n";
+    meta << "tolerance_rel=" << tolerance.rel << "\n";
+    meta << accuracy.str();
+#if MATMUL_TRACE
+    // The events of this case only: a server's next case starts a new trace.
+    meta << "trace_events=" << Tracer::instance().events() << "\n";
+    meta << "trace_dropped=" << Tracer::instance().dropped() << "\n";
+    if (!Tracer::instance().write_chrome_trace("trace.json")) std::cerr << "Failed to write trace.json" << std::endl;
+    Tracer::instance().clear();
+#endif
+    meta.close();
+    if (!write_run_record(JsonObject().add("routine", "MatMul").add("I", I).add("J", J).add("K", K), equal, warmup,
+                          eval, kernel.parameters)) {
+        std::cerr << "Failed to write run.json" << std::endl;
+    }
+
+    const size_t outliers = tukey_outliers(eval_times_ns).size();
+    print_timing(eval_times_ns);
+    std::cout << "MatMul (" << I << "x" << K << ") x (" << K << "x" << J << "): "
+              << num_evals << " evals, " << options.warmup_runs << " warmups, " << ElementTraits<T>::name << " operands";
+    if (!layout_B.row_major()) std::cout << ", B " << layout_name(layout_B);
+    if (options.has_epilogue()) {
+        std::cout << ", epilogue " << epilogue_name(problem.epilogue) << (epilogue_pass ? " (separate pass)" : " (fused)");
+    }
+    if (!description.empty()) std::cout << ", kernel = " << description;
+    std::cout << "\n";
+    std::cout << "95% CI of the mean: +-" << ci_rel * 100 << "%, " << outliers << " outlier(s), cache = "
+              << cache_mode_name(options.cache);
+    if (operands.rotating()) std::cout << " (" << operands.count() << " operand sets)";
+    std::cout << std::endl;
+    warn_about_frequency(freq);
+    return equal ? 0 : 1;
+}
+
+// One case of a benchmark server manifest (see serve_matmul()).
+struct ServeCase {
+    std::string dir, A, B, C, gold;
+    std::vector<std::pair<std::string, std::string>> settings;
+    HarnessOptions options;
+};
+
+// Sets environment variables for its lifetime and restores the previous values.
+class ScopedEnv {
+public:
+    explicit ScopedEnv(const std::vector<std::pair<std::string, std::string>>& vars) {
+        for (const auto& var : vars) {
+            const char* old = std::getenv(var.first.c_str());
+            saved_.push_back({var.first, old ? old : "", old != nullptr});
+            setenv(var.first.c_str(), var.second.c_str(), 1);
+        }
+    }
+    ~ScopedEnv() {
+        for (auto it = saved_.rbegin(); it != saved_.rend(); ++it) {
+            if (it->was_set) setenv(it->key.c_str(), it->value.c_str(), 1);
+            else unsetenv(it->key.c_str());
+        }
+    }
+    ScopedEnv(const ScopedEnv&) = delete;
+    ScopedEnv& operator=(const ScopedEnv&) = delete;
+
+private:
+    struct Saved {
+        std::string key, value;
+        bool was_set;
+    };
+    std::vector<Saved> saved_;
+};
+
+// Create dir and any missing parents.
+inline bool make_directories(const std::string& dir) {
+    for (size_t pos = dir.find('/', 1);; pos = dir.find('/', pos + 1)) {
+        if (mkdir(dir.substr(0, pos).c_str(), 0777) != 0 && errno != EEXIST) return false;
+        if (pos == std::string::npos) return true;
+    }
+}
+
+// Read a benchmark server manifest: one case per line,
+//
+//     <output_dir> <input_A> <input_B> <input_C> <output_C|-> [<KEY>=<value> ...]
+//
+// with the gold output C (- for none) and the settings (MATMUL_* variables) the case runs
+// with on top of the server's environment. Blank lines and lines starting with # are
+// skipped; relative paths (also in MATMUL_BIAS) are relative to the working directory.
+inline bool read_serve_manifest(const std::string& path, std::vector<ServeCase>& cases) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Failed to read " << path << std::endl;
+        return false;
+    }
+    char buf[4096];
+    if (!getcwd(buf, sizeof(buf))) return false;
+    const std::string cwd = buf;
+    auto absolute = [&](std::string& p) {
+        if (!p.empty() && p[0] != '/') p = cwd + "/" + p;
+    };
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number) {
+        std::istringstream fields(line);
+        ServeCase c;
+        if (!(fields >> c.dir) || c.dir[0] == '#') continue;
+        if (!(fields >> c.A >> c.B >> c.C >> c.gold)) {
+            std::cerr << path << ":" << number << ": expected <output_dir> <input_A> <input_B> <input_C> <output_C|->"
+                      << std::endl;
+            return false;
+        }
+        if (c.gold == "-") c.gold.clear();
+        for (std::string* p : {&c.dir, &c.A, &c.B, &c.C, &c.gold}) absolute(*p);
+        std::string setting;
+        while (fields >> setting) {
+            const size_t eq = setting.find('=');
+            if (eq == 0 || eq == std::string::npos) {
+                std::cerr << path << ":" << number << ": expected <KEY>=<value>, not '" << setting << "'" << std::endl;
+                return false;
+            }
+            c.settings.emplace_back(setting.substr(0, eq), setting.substr(eq + 1));
+        }
+        ScopedEnv env(c.settings);
+        if (!harness_options_from_env(c.options)) {
+            std::cerr << path << ":" << number << ": invalid settings" << std::endl;
+            return false;
+        }
+        absolute(c.options.bias_file);
+        cases.push_back(std::move(c));
+    }
+    if (cases.empty()) {
+        std::cerr << path << " lists no cases" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Benchmark server: run every case of the manifest in this process, each writing its run
+// outputs to its output directory. With MATMUL_PREFETCH=on (default), a background thread
+// reads the next case's inputs while the current one runs, so the load only stalls the
+// sweep if it takes longer than a benchmark; off reads each case after the previous one
+// (for nodes where the reader would compete with the kernel for cores or memory
+// bandwidth). runtimes_meta records the load time and how long the case waited for it.
+// Returns the worst exit status of the cases.
+template <typename T>
+inline int serve_matmul(const BasicMatMulKernel<T>& kernel, const std::string& manifest) {
+    HarnessOptions server;
+    std::vector<ServeCase> cases;
+    if (!harness_options_from_env(server) || !read_serve_manifest(manifest, cases)) return 1;
+    char buf[4096];
+    if (!getcwd(buf, sizeof(buf))) return 2;
+    const std::string cwd = buf;
+
+    struct LoadedCase {
+        int status = 2;
+        MatMulInputs inputs;
+    };
+    // Settings are parsed up front: the reader thread touches neither the environment nor
+    // any case but its own.
+    auto load = [&](size_t c) {
+        return std::async(server.prefetch ? std::launch::async : std::launch::deferred, [&kernel, &cases, c] {
+            ServeCase& sc = cases[c];
+            LoadedCase loaded;
+            loaded.status = load_matmul_inputs(kernel, sc.A, sc.B, sc.C, sc.gold, sc.options, loaded.inputs);
+            return loaded;
+        });
+    };
+
+    int status = 0;
+    std::future<LoadedCase> next = load(0);
+    for (size_t c = 0; c < cases.size(); ++c) {
+        ServeCase& sc = cases[c];
+        const auto wait_start = std::chrono::steady_clock::now();
+        LoadedCase loaded = next.get();
+        loaded.inputs.wait_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wait_start).count();
+        if (c + 1 < cases.size()) next = load(c + 1);
+        std::cout << "== Case " << c + 1 << "/" << cases.size() << ": " << sc.dir << std::endl;
+        int case_status = loaded.status;
+        if (case_status != 0) {
+            // The reader's messages came before this case's header.
+            std::cerr << "Failed to load the inputs of " << sc.dir << std::endl;
+        } else if (!make_directories(sc.dir) || chdir(sc.dir.c_str()) != 0) {
+            std::cerr << "Cannot enter the output directory " << sc.dir << std::endl;
+            case_status = 2;
+        } else {
+            sc.options.prefetch = server.prefetch;
+            ScopedEnv env(sc.settings);
+            case_status = benchmark_matmul(kernel, sc.options, loaded.inputs);
+            if (chdir(cwd.c_str()) != 0) return 2;
+        }
+        status = std::max(status, case_status);
+    }
+    return status;
+}
+
+template <typename T>
+inline int harness_main(int argc, char* argv[], const BasicMatMulKernel<T>& kernel) {
+    if (argc == 2 && std::string(argv[1]) == "--B-layout") {
+        std::cout << layout_name(kernel.preferred_B) << std::endl;
+        return 0;
+    }
+    if (argc == 3 && std::string(argv[1]) == "--serve") return serve_matmul(kernel, argv[2]);
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <input_A> <input_B> <input_C> [<output_C>]\n"
+                  << "       " << argv[0] << " --serve <manifest>" << std::endl;
+        return 1;
+    }
+    HarnessOptions options;
+    if (!harness_options_from_env(options)) return 1;
+    MatMulInputs inputs;
+    if (const int status = load_matmul_inputs(kernel, argv[1], argv[2], argv[3], argc > 4 ? argv[4] : "", options, inputs)) {
+        return status;
+    }
+    return benchmark_matmul(kernel, options, inputs);
+}
+
+// Define main() for a competitor whose kernel needs nothing beyond the plain signature.
+#define REGISTER_MATMUL_KERNEL(fn)                                      \
+    int main(int argc, char* argv[]) {                                  \
+        return harness_main(argc, argv, make_matmul_kernel(fn));        \
+    }
+
+#endif /* HARNESS_H */
@@ -0,0 +1,224 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+// NUMA topology and operand placement for multi-socket nodes, without a libnuma
+// dependency: the topology is read from sysfs and pages are placed and located with the
+// mbind and move_pages system calls. On single-node systems (or kernels without NUMA
+// support) placement is a no-op and every page reports node 0.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Memory policy constants of <linux/mempolicy.h>.
+constexpr int NUMA_MPOL_BIND = 2;
+constexpr int NUMA_MPOL_INTERLEAVE = 3;
+constexpr unsigned NUMA_MPOL_MF_MOVE = 1u << 1;
+
+// CPUs the calling thread may run on, in ascending order.
+inline std::vector<int> thread_affinity_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c)
+            if (CPU_ISSET(c, &set)) cpus.push_back(c);
+    }
+    if (cpus.empty()) {
+        for (unsigned c = 0; c < std::max(1u, std::thread::hardware_concurrency()); ++c) cpus.push_back(static_cast<int>(c));
+    }
+    return cpus;
+}
+
+// CPUs the process may run on, in ascending order. Read once, before a kernel pins the
+// calling thread (the parallel competitor's pool does), so that every case of a benchmark
+// server sees all of them.
+inline const std::vector<int>& affinity_cpus() {
+    static const std::vector<int> cpus = thread_affinity_cpus();
+    return cpus;
+}
+
+// Parse a sysfs CPU or node list such as "0-3,8,10-11".
+inline std::vector<int> parse_cpulist(const std::string& list) {
+    std::vector<int> values;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        const size_t dash = item.find('-');
+        const int lo = std::atoi(item.substr(0, dash).c_str());
+        const int hi = dash == std::string::npos ? lo : std::atoi(item.substr(dash + 1).c_str());
+        for (int v = lo; v <= hi; ++v) values.push_back(v);
+    }
+    return values;
+}
+
+// Format ascending values as a list such as "0-3,8".
+inline std::string format_cpulist(const std::vector<int>& values) {
+    std::string out;
+    for (size_t i = 0; i < values.size();) {
+        size_t j = i;
+        while (j + 1 < values.size() && values[j + 1] == values[j] + 1) ++j;
+        if (!out.empty()) out += ",";
+        out += std::to_string(values[i]);
+        if (j > i) out += "-" + std::to_string(values[j]);
+        i = j + 1;
+    }
+    return out;
+}
+
+// NUMA nodes with CPUs the process may use.
+struct NumaTopology {
+    std::vector<int> nodes;              // node ids, ascending
+    std::vector<std::vector<int>> cpus;  // allowed CPUs of each node
+
+    int size() const { return static_cast<int>(nodes.size()); }
+};
+
+inline NumaTopology numa_topology() {
+    NumaTopology topology;
+    const std::vector<int> allowed = affinity_cpus();
+    std::ifstream online_file("/sys/devices/system/node/online");
+    std::string online;
+    std::getline(online_file, online);
+    for (int node : parse_cpulist(online)) {
+        std::ifstream ifs("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        std::getline(ifs, list);
+        std::vector<int> cpus;
+        for (int c : parse_cpulist(list))
+            if (std::binary_search(allowed.begin(), allowed.end(), c)) cpus.push_back(c);
+        if (cpus.empty()) continue;
+        topology.nodes.push_back(node);
+        topology.cpus.push_back(cpus);
+    }
+    if (topology.nodes.empty()) {
+        topology.nodes.push_back(0);
+        topology.cpus.push_back(allowed);
+    }
+    return topology;
+}
+
+// How the harness places the operands.
+enum class NumaMode { Off, Interleave, Partition };
+// Where B goes in partition mode.
+enum class NumaB { Interleave, Replicate };
+
+inline const char* numa_mode_name(NumaMode mode) {
+    switch (mode) {
+        case NumaMode::Off: return "off";
+        case NumaMode::Interleave: return "interleave";
+        case NumaMode::Partition: return "partition";
+    }
+    return "unknown";
+}
+
+inline const char* numa_b_name(NumaB b) { return b == NumaB::Interleave ? "interleave" : "replicate"; }
+
+// Read MATMUL_NUMA (off, interleave, or partition) and MATMUL_NUMA_B (interleave or
+// replicate). Returns false (with a message) on invalid values.
+inline bool numa_options_from_env(NumaMode& mode, NumaB& b) {
+    if (const char* env = std::getenv("MATMUL_NUMA")) {
+        const std::string name = env;
+        if (name == "off") mode = NumaMode::Off;
+        else if (name == "interleave") mode = NumaMode::Interleave;
+        else if (name == "partition") mode = NumaMode::Partition;
+        else {
+            std::cerr << "Invalid MATMUL_NUMA '" << name << "' (expected off, interleave, or partition)" << std::endl;
+            return false;
+        }
+    }
+    if (const char* env = std::getenv("MATMUL_NUMA_B")) {
+        const std::string name = env;
+        if (name == "interleave") b = NumaB::Interleave;
+        else if (name == "replicate") b = NumaB::Replicate;
+        else {
+            std::cerr << "Invalid MATMUL_NUMA_B '" << name << "' (expected interleave or replicate)" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Split rows into one contiguous block per node, proportional to the node's CPUs and in
+// multiples of granularity rows: block n is [begin[n], begin[n + 1]).
+inline std::vector<int> numa_row_partition(int rows, const NumaTopology& topology, int granularity) {
+    size_t total_cpus = 0;
+    for (const auto& cpus : topology.cpus) total_cpus += cpus.size();
+    const long blocks = (rows + granularity - 1) / granularity;
+    std::vector<int> begin(topology.size() + 1, rows);
+    size_t cpus_before = 0;
+    for (int n = 0; n < topology.size(); ++n) {
+        begin[n] = static_cast<int>(std::min<long>(blocks * cpus_before / total_cpus * granularity, rows));
+        cpus_before += topology.cpus[n].size();
+    }
+    return begin;
+}
+
+// Bind [addr, addr + bytes) to one node, or interleave it page by page over several,
+// moving pages that are already resident. The range is widened to whole pages.
+inline bool numa_place(const void* addr, size_t bytes, const std::vector<int>& nodes) {
+    if (bytes == 0 || nodes.empty()) return true;
+    const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(addr) / page * page;
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(addr) + bytes + page - 1) / page * page;
+    const int max_node = *std::max_element(nodes.begin(), nodes.end());
+    std::vector<unsigned long> mask(max_node / (8 * sizeof(unsigned long)) + 1, 0);
+    for (int n : nodes) mask[n / (8 * sizeof(unsigned long))] |= 1ul << (n % (8 * sizeof(unsigned long)));
+    const int mode = nodes.size() == 1 ? NUMA_MPOL_BIND : NUMA_MPOL_INTERLEAVE;
+    return syscall(SYS_mbind, begin, end - begin, mode, mask.data(), mask.size() * 8 * sizeof(unsigned long) + 1,
+                   NUMA_MPOL_MF_MOVE) == 0;
+}
+
+// Pages of [addr, addr + bytes) on each node of topology (in its order), from at most
+// max_samples evenly spaced pages; pages that are not resident or not on a listed node
+// are not counted.
+inline std::vector<size_t> numa_page_histogram(const void* addr, size_t bytes, const NumaTopology& topology,
+                                                size_t max_samples = 4096) {
+    std::vector<size_t> counts(topology.size(), 0);
+    const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(addr) / page * page;
+    const size_t pages = (reinterpret_cast<uintptr_t>(addr) + bytes - begin + page - 1) / page;
+    if (bytes == 0 || pages == 0) return counts;
+    const size_t samples = std::min(pages, max_samples);
+    std::vector<void*> addrs(samples);
+    for (size_t s = 0; s < samples; ++s) addrs[s] = reinterpret_cast<void*>(begin + pages * s / samples * page);
+    std::vector<int> status(samples, -1);
+    if (syscall(SYS_move_pages, 0, samples, addrs.data(), nullptr, status.data(), 0) != 0) {
+        // Without NUMA support every page is on the one node.
+        if (topology.size() == 1) counts[0] = samples;
+        return counts;
+    }
+    for (int st : status) {
+        const auto it = std::find(topology.nodes.begin(), topology.nodes.end(), st);
+        if (it != topology.nodes.end()) ++counts[it - topology.nodes.begin()];
+    }
+    return counts;
+}
+
+// The placement the harness applied, passed to kernels through the problem.
+struct NumaPlacement {
+    NumaMode mode = NumaMode::Off;
+    NumaB b = NumaB::Replicate;
+    NumaTopology topology;
+    // Partition mode: rows [row_begin[n], row_begin[n + 1]) of A and C are on node n.
+    std::vector<int> row_begin;
+};
+
+// Rows of a node's partition block are a multiple of this (the parallel competitor's
+// default tile height), so thread tiles do not straddle two nodes.
+#ifndef NUMA_ROW_GRANULARITY
+#define NUMA_ROW_GRANULARITY 32
+#endif
+
+#endif /* NUMA_H */
@@ -0,0 +1,180 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// Optional hardware performance counters around the timed kernel call, via perf_event_open.
+// Enabled with MATMUL_PERF=ON in the environment. Each counter is opened on its own
+// (not as a group), so the kernel can multiplex more events than the PMU has counters;
+// values are scaled by time_enabled / time_running. Counters count user space only (so
+// perf_event_paranoid <= 2 suffices) and are inherited by threads created after open(),
+// e.g. thread pools or OpenMP teams started in the warmup runs.
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Bytes transferred per LLC miss, used to estimate DRAM bandwidth.
+#ifndef PERF_CACHE_LINE_BYTES
+#define PERF_CACHE_LINE_BYTES 64
+#endif
+
+class PerfCounters {
+public:
+    // Output columns of one eval run. Several events may add into one column (FP ops are
+    // the weighted sum of the per-width FP_ARITH events).
+    enum Column { CYCLES, INSTRUCTIONS, L1D_MISSES, L2_MISSES, LLC_MISSES, FP_OPS, PAGE_FAULTS, NUM_COLUMNS };
+
+    PerfCounters() = default;
+    ~PerfCounters() {
+        for (Event& e : events_) close(e.fd);
+    }
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Open the counters if MATMUL_PERF=ON. Events the CPU or kernel does not support are
+    // skipped (their columns stay empty). Returns true if at least one counter is active.
+    bool open_from_env() {
+        const char* env = std::getenv("MATMUL_PERF");
+        if (!env || std::string(env) != "ON") return false;
+
+        add(CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        add(INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        add(L1D_MISSES, PERF_TYPE_HW_CACHE, cache_config(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ));
+        add(LLC_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        add(PAGE_FAULTS, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+
+        // No generic L2 or FP events exist; use the vendor's raw events (umask << 8 | event).
+        const std::string vendor = cpu_vendor();
+        if (vendor == "GenuineIntel") {
+            add(L2_MISSES, PERF_TYPE_RAW, 0x3f24);  // L2_RQSTS.MISS
+            // FP_ARITH_INST_RETIRED.{SCALAR,128B,256B,512B}_PACKED_{DOUBLE,SINGLE}; FMAs count twice.
+            add(FP_OPS, PERF_TYPE_RAW, 0x01c7, 1);
+            add(FP_OPS, PERF_TYPE_RAW, 0x02c7, 1);
+            add(FP_OPS, PERF_TYPE_RAW, 0x04c7, 2);
+            add(FP_OPS, PERF_TYPE_RAW, 0x08c7, 4);
+            add(FP_OPS, PERF_TYPE_RAW, 0x10c7, 4);
+            add(FP_OPS, PERF_TYPE_RAW, 0x20c7, 8);
+            add(FP_OPS, PERF_TYPE_RAW, 0x40c7, 8);
+            add(FP_OPS, PERF_TYPE_RAW, 0x80c7, 16);
+        } else if (vendor == "AuthenticAMD") {
+            add(FP_OPS, PERF_TYPE_RAW, 0xff03);  // Retired SSE/AVX FLOPs (Zen 3 and newer)
+        }
+
+        bool hardware = false;
+        for (const Event& e : events_) hardware = hardware || e.column != PAGE_FAULTS;
+        if (!hardware) {
+            std::cerr << "Warning: MATMUL_PERF=ON but no hardware counters could be opened "
+                      << "(check perf_event_paranoid and container/VM PMU access)" << std::endl;
+        }
+        return active();
+    }
+
+    bool active() const { return !events_.empty(); }
+
+    // Bracket one eval run; stop() records the scaled counts of the run.
+    void start() {
+        if (!active()) return;
+        for (Event& e : events_) {
+            ioctl(e.fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(e.fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    void stop() {
+        if (!active()) return;
+        for (Event& e : events_) ioctl(e.fd, PERF_EVENT_IOC_DISABLE, 0);
+        Sample sample;
+        for (Event& e : events_) {
+            uint64_t values[3] = {};  // value, time_enabled, time_running
+            if (read(e.fd, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) || values[2] == 0) continue;
+            const double scaled = static_cast<double>(values[0]) * values[1] / values[2];
+            sample.value[e.column] += scaled * e.weight;
+            sample.valid[e.column] = true;
+        }
+        samples_.push_back(sample);
+    }
+
+    // Write one CSV row per recorded run: raw counts, plus IPC and an estimated DRAM
+    // bandwidth (LLC misses x cache line / runtime). Unavailable counters are left empty.
+    bool write_csv(const std::string& filename, const std::vector<int64_t>& runtimes_ns) const {
+        if (!active()) return true;
+        std::ofstream ofs(filename);
+        if (!ofs) return false;
+        ofs << "run,time_ns,cycles,instructions,l1d_misses,l2_misses,llc_misses,fp_ops,page_faults,"
+            << "ipc,est_dram_bandwidth_gbs\n";
+        ofs.setf(std::ios::fixed);
+        for (size_t r = 0; r < samples_.size(); ++r) {
+            const Sample& s = samples_[r];
+            const int64_t t = r < runtimes_ns.size() ? runtimes_ns[r] : 0;
+            ofs << r << "," << t;
+            for (int c = 0; c < NUM_COLUMNS; ++c) {
+                ofs << ",";
+                if (s.valid[c]) ofs << std::setprecision(0) << s.value[c];
+            }
+            ofs << ",";
+            if (s.valid[CYCLES] && s.valid[INSTRUCTIONS] && s.value[CYCLES] > 0)
+                ofs << std::setprecision(3) << s.value[INSTRUCTIONS] / s.value[CYCLES];
+            ofs << ",";
+            if (s.valid[LLC_MISSES] && t > 0)
+                ofs << std::setprecision(3) << s.value[LLC_MISSES] * PERF_CACHE_LINE_BYTES / t;
+            ofs << "\n";
+        }
+        return ofs.good();
+    }
+
+private:
+    struct Event {
+        int fd;
+        Column column;
+        double weight;
+    };
+    struct Sample {
+        double value[NUM_COLUMNS] = {};
+        bool valid[NUM_COLUMNS] = {};
+    };
+
+    static uint64_t cache_config(uint64_t cache, uint64_t op) {
+        return cache | (op << 8) | (static_cast<uint64_t>(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+    }
+
+    static std::string cpu_vendor() {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line)) {
+            if (line.compare(0, 9, "vendor_id") == 0) {
+                size_t colon = line.find(':');
+                return colon == std::string::npos ? "" : line.substr(line.find_first_not_of(" \t", colon + 1));
+            }
+        }
+        return "";
+    }
+
+    void add(Column column, uint32_t type, uint64_t config, double weight = 1) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd >= 0) events_.push_back({fd, column, weight});
+    }
+
+    std::vector<Event> events_;
+    std::vector<Sample> samples_;
+};
+
+#endif /* PERF_COUNTERS_H */
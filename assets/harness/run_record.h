@@ -0,0 +1,284 @@
+#ifndef RUN_RECORD_H
+#define RUN_RECORD_H
+
+// Structured run records: every harness writes run.json next to the plain-text run outputs,
+// one JSON object with the problem, the timings and metrics (see write_run_record() in
+// harness.h), the build the binary came from, and the node it ran on. The records of an
+// experiment are aggregated into one file by `runtimes.py --mode aggregate`, so the plots
+// and the regression check see why two runs differ (a compile flag, a tile size, a CPU
+// model, a frequency) without going back to the run folders.
+//
+// The build is recorded from the compiler's predefined macros in the competitor's
+// translation unit (this header is included there), plus MATMUL_BUILD_FLAGS: the compiler
+// command line, which the build tasks pass in (tasks/build/run_env.sh).
+
+#include "numa.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#ifndef MATMUL_BUILD_FLAGS
+#define MATMUL_BUILD_FLAGS ""
+#endif
+
+inline std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (const char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out + "\"";
+}
+
+// Shortest representation that reads back as the same double; null for NaN and infinities,
+// which JSON has no numbers for.
+inline std::string json_number(double value) {
+    if (!std::isfinite(value)) return "null";
+    char buf[32];
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+        std::snprintf(buf, sizeof(buf), "%.0f", value);
+        return buf;
+    }
+    for (int precision = 1; precision <= 17; ++precision) {
+        std::snprintf(buf, sizeof(buf), "%.*g", precision, value);
+        if (std::strtod(buf, nullptr) == value) break;
+    }
+    return buf;
+}
+
+// A JSON object built field by field, in insertion order.
+class JsonObject {
+public:
+    JsonObject& add(const std::string& key, const std::string& value) { return add_raw(key, json_string(value)); }
+    // nullptr (e.g. an unset environment variable) is written as null.
+    JsonObject& add(const std::string& key, const char* value) {
+        return add_raw(key, value ? json_string(value) : "null");
+    }
+    JsonObject& add(const std::string& key, bool value) { return add_raw(key, value ? "true" : "false"); }
+    JsonObject& add(const std::string& key, double value) { return add_raw(key, json_number(value)); }
+    template <typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    JsonObject& add(const std::string& key, T value) { return add_raw(key, std::to_string(value)); }
+    JsonObject& add(const std::string& key, const std::vector<int64_t>& values) {
+        std::string s = "[";
+        for (size_t i = 0; i < values.size(); ++i) s += (i ? ", " : "") + std::to_string(values[i]);
+        return add_raw(key, s + "]");
+    }
+    JsonObject& add(const std::string& key, const JsonObject& object) { return add_raw(key, object.str()); }
+
+    // Add a serialized JSON value as is.
+    JsonObject& add_raw(const std::string& key, const std::string& value) {
+        fields_.emplace_back(key, value);
+        return *this;
+    }
+
+    // One field per line, nested objects indented under their key.
+    std::string str() const {
+        if (fields_.empty()) return "{}";
+        std::string s = "{\n";
+        for (size_t i = 0; i < fields_.size(); ++i) {
+            std::string value = fields_[i].second;
+            for (size_t pos = 0; (pos = value.find('\n', pos)) != std::string::npos; pos += 3) {
+                value.insert(pos + 1, "  ");
+            }
+            s += "  " + json_string(fields_[i].first) + ": " + value + (i + 1 < fields_.size() ? ",\n" : "\n");
+        }
+        return s + "}";
+    }
+
+private:
+    std::vector<std::pair<std::string, std::string>> fields_;
+};
+
+// key=value lines of a run output file (runtimes_meta, metrics) as an object: values as
+// strings, or with numeric set as numbers where they parse as one (others are skipped).
+inline JsonObject key_values_record(const std::string& path, bool numeric) {
+    JsonObject object;
+    std::ifstream ifs(path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+        const size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        const std::string key = line.substr(0, eq), value = line.substr(eq + 1);
+        if (!numeric) {
+            object.add(key, value);
+            continue;
+        }
+        char* end = nullptr;
+        const double number = std::strtod(value.c_str(), &end);
+        if (!value.empty() && *end == '\0') object.add(key, number);
+    }
+    return object;
+}
+
+// Value of the first "<field> : <value>" line of /proc/cpuinfo ("" if there is none).
+inline std::string cpuinfo_field(const std::string& field) {
+    std::ifstream ifs("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(ifs, line)) {
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos || line.compare(0, field.size(), field) != 0) continue;
+        if (line.find_first_not_of(" \t", field.size()) != colon) continue;
+        const size_t begin = line.find_first_not_of(' ', colon + 1);
+        return begin == std::string::npos ? "" : line.substr(begin);
+    }
+    return "";
+}
+
+// The node a run executed on: host, CPU model and clocks, the CPUs the process may use,
+// the SLURM job (null fields outside one), and the time the record was written.
+inline JsonObject environment_record() {
+    JsonObject env;
+    char host[256] = {};
+    gethostname(host, sizeof(host) - 1);
+    env.add("node", std::string(host));
+    const std::string model = cpuinfo_field("model name");
+    env.add("cpu_model", model.empty() ? "unknown" : model);
+    const std::string mhz = cpuinfo_field("cpu MHz");
+    env.add("cpu_mhz", mhz.empty() ? std::nan("") : std::strtod(mhz.c_str(), nullptr));
+    std::ifstream max_freq("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
+    double max_khz = 0;
+    env.add("cpu_max_mhz", max_freq >> max_khz ? max_khz / 1000 : std::nan(""));
+    env.add("cpus_online", static_cast<int64_t>(sysconf(_SC_NPROCESSORS_ONLN)));
+    env.add("cpus_allowed", static_cast<int64_t>(affinity_cpus().size()));
+    env.add("omp_num_threads", std::getenv("OMP_NUM_THREADS"));
+    env.add("slurm_job_id", std::getenv("SLURM_JOB_ID"));
+    env.add("slurm_partition", std::getenv("SLURM_JOB_PARTITION"));
+    env.add("slurm_nodelist", std::getenv("SLURM_JOB_NODELIST"));
+    env.add("slurm_cpus_per_task", std::getenv("SLURM_CPUS_PER_TASK"));
+    char timestamp[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    env.add("timestamp", std::string(timestamp));
+    return env;
+}
+
+// The task that started the run, from the variables its task_meta.sh chain exports.
+inline JsonObject task_record() {
+    JsonObject task;
+    task.add("routine", std::getenv("ROUTINE"));
+    task.add("input_size", std::getenv("INPUT_SIZE"));
+    task.add("competitor", std::getenv("COMPETITOR"));
+    task.add("build_folder", std::getenv("BUILD_FOLDER"));
+    task.add("run_id", std::getenv("RUN_ID"));
+    return task;
+}
+
+// Add an instruction-set name to a space-separated list.
+inline void isa_append(std::string& isa, const char* name) {
+    if (!isa.empty()) isa += ' ';
+    isa += name;
+}
+
+// Compile-time parameters of a kernel (tile sizes, cutoffs, ...), by macro name.
+using KernelParameters = std::vector<std::pair<std::string, double>>;
+
+// The build of the binary: compiler, command line, the optimization and instruction-set
+// macros it compiled with, and the kernel's compile-time parameters.
+inline JsonObject build_record(const KernelParameters& parameters) {
+    JsonObject build;
+#if defined(__clang__) || defined(__INTEL_LLVM_COMPILER)
+    build.add("compiler", __VERSION__);
+#elif defined(__GNUC__)
+    build.add("compiler", "gcc " __VERSION__);
+#else
+    build.add("compiler", "unknown");
+#endif
+    build.add("flags", MATMUL_BUILD_FLAGS);
+    std::string isa;
+#if defined(__SSE4_2__)
+    isa_append(isa, "sse4.2");
+#endif
+#if defined(__AVX__)
+    isa_append(isa, "avx");
+#endif
+#if defined(__AVX2__)
+    isa_append(isa, "avx2");
+#endif
+#if defined(__FMA__)
+    isa_append(isa, "fma");
+#endif
+#if defined(__F16C__)
+    isa_append(isa, "f16c");
+#endif
+#if defined(__AVX512F__)
+    isa_append(isa, "avx512f");
+#endif
+#if defined(__AVX512BW__)
+    isa_append(isa, "avx512bw");
+#endif
+#if defined(__AVX512VL__)
+    isa_append(isa, "avx512vl");
+#endif
+#if defined(__AVX512VNNI__)
+    isa_append(isa, "avx512vnni");
+#endif
+#if defined(__AVX512BF16__)
+    isa_append(isa, "avx512bf16");
+#endif
+#if defined(__AVX512FP16__)
+    isa_append(isa, "avx512fp16");
+#endif
+#if defined(__AMX_TILE__)
+    isa_append(isa, "amx-tile");
+#endif
+#if defined(__ARM_NEON)
+    isa_append(isa, "neon");
+#endif
+#if defined(__ARM_FEATURE_SVE)
+    isa_append(isa, "sve");
+#endif
+    build.add("isa", isa);
+#if defined(__OPTIMIZE__)
+    build.add("optimize", true);
+#else
+    build.add("optimize", false);
+#endif
+#if defined(__FAST_MATH__)
+    build.add("fast_math", true);
+#else
+    build.add("fast_math", false);
+#endif
+#if defined(_OPENMP)
+    build.add("openmp", true);
+#else
+    build.add("openmp", false);
+#endif
+#if defined(NDEBUG)
+    build.add("ndebug", true);
+#else
+    build.add("ndebug", false);
+#endif
+#if defined(MATMUL_TRACE) && MATMUL_TRACE
+    build.add("trace", true);
+#else
+    build.add("trace", false);
+#endif
+    JsonObject params;
+    for (const auto& p : parameters) params.add(p.first, p.second);
+    build.add("parameters", params);
+    return build;
+}
+
+#endif /* RUN_RECORD_H */
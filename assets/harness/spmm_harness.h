@@ -0,0 +1,234 @@
+#ifndef SPMM_HARNESS_H
+#define SPMM_HARNESS_H
+
+// Benchmark harness for SpMM competitors: every timed run computes C = A * B for a sparse
+// I x K matrix A (CSR or BSR, see sparse_helper.h) and a dense K x J matrix B, from the
+// files of the SpMM data generator. A competitor provides the kernel and registers it:
+//
+//     void spmm(const SparseView& A, const float* B, float* C, int J) { ... }
+//     REGISTER_SPMM_KERNEL(spmm)
+//
+// Runs are measured as in harness.h (MATMUL_CACHE hot or cold, MATMUL_CI_TARGET, ...,
+// MATMUL_VERIFY, MATMUL_HUGE_PAGES for the Arena holding the operands). Rotating cache
+// mode, MATMUL_NUMA, and MATMUL_EPILOGUE are not supported. Results are checked against
+// the dense gold output with the tolerance of the longest sparse row, and GFLOP/s count
+// the nonzeros only; compare runtimes with the dense competitors of the same data to see
+// where the sparse kernels win.
+
+#include "harness.h"
+#include "sparse_helper.h"
+
+using SpMMFn = void (*)(const SparseView& A, const float* B, float* C, int J);
+using SpMMTimedFn = std::function<void(const SparseView& A, const float* B, float* C, int J, RunContext& ctx)>;
+
+// A competitor's kernel: C (I x J, initialized from init_C) = A * B. Only run is required;
+// the hooks mirror MatMulKernel.
+struct SpMMKernel {
+    SpMMKernel(SpMMFn fn)
+        : run([fn](const SparseView& A, const float* B, float* C, int J, RunContext&) { fn(A, B, C, J); }) {}
+    SpMMKernel(SpMMTimedFn fn) : run(std::move(fn)) {}
+
+    SpMMTimedFn run;
+    std::function<std::string(const SparseView& A, int J)> describe;
+    // Comparison tolerance (default: matmul_tolerance() of the longest row).
+    std::function<Tolerance(const SparseView& A, int J)> tolerance;
+    // Called once before the warmups and after the evals; fails e.g. on an unsupported block size.
+    std::function<bool(const SparseView& A, int J)> setup;
+    std::function<void()> teardown;
+};
+
+// Compulsory memory traffic of one run: the stored blocks with their indices and B read
+// once, C read and written once.
+inline double spmm_min_bytes(const SparseView& A, int J) {
+    const double values = static_cast<double>(A.blocks) * A.block_rows * A.block_cols;
+    return sizeof(float) * values + sizeof(int32_t) * static_cast<double>(A.blocks) +
+           sizeof(int64_t) * (A.block_row_count() + 1.0) + sizeof(float) * (static_cast<double>(A.cols) * J + 2.0 * A.rows * J);
+}
+
+inline int spmm_harness_main(int argc, char* argv[], const SpMMKernel& kernel) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <input_A (csr or bsr)> <input_B> <input_C> [<output_C>]" << std::endl;
+        return 1;
+    }
+    HarnessOptions options;
+    if (!harness_options_from_env(options)) return 1;
+    if (options.cache == CacheMode::Rotating) {
+        std::cerr << "MATMUL_CACHE=rotating is not supported for SpMM (use hot or cold)" << std::endl;
+        return 1;
+    }
+    if (options.numa != NumaMode::Off) {
+        std::cerr << "MATMUL_NUMA is not supported for SpMM (use off)" << std::endl;
+        return 1;
+    }
+    if (options.has_epilogue()) {
+        std::cerr << "MATMUL_EPILOGUE is not supported for SpMM (use none)" << std::endl;
+        return 1;
+    }
+
+    SparseMatrix sparse_A;
+    if (!read_sparse(argv[1], sparse_A)) {
+        std::cerr << "Failed to read sparse A from " << argv[1] << std::endl;
+        return 2;
+    }
+    const int I = sparse_A.rows, K = sparse_A.cols;
+    TensorView B, init_C, expected_C;
+    if (!load_matrix(argv[2], B, K, -1, "B (K must match A)")) return 2;
+    const int J = B.dims()[1];
+    if (!load_matrix(argv[3], init_C, I, J, "Initial C")) return 2;
+    const bool have_gold = argc > 4 && access(argv[4], R_OK) == 0;
+    if (options.verify == VerifyMode::Auto) options.verify = have_gold ? VerifyMode::Full : VerifyMode::Freivalds;
+    if (options.verify == VerifyMode::Full && !load_matrix(argc > 4 ? argv[4] : "", expected_C, I, J, "Expected C")) {
+        std::cerr << "Full verification needs the expected C (or use MATMUL_VERIFY=freivalds)" << std::endl;
+        return 2;
+    }
+
+    // The operands of the timed runs live in the arena.
+    Arena arena(options.huge_pages);
+    const Span<int64_t> row_ptr = arena.copy_of(sparse_A.row_ptr.data(), sparse_A.row_ptr.size());
+    const Span<int32_t> col_idx = arena.copy_of(sparse_A.col_idx.data(), sparse_A.col_idx.size());
+    const Span<float> values = arena.copy_of(sparse_A.values.data(), sparse_A.values.size());
+    const Span<float> operand_B = arena.copy_of(B.data(), B.size());
+    const Span<float> C = arena.allocate<float>(init_C.size());
+    if (row_ptr.empty() || operand_B.empty() || C.empty() || (sparse_A.blocks() > 0 && (col_idx.empty() || values.empty()))) {
+        std::cerr << "Failed to allocate the operands" << std::endl;
+        return 2;
+    }
+    const SparseView A{I, K, sparse_A.block_rows, sparse_A.block_cols, sparse_A.blocks(),
+                       row_ptr.data(), col_idx.data(), values.data()};
+    if (kernel.setup && !kernel.setup(A, J)) {
+        std::cerr << "Kernel setup failed" << std::endl;
+        return 2;
+    }
+
+    FrequencyInfo freq = frequency_info();
+    freq.clock_ghz_before = estimate_clock_ghz();
+
+    std::unique_ptr<CacheFlusher> flusher;
+    if (options.cache == CacheMode::Cold) flusher.reset(new CacheFlusher());
+
+    PerfCounters perf;
+    perf.open_from_env();
+
+    auto run_once = [&](RunSeries& series, bool counted) {
+        std::copy(init_C.data(), init_C.data() + init_C.size(), C.data());
+        if (flusher) flusher->flush();
+        RunContext ctx;
+        if (counted) perf.start();
+        auto start = std::chrono::high_resolution_clock::now();
+        kernel.run(A, operand_B.data(), C.data(), J, ctx);
+        auto end = std::chrono::high_resolution_clock::now();
+        if (counted) perf.stop();
+        const int64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        series.add(ctx.time_ns() >= 0 ? ctx.time_ns() : wall_ns, ctx);
+    };
+
+    RunSeries warmup, eval;
+    const double ci_rel = run_series(options, warmup, eval, run_once);
+    flusher.reset();
+    if (kernel.teardown) kernel.teardown();
+    freq.clock_ghz_after = estimate_clock_ghz();
+
+    const std::vector<int64_t>& eval_times_ns = eval.times_ns;
+    const int num_evals = static_cast<int>(eval_times_ns.size());
+    const Tolerance tolerance = kernel.tolerance ? kernel.tolerance(A, J) : matmul_tolerance(sparse_max_row_terms(A));
+    const std::string description = kernel.describe ? kernel.describe(A, J) : "";
+    const std::string format = sparse_format_name(A.block_rows, A.block_cols);
+    const size_t nonzeros = sparse_nonzeros(A);
+    const double density = static_cast<double>(nonzeros) / (static_cast<double>(I) * K);
+
+    std::ofstream logfs("comparison.log");
+    logfs << std::setprecision(std::numeric_limits<float>::max_digits10);
+    if (!description.empty()) logfs << "Kernel: " << description << "\n";
+    logfs << "A: " << format << ", " << A.blocks << " blocks, " << nonzeros << " nonzeros (density " << density << ")\n";
+    bool equal;
+    std::ostringstream accuracy;
+    accuracy << std::setprecision(std::numeric_limits<float>::max_digits10);
+    if (options.verify == VerifyMode::Full) {
+        const ComparisonStats stats = compare_tensors(C.data(), expected_C.data(), expected_C.size(), tolerance);
+        equal = stats.passed();
+        if (equal) {
+            logfs << "PASS: Calculated C matches expected output (" << I << "x" << J << ").\n";
+            std::cout << "PASS: Calculated C matches expected output (" << I << "x" << J << ")." << std::endl;
+        } else {
+            logfs << "FAIL: " << stats.mismatches << " element(s) mismatched (max abs error = " << stats.max_abs << ").\n";
+            std::cout << "FAIL: See comparison.log for details" << std::endl;
+        }
+        write_comparison(logfs, stats, C.data(), expected_C.data(), expected_C.dims(), tolerance);
+        std::cout << "Max diff: " << stats.max_abs << " (rel " << stats.max_rel << ", " << stats.max_ulp << " ULP)" << std::endl;
+        accuracy << "max_abs_error=" << stats.max_abs << "\n";
+        accuracy << "max_rel_error=" << stats.max_rel << "\n";
+        accuracy << "max_ulp_error=" << stats.max_ulp << "\n";
+    } else {
+        // The probes multiply the dense A.
+        std::random_device rd;
+        const uint64_t seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+        std::vector<float> dense_A(static_cast<size_t>(I) * K);
+        to_dense(A, dense_A.data());
+        const FreivaldsStats stats = freivalds_check(dense_A.data(), B.data(), C.data(), I, J, K, tolerance,
+                                                     options.freivalds_probes, seed);
+        equal = stats.passed();
+        if (equal) {
+            logfs << "PASS: Calculated C (" << I << "x" << J << ") passed " << stats.probes << " Freivalds probe(s).\n";
+            std::cout << "PASS: Calculated C (" << I << "x" << J << ") passed " << stats.probes << " Freivalds probe(s)." << std::endl;
+        } else {
+            logfs << "FAIL: " << stats.failed_probes << " of " << stats.probes << " Freivalds probe(s) failed.\n";
+            std::cout << "FAIL: See comparison.log for details" << std::endl;
+        }
+        logfs << "Verification: freivalds, probes: " << stats.probes << ", seed: " << stats.seed << "\n";
+        logfs << "Tolerance: abs = " << tolerance.abs << ", rel = " << tolerance.rel << "\n";
+        logfs << "Max residual / tolerance bound: " << stats.max_ratio << " at row " << stats.worst_row << "\n";
+        logfs << "Resolution: single-element errors of up to " << stats.resolution << " tolerances can pass\n";
+        std::cout << "Max residual: " << stats.max_ratio << " of the tolerance bound" << std::endl;
+        accuracy << "max_residual_ratio=" << stats.max_ratio << "\n";
+        accuracy << "freivalds_resolution=" << stats.resolution << "\n";
+    }
+    logfs.close();
+
+    if (!eval.write("runtimes") || !warmup.write("runtimes_warmup")) {
+        std::cerr << "Failed to write runtimes" << std::endl;
+    }
+    if (!perf.write_csv("perf_counters.csv", eval_times_ns)) {
+        std::cerr << "Failed to write perf_counters.csv" << std::endl;
+    }
+    if (!write_throughput_metrics(eval_times_ns, 2.0 * static_cast<double>(nonzeros) * J, spmm_min_bytes(A, J))) {
+        std::cerr << "Failed to write gflops/metrics" << std::endl;
+    }
+
+    std::ofstream meta("runtimes_meta");
+    write_runs_meta(meta, options, eval_times_ns, ci_rel, freq);
+    meta << "format=" << format << "\n";
+    meta << "blocks=" << A.blocks << "\n";
+    meta << "nonzeros=" << nonzeros << "\n";
+    meta << "density=" << density << "\n";
+    meta << "huge_pages=" << huge_pages_name(arena.huge_pages()) << "\n";
+    meta << "arena_bytes=" << arena.reserved_bytes() << "\n";
+    meta << "verify=" << (options.verify == VerifyMode::Full ? "full" : "freivalds") << "\n";
+    if (!description.empty()) meta << "kernel=" << description << "\n";
+    meta << "tolerance_abs=" << tolerance.abs << "\n";
+    meta << "tolerance_rel=" << tolerance.rel << "\n";
+    meta << accuracy.str();
+    meta.close();
+    if (!write_run_record(JsonObject().add("routine", "SpMM").add("I", I).add("J", J).add("K", K).add("format", format),
+                          equal, warmup, eval)) {
+        std::cerr << "Failed to write run.json" << std::endl;
+    }
+
+    const size_t outliers = tukey_outliers(eval_times_ns).size();
+    print_timing(eval_times_ns);
+    std::cout << "SpMM (" << I << "x" << K << ", " << format << ", density " << density << ") x (" << K << "x" << J
+              << "): " << num_evals << " evals, " << options.warmup_runs << " warmups";
+    if (!description.empty()) std::cout << ", kernel = " << description;
+    std::cout << "\n";
+    std::cout << "95% CI of the mean: +-" << ci_rel * 100 << "%, " << outliers << " outlier(s), cache = "
+              << cache_mode_name(options.cache) << std::endl;
+    warn_about_frequency(freq);
+    return equal ? 0 : 1;
+}
+
+// Define main() for a competitor whose kernel needs nothing beyond the plain signature.
+#define REGISTER_SPMM_KERNEL(fn)                                          \
+    int main(int argc, char* argv[]) {                                    \
+        return spmm_harness_main(argc, argv, SpMMKernel(fn));             \
+    }
+
+#endif /* SPMM_HARNESS_H */
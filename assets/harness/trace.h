@@ -0,0 +1,198 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Kernel-level tracing: scoped timers that record (name, begin, end) events into
+// per-thread ring buffers, written per run as Chrome trace JSON (trace.json, for
+// ui.perfetto.dev or chrome://tracing) with one track per thread:
+//
+//     for (int pc = 0; pc < K; pc += KC) {
+//         TRACE_SCOPE("pack_B");
+//         ...
+//
+// Tracing is compiled out unless the build defines MATMUL_TRACE=1; TRACE_SCOPE and
+// TRACE_THREAD_NAME then expand to nothing and do not evaluate their arguments. With it,
+// a thread's first event registers its buffer (under a lock, once per thread); after that
+// an event is two clock reads and a store into the thread's own buffer, with no locks and
+// no writes to shared cache lines. A full buffer (TRACE_BUFFER_EVENTS events) overwrites
+// its oldest events; the trace reports how many were dropped. Event names must outlive
+// the export (string literals). The harness traces the warmups and evals, writes the
+// trace after the evals, and clears it for the next case; the buffers are read only
+// while no traced code runs (the kernels' threads are idle between runs).
+
+#include "run_record.h"
+
+#ifndef MATMUL_TRACE
+#define MATMUL_TRACE 0
+#endif
+
+#ifndef TRACE_BUFFER_EVENTS
+#define TRACE_BUFFER_EVENTS 65536
+#endif
+
+#if MATMUL_TRACE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+struct TraceEvent {
+    const char* name;
+    int64_t begin_ns, end_ns;  // since the start of the trace
+};
+
+// Events of one thread. Only the owning thread records; the exporter reads up to the
+// count the owner last published. Aligned so that threads' counts never share a line.
+class alignas(64) TraceBuffer {
+public:
+    explicit TraceBuffer(int tid) : tid_(tid), events_(TRACE_BUFFER_EVENTS) {}
+
+    void record(const char* name, int64_t begin_ns, int64_t end_ns) {
+        const uint64_t n = count_.load(std::memory_order_relaxed);
+        events_[n % events_.size()] = TraceEvent{name, begin_ns, end_ns};
+        count_.store(n + 1, std::memory_order_release);
+    }
+
+    int tid() const { return tid_; }
+    uint64_t count() const { return count_.load(std::memory_order_acquire); }
+    // Index of the first event since the last clear(), and of the first one still held.
+    uint64_t first() const { return cleared_; }
+    uint64_t first_held() const {
+        const uint64_t n = count();
+        return std::max(cleared_, n > events_.size() ? n - events_.size() : 0);
+    }
+    const TraceEvent& event(uint64_t i) const { return events_[i % events_.size()]; }
+    void clear() { cleared_ = count(); }
+
+    std::string name;
+
+private:
+    int tid_;
+    std::vector<TraceEvent> events_;
+    std::atomic<uint64_t> count_{0};
+    uint64_t cleared_ = 0;
+};
+
+class Tracer {
+public:
+    // Never destroyed, so that threads may record until the process exits.
+    static Tracer& instance() {
+        static Tracer* tracer = new Tracer();
+        return *tracer;
+    }
+
+    int64_t now_ns() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count();
+    }
+
+    TraceBuffer& thread_buffer() {
+        thread_local TraceBuffer* buffer = nullptr;
+        if (!buffer) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffers_.emplace_back(new TraceBuffer(static_cast<int>(buffers_.size())));
+            buffer = buffers_.back().get();
+        }
+        return *buffer;
+    }
+
+    void set_thread_name(const std::string& name) {
+        TraceBuffer& buffer = thread_buffer();
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer.name = name;
+    }
+
+    // Events since the last clear(), and how many of them the ring buffers overwrote.
+    uint64_t events() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t n = 0;
+        for (const auto& b : buffers_) n += b->count() - b->first_held();
+        return n;
+    }
+    uint64_t dropped() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t n = 0;
+        for (const auto& b : buffers_) n += b->first_held() - b->first();
+        return n;
+    }
+
+    // Write the events since the last clear() as a Chrome trace: complete ("X") events
+    // in microseconds, and the thread names as metadata events.
+    bool write_chrome_trace(const std::string& filename) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::ofstream ofs(filename);
+        const long pid = static_cast<long>(getpid());
+        uint64_t dropped = 0;
+        ofs << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+        bool first = true;
+        auto separator = [&] {
+            ofs << (first ? "" : ",\n");
+            first = false;
+        };
+        for (const auto& b : buffers_) {
+            separator();
+            const std::string name = b->name.empty() ? "thread " + std::to_string(b->tid()) : b->name;
+            ofs << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << b->tid()
+                << ", \"args\": {\"name\": " << json_string(name) << "}}";
+            const uint64_t end = b->count();
+            dropped += b->first_held() - b->first();
+            for (uint64_t i = b->first_held(); i < end; ++i) {
+                const TraceEvent& e = b->event(i);
+                separator();
+                ofs << "{\"name\": " << json_string(e.name) << ", \"cat\": \"matmul\", \"ph\": \"X\", \"pid\": " << pid
+                    << ", \"tid\": " << b->tid() << ", \"ts\": " << json_number(e.begin_ns / 1e3)
+                    << ", \"dur\": " << json_number((e.end_ns - e.begin_ns) / 1e3) << "}";
+            }
+        }
+        ofs << "\n], \"otherData\": {\"dropped_events\": " << dropped << "}}\n";
+        return ofs.good();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& b : buffers_) b->clear();
+    }
+
+private:
+    Tracer() : epoch_(std::chrono::steady_clock::now()) {}
+
+    std::chrono::steady_clock::time_point epoch_;
+    std::mutex mutex_;  // guards buffers_ and the names; never taken by record()
+    std::vector<std::unique_ptr<TraceBuffer>> buffers_;
+};
+
+// Records one event from construction to destruction on the calling thread.
+class ScopedTrace {
+public:
+    explicit ScopedTrace(const char* name) : name_(name), begin_ns_(Tracer::instance().now_ns()) {}
+    ~ScopedTrace() {
+        Tracer& tracer = Tracer::instance();
+        tracer.thread_buffer().record(name_, begin_ns_, tracer.now_ns());
+    }
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    const char* name_;
+    int64_t begin_ns_;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) ScopedTrace TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) Tracer::instance().set_thread_name(name)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif /* MATMUL_TRACE */
+
+#endif /* TRACE_H */
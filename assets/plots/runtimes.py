@@ -6,15 +6,68 @@ Expected input structure:
   <experiment_dir>/<routine>/<input_size>/<competitor>/<device>-run<N>/runtimes
 
 Each runtimes file contains one runtime value (nanoseconds) per line.
-The "data" competitor folder is ignored.
+The "data" competitor folder is ignored. Runs with a run.json (the structured
+record the harness writes, see assets/harness/run_record.h) are read from it.
+
+With --mode aggregate, the records of every run are written to one results file
+(-o, default results.jsonl: one JSON object per line, the run.json with the
+run's routine, input_size, competitor, device, and run number added) and its
+eval runtimes to a CSV file next to it (results.csv). Every mode reads such a
+results file, or the results.jsonl in a directory, in place of the experiment
+folder, so the tree is walked only once.
 
 Output: a single PDF with one subplot per (device, routine) combination,
 each showing speedup box plots of non-baseline competitors relative to baseline.
+
+With --mode roofline, each subplot instead places every (competitor, input size)
+on the roofline of its device: median GFLOP/s over the arithmetic intensity read
+from the run's metrics file (flops and arithmetic_intensity as key=value lines),
+under the compute and bandwidth roofs read from <peaks_dir>/<device>/peak
+(peak_gflops, peak_bandwidth_gbs, and their single-thread _1t variants).
+
+With --mode sizes, input sizes named <family>_<n> (as generated by an input-size
+sweep, e.g. square_512) are drawn as lines of median GFLOP/s over n, one subplot per
+(device, routine, family) and one line per competitor. With --peaks, dotted lines
+mark where the operands (min_bytes of the run's metrics) outgrow each cache level
+(cache_l1_bytes, cache_l2_bytes, cache_l3_bytes in the device's peak file).
+
+With --mode threads, runs are drawn as lines of median GFLOP/s over their thread
+count (threads= in the run's runtimes_meta, also in its run.json), one subplot per
+(device, routine, input size). The runs of each thread count need run folders of
+their own; a -t<N> suffix of the device prefix (as tasks/scaling/MatMul writes them,
+e.g. assets-t8-run1) is dropped from the device, so all thread counts share a subplot.
+
+Every speedup box carries a bootstrap 95% confidence interval of the median-ratio
+speedup, and competitors whose runtimes differ significantly from the baseline's
+(two-sided Mann-Whitney U test, p < --alpha) are marked with "*". The statistics
+are also written to <output>.tsv. Both take the median runtime of each run as one
+sample: the evals of a run share its process, memory placement, and clock state,
+so they are not independent of each other. Comparisons with too few runs to ever
+reach p < --alpha are reported as such.
+
+With --mode regression --history <results>, the runtimes are compared against
+those of an earlier results file or directory (e.g. one written with
+--save-history) per (routine, input size, competitor, device): a slowdown
+(median ratio) beyond --threshold that is significant is a regression. Groups with
+too few runs for the test to reach p < --alpha are "inconclusive". The comparison
+is written to the --output TSV (default regression.tsv), and the script exits with
+status 1 if any run regressed.
+
+Runs measured with cold or rotating caches (cache= in the run's runtimes_meta)
+are shown as a separate device, e.g. "assets (cold)", so that they are never
+compared against hot-cache runs. Likewise, runs with a NUMA placement policy
+(numa= and numa_B= in runtimes_meta) are grouped by it, e.g.
+"assets (numa=partition/replicate)" or "assets (cold, numa=interleave)".
 """
 import argparse
+import csv
+import json
+import math
 import re
+import sys
 from collections import defaultdict
 from pathlib import Path
+from typing import NamedTuple
 
 import matplotlib.pyplot as plt
 import numpy as np
@@ -24,15 +77,72 @@ def natural_sort_key(s: str):
     return [int(c) if c.isdigit() else c.lower() for c in re.split(r"(\d+)", s)]
 
 
-def discover_data(
-    experiment_dir: Path,
-) -> dict[tuple[str, str, str, str], list[float]]:
+RESULTS_FILE = "results.jsonl"
+
+
+def read_run_meta(run_dir: Path) -> dict[str, str]:
+    """key=value lines of the run's runtimes_meta (empty if there is none)."""
+    meta = {}
+    meta_file = run_dir / "runtimes_meta"
+    if meta_file.is_file():
+        with open(meta_file) as f:
+            for line in f:
+                key, sep, value = line.strip().partition("=")
+                if sep:
+                    meta[key] = value
+    return meta
+
+
+def read_key_values(path: Path) -> dict[str, float]:
+    """Parse key=value lines with numeric values, skipping anything else."""
+    values: dict[str, float] = {}
+    with open(path) as f:
+        for line in f:
+            key, sep, value = line.strip().partition("=")
+            if sep:
+                try:
+                    values[key] = float(value)
+                except ValueError:
+                    pass
+    return values
+
+
+def read_run_record(run_dir: Path) -> dict | None:
     """
-    Walk experiment_dir/<routine>/<input_size>/<competitor>/<device>-run<N>/runtimes
-    and return {(routine, input_size, competitor, device): [runtimes]}.
+    The run's run.json as written by the harness, or for runs without one (older
+    runs, other harnesses) a record of the same shape from its runtimes,
+    runtimes_meta, and metrics files. None if the run has no runtimes.
     """
-    data: dict[tuple[str, str, str, str], list[float]] = defaultdict(list)
+    record_file = run_dir / "run.json"
+    if record_file.is_file():
+        with open(record_file) as f:
+            return json.load(f)
+    runtimes_file = run_dir / "runtimes"
+    if not runtimes_file.is_file():
+        return None
+    runtimes = []
+    with open(runtimes_file) as f:
+        for line in f:
+            try:
+                value = float(line)
+            except ValueError:
+                continue
+            runtimes.append(int(value) if value.is_integer() else value)
+    metrics_file = run_dir / "metrics"
+    return {
+        "eval_ns": runtimes,
+        "meta": read_run_meta(run_dir),
+        "metrics": read_key_values(metrics_file) if metrics_file.is_file() else {},
+    }
+
 
+def collect_records(experiment_dir: Path) -> list[dict]:
+    """
+    Walk experiment_dir/<routine>/<input_size>/<competitor>/<device>-run<N> and
+    return the record of every run (see read_run_record), with its place in the
+    layout as routine, input_size, competitor, device, and run.
+    """
+    records = []
     for routine_dir in sorted(experiment_dir.iterdir()):
         if not routine_dir.is_dir():
             continue
@@ -42,27 +152,403 @@ def discover_data(
             for comp_dir in sorted(is_dir.iterdir()):
                 if not comp_dir.is_dir() or comp_dir.name == "data":
                     continue
-                for run_dir in sorted(comp_dir.iterdir()):
-                    if not run_dir.is_dir():
-                        continue
+                for run_dir in sorted(comp_dir.iterdir(), key=lambda d: natural_sort_key(d.name)):
                     m = re.match(r"^(.+)-run(\d+)$", run_dir.name)
-                    if not m:
+                    if not run_dir.is_dir() or not m:
                         continue
-                    device = m.group(1)
-                    runtimes_file = run_dir / "runtimes"
-                    if not runtimes_file.is_file():
+                    record = read_run_record(run_dir)
+                    if record is None:
                         continue
-                    key = (routine_dir.name, is_dir.name, comp_dir.name, device)
-                    with open(runtimes_file) as f:
-                        for line in f:
-                            line = line.strip()
-                            if line:
-                                try:
-                                    data[key].append(float(line))
-                                except ValueError:
-                                    pass
+                    record.update(routine=routine_dir.name, input_size=is_dir.name,
+                                  competitor=comp_dir.name, device=m.group(1), run=int(m.group(2)))
+                    records.append(record)
+    return records
+
+
+def write_records(records: list[dict], output: Path) -> None:
+    """
+    Write the records as JSON Lines to output, and their eval runtimes as CSV
+    (one row per eval, with the settings, build, and node of its run) next to it.
+    """
+    output.parent.mkdir(parents=True, exist_ok=True)
+    with open(output, "w") as f:
+        for record in records:
+            f.write(json.dumps(record, sort_keys=False) + "\n")
+    csv_file = output.with_suffix(".csv")
+    columns = ["routine", "input_size", "competitor", "device", "run", "eval", "runtime_ns", "passed",
+               "cache", "numa", "threads", "kernel", "node", "cpu_model", "cpu_mhz", "slurm_job_id",
+               "compiler", "flags"]
+    with open(csv_file, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(columns)
+        for record in records:
+            meta = record.get("meta", {})
+            build = record.get("build", {})
+            env = record.get("environment", {})
+            passed = record.get("passed")
+            fixed = [record["routine"], record["input_size"], record["competitor"], record["device"],
+                     record["run"]]
+            settings = ["" if passed is None else int(passed), meta.get("cache", ""), meta.get("numa", ""),
+                        meta.get("threads", ""), meta.get("kernel", ""), env.get("node", ""),
+                        env.get("cpu_model", ""), env.get("cpu_mhz", ""), env.get("slurm_job_id") or "",
+                        build.get("compiler", ""), build.get("flags", "")]
+            for i, runtime in enumerate(record.get("eval_ns", [])):
+                writer.writerow(fixed + [i, runtime] + settings)
+    print(f"Saved {len(records)} run record(s) to {output} and {csv_file}")
+
+
+def load_records(source: Path) -> list[dict]:
+    """
+    Run records from an aggregated results file (JSON Lines, as written by
+    --mode aggregate), from the results.jsonl in directory source, or else by
+    walking the experiment directory source.
+    """
+    if source.is_dir() and (source / RESULTS_FILE).is_file():
+        source = source / RESULTS_FILE
+    if source.is_dir():
+        return collect_records(source)
+    with open(source) as f:
+        return [json.loads(line) for line in f if line.strip()]
+
+
+def run_conditions(meta: dict[str, str]) -> list[str]:
+    """
+    Measurement conditions that set a run apart, from its runtimes_meta: the
+    cache mode unless hot and the NUMA placement policy unless off (runs without
+    runtimes_meta have neither).
+    """
+    conditions = []
+    if meta.get("cache", "hot") != "hot":
+        conditions.append(meta["cache"])
+    numa = meta.get("numa", "off")
+    if numa != "off":
+        conditions.append(f"numa={numa}" + (f"/{meta['numa_B']}" if "numa_B" in meta else ""))
+    return conditions
+
+
+def base_device(device: str) -> str:
+    """Strip the conditions suffix that record_key adds to the device."""
+    return re.sub(r" \([^()]*\)$", "", device)
+
+
+def record_key(record: dict) -> tuple[str, str, str, str]:
+    """
+    (routine, input_size, competitor, device) of a run record. The device gets a
+    " (<conditions>)" suffix (see run_conditions) for runs not measured with hot
+    caches and first-touch placement.
+    """
+    device = record["device"]
+    conditions = run_conditions(record.get("meta", {}))
+    if conditions:
+        device = f"{device} ({', '.join(conditions)})"
+    return record["routine"], record["input_size"], record["competitor"], device
+
+
+def discover_data(
+    records: list[dict],
+) -> dict[tuple[str, str, str, str], list[float]]:
+    """Return {(routine, input_size, competitor, device): [runtimes]} of the records."""
+    data: dict[tuple[str, str, str, str], list[float]] = defaultdict(list)
+    for record in records:
+        data[record_key(record)].extend(float(t) for t in record.get("eval_ns", []))
+    return {key: runtimes for key, runtimes in data.items() if runtimes}
+
+
+def discover_run_medians(
+    records: list[dict],
+) -> dict[tuple[str, str, str, str], list[float]]:
+    """
+    Return {(routine, input_size, competitor, device): [median runtime of each run]},
+    the independent samples of the significance tests and confidence intervals.
+    """
+    medians: dict[tuple[str, str, str, str], list[float]] = defaultdict(list)
+    for record in records:
+        if record.get("eval_ns"):
+            medians[record_key(record)].append(float(np.median([float(t) for t in record["eval_ns"]])))
+    return dict(medians)
+
+
+def discover_metrics(
+    records: list[dict],
+) -> dict[tuple[str, str, str, str], dict[str, float]]:
+    """
+    Return {(routine, input_size, competitor, device): metrics} from the first
+    record with metrics for each key (metrics only depend on the problem shape).
+    """
+    metrics: dict[tuple[str, str, str, str], dict[str, float]] = {}
+    for record in records:
+        key = record_key(record)
+        if key not in metrics and record.get("metrics"):
+            metrics[key] = record["metrics"]
+    return metrics
+
+
+def discover_peaks(peaks_dir: Path | None) -> dict[str, dict[str, float]]:
+    """Return {device: peak values} from <peaks_dir>/<device>/peak."""
+    peaks: dict[str, dict[str, float]] = {}
+    if peaks_dir is None or not peaks_dir.is_dir():
+        return peaks
+    for device_dir in sorted(peaks_dir.iterdir()):
+        peak_file = device_dir / "peak"
+        if peak_file.is_file():
+            peaks[device_dir.name] = read_key_values(peak_file)
+    return peaks
+
+
+def discover_threads(
+    records: list[dict],
+) -> dict[tuple[str, str, str, str], dict[int, list[float]]]:
+    """
+    Return {(routine, input_size, competitor, device): {threads: [runtimes]}} with
+    the thread count of each run (threads= in its runtimes_meta; runs without are
+    left out) and the -t<N> suffix dropped from the device (see strip_threads).
+    """
+    threads: dict[tuple[str, str, str, str], dict[int, list[float]]] = defaultdict(
+        lambda: defaultdict(list)
+    )
+    for record in records:
+        value = str(record.get("meta", {}).get("threads", ""))
+        if not value.isdigit() or not record.get("eval_ns"):
+            continue
+        routine, input_size, competitor, device = record_key(record)
+        key = (routine, input_size, competitor, strip_threads(device))
+        threads[key][int(value)].extend(float(t) for t in record["eval_ns"])
+    return threads
+
+
+def sweep_size(input_size: str) -> tuple[str, int] | None:
+    """(family, n) of a sweep input size <family>_<n>, None for other names."""
+    m = re.match(r"^(.+)_(\d+)$", input_size)
+    return (m.group(1), int(m.group(2))) if m else None
+
+
+def strip_threads(device: str) -> str:
+    """Drop the -t<N> thread count suffix of the device prefix (before any conditions)."""
+    return re.sub(r"-t\d+(?= \(|$)", "", device)
+
+
+def cache_crossings(
+    footprints: list[tuple[int, float]], caches: dict[str, float]
+) -> list[tuple[str, float]]:
+    """
+    (label, n) where the operand footprint, sorted by n, first exceeds each cache
+    size, interpolated linearly in log-log between the neighboring sizes.
+    """
+    crossings = []
+    for level in ("l1", "l2", "l3"):
+        size = caches.get(f"cache_{level}_bytes")
+        if not size:
+            continue
+        for (n0, f0), (n1, f1) in zip(footprints, footprints[1:]):
+            if f0 <= size < f1:
+                t = (np.log(size) - np.log(f0)) / (np.log(f1) - np.log(f0))
+                crossings.append((level.upper(), float(np.exp(np.log(n0) + t * (np.log(n1) - np.log(n0))))))
+                break
+    return crossings
+
+
+def plot_lines(
+    panels: list[tuple[str, dict[str, list[tuple[float, float]]], list[tuple[str, float]]]],
+    competitors: list[str],
+    xlabel: str,
+    xscale_base: int,
+    output: Path,
+) -> None:
+    """
+    One subplot per (title, {competitor: [(x, GFLOP/s)]}, [(label, x)] vertical
+    markers), with a line per competitor over a log x axis.
+    """
+    n = len(panels)
+    ncols = min(n, 3)
+    nrows = -(-n // ncols)
+    fig, axes = plt.subplots(
+        nrows, ncols, figsize=(6 * ncols, 4 * nrows), squeeze=False
+    )
+    cmap = plt.get_cmap("Set2")
+    colors = {
+        comp: cmap(i / max(len(competitors) - 1, 1))
+        for i, comp in enumerate(competitors)
+    }
+
+    for idx, (title, lines, markers) in enumerate(panels):
+        ax = axes[idx // ncols][idx % ncols]
+        for comp in competitors:
+            points = sorted(lines.get(comp, []))
+            if points:
+                ax.plot([p[0] for p in points], [p[1] for p in points],
+                        color=colors[comp], marker="o", markersize=3, label=comp)
+        for label, x in markers:
+            ax.axvline(x=x, color="gray", linestyle=":", linewidth=1, zorder=0)
+            ax.annotate(label, xy=(x, 1), xycoords=("data", "axes fraction"),
+                        xytext=(2, -10), textcoords="offset points",
+                        color="gray", fontsize="small")
+        ax.set_xscale("log", base=xscale_base)
+        ax.set_ylim(bottom=0)
+        ax.set_xlabel(xlabel)
+        ax.set_ylabel("GFLOP/s")
+        ax.set_title(title)
+
+    for idx in range(n, nrows * ncols):
+        axes[idx // ncols][idx % ncols].set_visible(False)
+
+    from matplotlib.lines import Line2D
+
+    legend_handles = [
+        Line2D([], [], color=colors[c], marker="o", label=c) for c in competitors
+    ]
+    fig.legend(handles=legend_handles, loc="upper right")
+
+    plt.tight_layout()
+    fig.savefig(output, format="pdf", bbox_inches="tight")
+    plt.close()
+    print(f"Saved {output}")
 
-    return dict(data)
+
+def plot_sizes(
+    data: dict[tuple[str, str, str, str], list[float]],
+    metrics: dict[tuple[str, str, str, str], dict[str, float]],
+    peaks: dict[str, dict[str, float]],
+    output: Path,
+) -> None:
+    """GFLOP/s over the swept size n per (device, routine, family)."""
+    keys = [k for k in data if sweep_size(k[1]) and "flops" in metrics.get(k, {})]
+    if not keys:
+        raise SystemExit("No sweep input sizes (<family>_<n>) with metrics found.")
+
+    competitors = sorted({k[2] for k in keys}, key=natural_sort_key)
+    groups = sorted(
+        {(k[3], k[0], sweep_size(k[1])[0]) for k in keys},
+        key=lambda g: [natural_sort_key(x) for x in g],
+    )
+    panels = []
+    for device, routine, family in groups:
+        lines: dict[str, list[tuple[float, float]]] = defaultdict(list)
+        footprints: dict[int, float] = {}
+        for k in keys:
+            size = sweep_size(k[1])
+            if (k[3], k[0], size[0]) != (device, routine, family):
+                continue
+            lines[k[2]].append((size[1], metrics[k]["flops"] / float(np.median(data[k]))))
+            if "min_bytes" in metrics[k]:
+                footprints[size[1]] = metrics[k]["min_bytes"]
+        peak = peaks.get(strip_threads(base_device(device)), {})
+        markers = cache_crossings(sorted(footprints.items()), peak)
+        panels.append((f"{routine} {family} ({device})", lines, markers))
+    plot_lines(panels, competitors, "n", 2, output)
+
+
+def plot_threads(
+    threads: dict[tuple[str, str, str, str], dict[int, list[float]]],
+    metrics: dict[tuple[str, str, str, str], dict[str, float]],
+    output: Path,
+) -> None:
+    """GFLOP/s over the thread count per (device, routine, input size)."""
+    # Metrics of the thread-count devices, under the device of their subplot.
+    flops_of = {
+        (k[0], k[1], k[2], strip_threads(k[3])): m["flops"] for k, m in metrics.items() if "flops" in m
+    }
+    keys = [k for k in threads if k in flops_of]
+    if not keys:
+        raise SystemExit("No runs with threads= in runtimes_meta and metrics found.")
+
+    competitors = sorted({k[2] for k in keys}, key=natural_sort_key)
+    # Runtimes and flops per (device, routine, input size) panel, competitor, and thread count.
+    series: dict[tuple[str, str, str], dict[str, dict[int, list[float]]]] = defaultdict(dict)
+    flops: dict[tuple[str, str, str], float] = {}
+    for k in keys:
+        panel = (k[3], k[0], k[1])
+        series[panel][k[2]] = threads[k]
+        flops[panel] = flops_of[k]
+    panels = []
+    for panel in sorted(series, key=lambda g: [natural_sort_key(x) for x in g]):
+        device, routine, input_size = panel
+        lines = {
+            comp: [(t, flops[panel] / float(np.median(rts))) for t, rts in by_threads.items()]
+            for comp, by_threads in series[panel].items()
+        }
+        panels.append((f"{routine} {input_size} ({device})", lines, []))
+    plot_lines(panels, competitors, "Threads", 2, output)
+
+
+class Comparison(NamedTuple):
+    """
+    Median ratio of two runtime samples with its bootstrap CI and Mann-Whitney p,
+    and the smallest p the test can give for samples of their sizes.
+    """
+
+    ratio: float
+    ci_low: float
+    ci_high: float
+    p_value: float
+    min_p_value: float
+
+
+def bootstrap_ratio_ci(
+    numerator: list[float],
+    denominator: list[float],
+    rng: np.random.Generator,
+    resamples: int,
+) -> tuple[float, float]:
+    """
+    95% percentile bootstrap interval of median(numerator) / median(denominator),
+    resampling both samples independently.
+    """
+    num = np.asarray(numerator, dtype=float)
+    den = np.asarray(denominator, dtype=float)
+    num_medians = np.median(num[rng.integers(0, len(num), (resamples, len(num)))], axis=1)
+    den_medians = np.median(den[rng.integers(0, len(den), (resamples, len(den)))], axis=1)
+    low, high = np.percentile(num_medians / den_medians, [2.5, 97.5])
+    return float(low), float(high)
+
+
+def mann_whitney_p(a: list[float], b: list[float]) -> float:
+    """
+    Two-sided p-value of the Mann-Whitney U test (normal approximation with tie
+    and continuity corrections); 1 if either sample is empty or all values tie.
+    """
+    n1, n2 = len(a), len(b)
+    if n1 == 0 or n2 == 0:
+        return 1.0
+    values = np.concatenate([np.asarray(a, dtype=float), np.asarray(b, dtype=float)])
+    _, inverse, counts = np.unique(values, return_inverse=True, return_counts=True)
+    ends = np.cumsum(counts)
+    ranks = ((ends - counts + 1 + ends) / 2)[inverse]
+    u = float(ranks[:n1].sum()) - n1 * (n1 + 1) / 2
+    n = n1 + n2
+    ties = float((counts.astype(float) ** 3 - counts).sum())
+    variance = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)))
+    if variance <= 0:
+        return 1.0
+    delta = abs(u - n1 * n2 / 2)
+    z = max(delta - 0.5, 0.0) / math.sqrt(variance)
+    return math.erfc(z / math.sqrt(2))
+
+
+def mann_whitney_min_p(n1: int, n2: int) -> float:
+    """
+    Smallest p-value mann_whitney_p can return for samples of n1 and n2 values,
+    reached when the samples do not overlap (e.g. about 0.012 for 5 and 5).
+    """
+    if n1 == 0 or n2 == 0:
+        return 1.0
+    z = max(n1 * n2 / 2 - 0.5, 0.0) / math.sqrt(n1 * n2 * (n1 + n2 + 1) / 12)
+    return math.erfc(z / math.sqrt(2))
+
+
+def compare_runtimes(
+    numerator: list[float],
+    denominator: list[float],
+    rng: np.random.Generator,
+    resamples: int,
+) -> Comparison:
+    """
+    Median ratio numerator / denominator with its CI and significance, from one
+    median runtime per run (see discover_run_medians).
+    """
+    ratio = float(np.median(numerator)) / float(np.median(denominator))
+    low, high = bootstrap_ratio_ci(numerator, denominator, rng, resamples)
+    return Comparison(ratio, low, high, mann_whitney_p(numerator, denominator),
+                      mann_whitney_min_p(len(numerator), len(denominator)))
 
 
 def compute_speedups(
@@ -91,23 +577,262 @@ def compute_speedups(
     return result
 
 
+def plot_roofline(
+    data: dict[tuple[str, str, str, str], list[float]],
+    metrics: dict[tuple[str, str, str, str], dict[str, float]],
+    peaks: dict[str, dict[str, float]],
+    output: Path,
+) -> None:
+    """
+    One log-log subplot per (device, routine): achieved GFLOP/s (from the median
+    runtime) over arithmetic intensity, one color per competitor and one marker
+    per input size, below the device's compute and bandwidth roofs.
+    """
+    keys = [k for k in data if k in metrics and "flops" in metrics[k]
+            and "arithmetic_intensity" in metrics[k]]
+    if not keys:
+        raise SystemExit("No metrics found (rerun the experiments to write them).")
+
+    routines = sorted({k[0] for k in keys}, key=natural_sort_key)
+    devices = sorted({k[3] for k in keys}, key=natural_sort_key)
+    competitors = sorted({k[2] for k in keys}, key=natural_sort_key)
+    input_sizes = sorted({k[1] for k in keys}, key=natural_sort_key)
+
+    panels = [(d, r) for d in devices for r in routines]
+    n = len(panels)
+    ncols = min(n, 3)
+    nrows = -(-n // ncols)
+    fig, axes = plt.subplots(
+        nrows, ncols, figsize=(6 * ncols, 4.5 * nrows), squeeze=False
+    )
+
+    cmap = plt.get_cmap("Set2")
+    colors = {
+        comp: cmap(i / max(len(competitors) - 1, 1))
+        for i, comp in enumerate(competitors)
+    }
+    marker_cycle = ["o", "s", "^", "D", "v", "P", "X", "*"]
+    markers = {
+        is_name: marker_cycle[i % len(marker_cycle)]
+        for i, is_name in enumerate(input_sizes)
+    }
+
+    for idx, (device, routine) in enumerate(panels):
+        ax = axes[idx // ncols][idx % ncols]
+        points = [k for k in keys if k[0] == routine and k[3] == device]
+        if not points:
+            ax.set_visible(False)
+            continue
+
+        intensities = [metrics[k]["arithmetic_intensity"] for k in points]
+        for k in points:
+            gflops = metrics[k]["flops"] / float(np.median(data[k]))
+            ax.scatter(
+                metrics[k]["arithmetic_intensity"], gflops,
+                color=colors[k[2]], marker=markers[k[1]],
+                edgecolors="black", linewidths=0.5, zorder=3,
+            )
+
+        x = np.logspace(
+            np.log10(min(intensities) / 8), np.log10(max(intensities) * 8), 200
+        )
+        peak = peaks.get(base_device(device), {})
+        for suffix, style, label in (("", "-", "all threads"), ("_1t", "--", "1 thread")):
+            flops_roof = peak.get("peak_gflops" + suffix)
+            bw_roof = peak.get("peak_bandwidth_gbs" + suffix)
+            if flops_roof and bw_roof:
+                ax.plot(x, np.minimum(flops_roof, bw_roof * x), color="gray",
+                        linestyle=style, linewidth=1, label=label, zorder=1)
+        if peak:
+            ax.legend(loc="lower right", fontsize="small")
+
+        ax.set_xscale("log")
+        ax.set_yscale("log")
+        ax.set_xlabel("Arithmetic intensity (flop/byte)")
+        ax.set_ylabel("GFLOP/s")
+        title = f"{routine} ({device})"
+        if not peak:
+            title += " -- no peak data"
+        ax.set_title(title)
+
+    for idx in range(n, nrows * ncols):
+        axes[idx // ncols][idx % ncols].set_visible(False)
+
+    from matplotlib.lines import Line2D
+
+    legend_handles = [
+        Line2D([], [], color=colors[c], marker="o", linestyle="", label=c)
+        for c in competitors
+    ] + [
+        Line2D([], [], color="black", marker=markers[i], linestyle="",
+               markerfacecolor="none", label=i)
+        for i in input_sizes
+    ]
+    fig.legend(handles=legend_handles, loc="upper right")
+
+    plt.tight_layout()
+    fig.savefig(output, format="pdf", bbox_inches="tight")
+    plt.close()
+    print(f"Saved {output}")
+
+
+DEFAULT_OUTPUT = Path("runtimes.pdf")
+
+
+def check_regressions(
+    current: dict[tuple[str, str, str, str], list[float]],
+    history: dict[tuple[str, str, str, str], list[float]],
+    args: argparse.Namespace,
+    rng: np.random.Generator,
+    output: Path,
+) -> list[tuple[str, str, str, str]]:
+    """
+    Compare every (routine, input size, competitor, device) present in both
+    result sets, write the comparison to output as TSV, print the regressions,
+    and return their keys. The slowdown is median(current) / median(history) of
+    the run medians (see discover_run_medians).
+    """
+    keys = sorted(set(current) & set(history), key=lambda k: [natural_sort_key(x) for x in k])
+    if not keys:
+        raise SystemExit("No runs in common with the history.")
+    regressions = []
+    with open(output, "w") as f:
+        f.write("routine\tinput_size\tcompetitor\tdevice\tslowdown\tci_low\tci_high\tp_value\tstatus\n")
+        for key in keys:
+            c = compare_runtimes(current[key], history[key], rng, args.bootstrap)
+            significant = c.p_value < args.alpha
+            if c.min_p_value >= args.alpha:
+                status = "inconclusive"
+                print(f"WARNING: {'/'.join(key)}: {len(current[key])} and {len(history[key])} run(s) "
+                      f"cannot reach p < {args.alpha:g} (at best p = {c.min_p_value:.3g})")
+            elif significant and c.ratio > 1 + args.threshold:
+                status = "regression"
+                regressions.append(key)
+            elif significant and c.ratio < 1 / (1 + args.threshold):
+                status = "improvement"
+            else:
+                status = "unchanged"
+            f.write("\t".join(key) + f"\t{c.ratio:.4f}\t{c.ci_low:.4f}\t{c.ci_high:.4f}\t{c.p_value:.3g}\t{status}\n")
+            if status == "regression":
+                print(f"REGRESSION: {'/'.join(key)}: {c.ratio:.3f}x slower "
+                      f"(95% CI {c.ci_low:.3f}-{c.ci_high:.3f}, p = {c.p_value:.3g})")
+    only = len(set(current) ^ set(history))
+    print(f"Compared {len(keys)} run group(s) with {args.history} ({only} in only one of them): "
+          f"{len(regressions)} regression(s) beyond {args.threshold:.0%}; wrote {output}")
+    return regressions
+
+
 def main() -> None:
     parser = argparse.ArgumentParser(
         description="Plot competitor speedup over baseline from experiment results."
     )
-    parser.add_argument("experiment_dir", type=Path, help="Root experiment folder")
+    parser.add_argument(
+        "results",
+        type=Path,
+        help="Aggregated results file (see --mode aggregate), or the root experiment folder",
+    )
     parser.add_argument(
         "-o",
         "--output",
         type=Path,
-        default=Path("runtimes.pdf"),
-        help="Output PDF path (default: runtimes.pdf)",
+        default=DEFAULT_OUTPUT,
+        help="Output PDF path (default: runtimes.pdf); the TSV report in regression mode, "
+        "the results file in aggregate mode (default: results.jsonl)",
+    )
+    parser.add_argument(
+        "--mode",
+        choices=["speedup", "roofline", "sizes", "threads", "regression", "aggregate"],
+        default="speedup",
+        help="Plot speedup over baseline (default), a roofline per device, or "
+        "GFLOP/s over the sweep sizes or thread counts; check for regressions; or "
+        "aggregate the run records into one results file",
+    )
+    parser.add_argument(
+        "--history",
+        type=Path,
+        default=None,
+        help="Earlier results file or directory to compare against (regression mode)",
+    )
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=0.05,
+        help="Relative slowdown beyond which a significant change is a regression "
+        "(regression mode, default 0.05)",
+    )
+    parser.add_argument(
+        "--alpha",
+        type=float,
+        default=0.01,
+        help="Significance level of the Mann-Whitney U test (default 0.01)",
+    )
+    parser.add_argument(
+        "--bootstrap",
+        type=int,
+        default=2000,
+        help="Bootstrap resamples of the confidence intervals (default 2000)",
+    )
+    parser.add_argument(
+        "--save-history",
+        type=Path,
+        default=None,
+        help="Also save the run records to <dir>/results.jsonl, for later "
+        "regression checks",
+    )
+    parser.add_argument(
+        "--peaks",
+        type=Path,
+        default=None,
+        help="Folder with <device>/peak calibration results (roofline and sizes modes)",
     )
     args = parser.parse_args()
 
-    data = discover_data(args.experiment_dir.resolve())
+    records = load_records(args.results.resolve())
+    data = discover_data(records)
+    run_medians = discover_run_medians(records)
     if not data:
         raise SystemExit("No runtime data found.")
+    if args.mode == "aggregate":
+        write_records(records, args.output if args.output != DEFAULT_OUTPUT else Path(RESULTS_FILE))
+        return
+    if args.save_history:
+        write_records(records, args.save_history / RESULTS_FILE)
+    rng = np.random.default_rng(0)
+
+    if args.mode == "regression":
+        if args.history is None:
+            raise SystemExit("Regression mode needs --history.")
+        output = args.output if args.output != DEFAULT_OUTPUT else Path("regression.tsv")
+        regressions = check_regressions(
+            run_medians, discover_run_medians(load_records(args.history.resolve())), args, rng, output
+        )
+        sys.exit(1 if regressions else 0)
+
+    if args.mode == "roofline":
+        peaks_dir = args.peaks.resolve() if args.peaks else None
+        plot_roofline(
+            data,
+            discover_metrics(records),
+            discover_peaks(peaks_dir),
+            args.output,
+        )
+        return
+    if args.mode == "sizes":
+        peaks_dir = args.peaks.resolve() if args.peaks else None
+        plot_sizes(
+            data,
+            discover_metrics(records),
+            discover_peaks(peaks_dir),
+            args.output,
+        )
+        return
+    if args.mode == "threads":
+        plot_threads(
+            discover_threads(records),
+            discover_metrics(records),
+            args.output,
+        )
+        return
 
     routines = sorted({k[0] for k in data}, key=natural_sort_key)
     devices = sorted({k[3] for k in data}, key=natural_sort_key)
@@ -131,6 +856,7 @@ def main() -> None:
         for i, comp in enumerate(nb_competitors)
     }
 
+    stats: list[tuple[str, str, str, str, Comparison]] = []
     for idx, (device, routine) in enumerate(panels):
         ax = axes[idx // ncols][idx % ncols]
         input_sizes = sorted(
@@ -143,6 +869,7 @@ def main() -> None:
         all_box_data: list[list[float]] = []
         all_positions: list[float] = []
         all_colors: list = []
+        all_cis: list[tuple[float, Comparison]] = []
         tick_positions: list[float] = []
         tick_labels: list[str] = []
 
@@ -154,6 +881,13 @@ def main() -> None:
                     all_positions.append(group_start + j)
                     all_box_data.append(speedups[comp])
                     all_colors.append(colors[comp])
+                    c = compare_runtimes(
+                        run_medians[(routine, is_name, "baseline", device)],
+                        run_medians[(routine, is_name, comp, device)],
+                        rng, args.bootstrap,
+                    )
+                    stats.append((routine, is_name, comp, device, c))
+                    all_cis.append((group_start + j, c))
             tick_positions.append(group_start + (group_width - 1) / 2)
             tick_labels.append(is_name)
 
@@ -170,6 +904,13 @@ def main() -> None:
         )
         for patch, c in zip(bp["boxes"], all_colors):
             patch.set_facecolor(c)
+        # Bootstrap CI of the median-ratio speedup, and "*" where the difference is significant.
+        for position, c in all_cis:
+            ax.errorbar(position, c.ratio, yerr=[[c.ratio - c.ci_low], [c.ci_high - c.ratio]],
+                        fmt="none", ecolor="black", elinewidth=1.5, capsize=4, zorder=4)
+            if c.p_value < args.alpha:
+                ax.annotate("*", xy=(position, c.ci_high), xytext=(0, 2),
+                            textcoords="offset points", ha="center", va="bottom")
 
         ax.axhline(y=1.0, color="gray", linestyle="--", linewidth=0.8, zorder=0)
         ax.set_xticks(tick_positions)
@@ -190,6 +931,18 @@ def main() -> None:
     plt.close()
     print(f"Saved {args.output}")
 
+    stats_file = args.output.with_suffix(".tsv")
+    with open(stats_file, "w") as f:
+        f.write("routine\tinput_size\tcompetitor\tdevice\tspeedup\tci_low\tci_high\tp_value\tsignificant\n")
+        for routine, is_name, comp, device, c in stats:
+            f.write(f"{routine}\t{is_name}\t{comp}\t{device}\t{c.ratio:.4f}\t{c.ci_low:.4f}\t"
+                    f"{c.ci_high:.4f}\t{c.p_value:.3g}\t{int(c.p_value < args.alpha)}\n")
+    print(f"Saved {stats_file}")
+    untestable = sum(1 for *_, c in stats if c.min_p_value >= args.alpha)
+    if untestable:
+        print(f"WARNING: {untestable} comparison(s) have too few runs to reach p < {args.alpha:g}; "
+              "see the p_value column of the TSV")
+
 
 if __name__ == "__main__":
     main()
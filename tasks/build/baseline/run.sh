@@ -1,2 +1,2 @@
 #!/usr/bin/env bash
-g++ "$ASSETS/experiments/baseline/matmul.cpp" -I"$ASSETS/data" -O3 -o matmul
+g++ "$ASSETS/experiments/baseline/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -o matmul
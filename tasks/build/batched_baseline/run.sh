@@ -0,0 +1,2 @@
+#!/usr/bin/env bash
+g++ "$ASSETS/experiments/batched_baseline/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -o matmul
@@ -0,0 +1,2 @@
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
@@ -0,0 +1,3 @@
+#!/usr/bin/env bash
+# As batched_parallel, with B packed into panels once per run and shared by all threads.
+g++ "$ASSETS/experiments/batched/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -march=native -fopenmp -DBATCHED_PACK_B=1 -o matmul
@@ -0,0 +1,3 @@
+#!/usr/bin/env bash
+# Threads take whole problems of the batch; -march=native vectorizes the i-k-j inner loop.
+g++ "$ASSETS/experiments/batched/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -march=native -fopenmp -o matmul
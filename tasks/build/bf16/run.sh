@@ -0,0 +1,3 @@
+#!/usr/bin/env bash
+# bf16 A and B, fp32 accumulation; -march=native selects AMX or AVX-512-BF16 if the node has them.
+g++ "$ASSETS/experiments/mixed/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -march=native -DMATMUL_INPUT=bfloat16 -o matmul
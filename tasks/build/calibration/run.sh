@@ -0,0 +1,2 @@
+#!/usr/bin/env bash
+g++ "$ASSETS/calibration/peak.cpp" -O3 -march=native -fopenmp -o peak
@@ -0,0 +1,2 @@
+#!/usr/bin/env bash
+apptainer build cuda.sif "$CONTAINERS/cuda.def"
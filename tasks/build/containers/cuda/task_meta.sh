@@ -0,0 +1 @@
+export TASK_DISABLED=true
@@ -0,0 +1,2 @@
+#!/usr/bin/env bash
+apptainer build mpi.sif "$CONTAINERS/mpi.def"
@@ -0,0 +1,3 @@
+export DEPENDENCIES+=(
+    tasks/build/containers/cuda:$BUILD_FOLDER
+)
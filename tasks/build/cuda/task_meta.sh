@@ -0,0 +1,3 @@
+export TASK_DISABLED=true
+export CONTAINER=$TASKS/build/containers/cuda/$BUILD_FOLDER/cuda.sif
+export CONTAINER_DEF=$CONTAINERS/cuda.def
@@ -0,0 +1,10 @@
+#!/usr/bin/env bash
+# One fat binary for all palmaII GPU partitions: V100 (sm_70), RTX 2080 (sm_75),
+# A100 (sm_80), RTX 4090 (sm_89), H200 (sm_90).
+nvcc "$ASSETS/experiments/cuda/matmul.cu" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -DMATMUL_INPUT=bfloat16 \
+    -gencode arch=compute_70,code=sm_70 \
+    -gencode arch=compute_75,code=sm_75 \
+    -gencode arch=compute_80,code=sm_80 \
+    -gencode arch=compute_89,code=sm_89 \
+    -gencode arch=compute_90,code=sm_90 \
+    -o matmul
@@ -1,2 +1,5 @@
 #!/usr/bin/env bash
-g++ "$ASSETS/data/matmul.cpp" -I"$ASSETS/data" -O3 -o matmul
+# -ffp-contract=off keeps the gold result bit-identical across ISAs (no FMA contraction).
+g++ "$ASSETS/data/matmul.cpp" -I"$ASSETS/data" -O3 -march=native -ffp-contract=off -fopenmp -o matmul
+g++ "$ASSETS/data/batched_matmul.cpp" -I"$ASSETS/data" -O3 -march=native -ffp-contract=off -fopenmp -o batched_matmul
+g++ "$ASSETS/data/spmm.cpp" -I"$ASSETS/data" -O3 -march=native -ffp-contract=off -fopenmp -o spmm
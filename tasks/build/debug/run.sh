@@ -1,2 +1,2 @@
 #!/usr/bin/env bash
-g++ "$ASSETS/experiments/baseline/matmul.cpp" -I"$ASSETS/data" -O0 -g -o matmul
+g++ "$ASSETS/experiments/baseline/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O0 -g -o matmul
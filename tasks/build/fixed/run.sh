@@ -0,0 +1,8 @@
+#!/usr/bin/env bash
+# Turn "IxJxK ..." into FIXED_SHAPE(I,J,K) entries for the compile-time dispatcher.
+shapes=""
+for shape in $FIXED_SHAPES; do
+    IFS=x read -r i j k <<< "$shape"
+    shapes+="FIXED_SHAPE($i,$j,$k) "
+done
+g++ "$ASSETS/experiments/optimized/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -DMATMUL_FIXED_SHAPES="$shapes" -o matmul
@@ -0,0 +1,4 @@
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
+# Problem shapes (IxJxK) to specialize the optimized kernel for; other shapes use the generic kernel.
+export FIXED_SHAPES="10x500x64 512x512x512"
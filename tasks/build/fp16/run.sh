@@ -0,0 +1,3 @@
+#!/usr/bin/env bash
+# fp16 A and B, widened to fp32 for the FMAs (F16C); -march=native selects the AVX-512 kernel.
+g++ "$ASSETS/experiments/mixed/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -march=native -DMATMUL_INPUT=float16 -o matmul
@@ -0,0 +1,5 @@
+#!/usr/bin/env bash
+# The gemm kernel with the epilogue left to the harness's separate pass, to measure what
+# fusing it into the micro-kernel's write-back saves.
+g++ "$ASSETS/experiments/gemm/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -march=native \
+    -DGEMM_FUSE_EPILOGUE=0 -o matmul
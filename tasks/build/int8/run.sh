@@ -0,0 +1,3 @@
+#!/usr/bin/env bash
+# Quantized int8 A and B, int32 accumulation; -march=native selects AMX or AVX-512-VNNI if the node has them.
+g++ "$ASSETS/experiments/mixed/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -march=native -DMATMUL_INPUT=int8_t -o matmul
@@ -1,2 +1,5 @@
 #!/usr/bin/env bash
-g++ "$ASSETS/experiments/optimized/matmul.cpp" -I"$ASSETS/data" -O3 -o matmul
+# Use the tile sizes tuned for this BUILD_FOLDER (tasks/tune/MatMul), if present.
+flags=()
+tuned_tile_flags
+g++ "$ASSETS/experiments/optimized/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 "${flags[@]}" -o matmul
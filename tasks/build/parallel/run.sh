@@ -0,0 +1,2 @@
+#!/usr/bin/env bash
+g++ "$ASSETS/experiments/parallel/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -pthread -o matmul
@@ -0,0 +1,28 @@
+# The C++ compilers of the build tasks pass their command line into the binary as
+# MATMUL_BUILD_FLAGS, which the harness records in the run.json of every run
+# (assets/harness/run_record.h).
+compile_recording_flags() {
+    local flags="$*"
+    flags=${flags//\\/\\\\}
+    flags=${flags//\"/\\\"}
+    command "$@" -DMATMUL_BUILD_FLAGS="\"$flags\""
+}
+g++() { compile_recording_flags g++ "$@"; }
+mpicxx() { compile_recording_flags mpicxx "$@"; }
+
+# Append the -D flags of the tile sizes tuned for this BUILD_FOLDER (tasks/tune/MatMul), if
+# present, to the array flags. The optimized build and its traced build share them.
+tuned_tile_flags() {
+    local tuned="$TASKS/tune/MatMul/$BUILD_FOLDER/tiles.sh"
+    [[ -f "$tuned" ]] || return 0
+    source "$tuned"
+    [[ -n "${TILE_I:-}" ]] && flags+=(-DTILE_I="$TILE_I" -DTILE_J="$TILE_J" -DTILE_K="$TILE_K")
+    local entry i j k ti tj tk entries=""
+    for entry in ${TUNED_TILES:-}; do
+        IFS=x read -r i j k <<< "${entry%%:*}"
+        IFS=x read -r ti tj tk <<< "${entry#*:}"
+        entries+="TUNED_TILES($i,$j,$k,$ti,$tj,$tk) "
+    done
+    [[ -n "$entries" ]] && flags+=(-DMATMUL_TUNED_TILES="$entries")
+    echo "Using tuned tiles from $tuned"
+}
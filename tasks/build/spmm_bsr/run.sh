@@ -0,0 +1,3 @@
+#!/usr/bin/env bash
+# -march=native selects the AVX-512 or AVX2 block kernels for the node the build runs on.
+g++ "$ASSETS/experiments/spmm_bsr/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -march=native -fopenmp -o matmul
@@ -0,0 +1,3 @@
+#!/usr/bin/env bash
+# Threads take row ranges of equal nonzero counts; -march=native vectorizes the row updates.
+g++ "$ASSETS/experiments/spmm_csr/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -march=native -fopenmp -o matmul
@@ -0,0 +1,3 @@
+#!/usr/bin/env bash
+# MATMUL_STRASSEN_CUTOFF picks the cutoff at run time; -DSTRASSEN_CUTOFF=<n> changes the default.
+g++ "$ASSETS/experiments/strassen/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -march=native -o matmul
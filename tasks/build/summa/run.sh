@@ -0,0 +1,2 @@
+#!/usr/bin/env bash
+mpicxx "$ASSETS/experiments/summa/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -march=native -fopenmp -o matmul
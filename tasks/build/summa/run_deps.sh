@@ -0,0 +1,3 @@
+export DEPENDENCIES+=(
+    tasks/build/containers/mpi:$BUILD_FOLDER
+)
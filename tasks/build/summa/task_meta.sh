@@ -0,0 +1,2 @@
+export CONTAINER=$TASKS/build/containers/mpi/$BUILD_FOLDER/mpi.sif
+export CONTAINER_DEF=$CONTAINERS/mpi.def
@@ -0,0 +1,13 @@
+#!/usr/bin/env bash
+# Traced builds (-DMATMUL_TRACE=1) of the kernels that mark their phases with TRACE_SCOPE,
+# one folder per competitor, each with the flags of the competitor's own build task
+# (optimized/ with the tuned tiles, see tuned_tile_flags in tasks/build/run_env.sh).
+flags=()
+tuned_tile_flags
+mkdir -p optimized parallel gemm
+g++ "$ASSETS/experiments/optimized/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 "${flags[@]}" -DMATMUL_TRACE=1 \
+    -o optimized/matmul &&
+g++ "$ASSETS/experiments/parallel/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -pthread -DMATMUL_TRACE=1 \
+    -o parallel/matmul &&
+g++ "$ASSETS/experiments/gemm/matmul.cpp" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -march=native -DMATMUL_TRACE=1 \
+    -o gemm/matmul
@@ -0,0 +1,3 @@
+export TASK_DISABLED=true
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
@@ -0,0 +1,4 @@
+#!/usr/bin/env bash
+# Measure the peaks with every core allocated to the job (SLURM cpus-per-task, else the affinity mask).
+export OMP_NUM_THREADS="${OMP_NUM_THREADS:-${SLURM_CPUS_PER_TASK:-$(nproc)}}"
+"$TASKS/build/calibration/$BUILD_FOLDER/peak"
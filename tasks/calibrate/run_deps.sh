@@ -0,0 +1,4 @@
+export DEPENDENCIES+=(
+    tasks/build/containers/gcc:$BUILD_FOLDER
+    tasks/build/calibration:$BUILD_FOLDER
+)
@@ -0,0 +1,4 @@
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
+# One run per device, named like the device prefix of the experiment runs.
+export RUN_SPEC=$BUILD_FOLDER
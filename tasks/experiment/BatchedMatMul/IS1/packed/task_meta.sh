@@ -0,0 +1,3 @@
+export COMPETITOR=batched_packed
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
@@ -0,0 +1,6 @@
+export INPUT_SIZE=IS1
+# Many small problems against one shared B, as in batched inference.
+export BATCH=2048
+export I=10
+export J=500
+export K=64
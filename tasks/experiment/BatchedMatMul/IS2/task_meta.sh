@@ -0,0 +1,7 @@
+export INPUT_SIZE=IS2
+# Small square problems, each with its own B.
+export BATCH=4096
+export I=64
+export J=64
+export K=64
+export BATCH_B=batched
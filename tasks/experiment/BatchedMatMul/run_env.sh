@@ -0,0 +1,19 @@
+create_data() {
+    if [[ -z "${BATCH:-}" || -z "${I:-}" || -z "${J:-}" || -z "${K:-}" ]]; then
+        echo "Error: BATCH, I, J, K must be set." >&2
+        return 1
+    fi
+    export OMP_NUM_THREADS="${OMP_NUM_THREADS:-${SLURM_CPUS_PER_TASK:-$(nproc)}}"
+    "$TASKS/build/data/$BUILD_FOLDER/batched_matmul" "$BATCH" "$I" "$J" "$K" "${DATA_FORMAT:-txt}" \
+        "${DATA_SEED:-random}" "${BATCH_B:-shared}"
+}
+
+run_experiment() {
+    local data_dir="$TASKS/experiment/$ROUTINE/$INPUT_SIZE/data/$BUILD_FOLDER"
+    local ext="${DATA_FORMAT:-txt}"
+    "$TASKS/build/$COMPETITOR/$BUILD_FOLDER/matmul" \
+        "$data_dir/input_A.$ext" \
+        "$data_dir/input_B.$ext" \
+        "$data_dir/input_C.$ext" \
+        "$data_dir/output_C.$ext"
+}
@@ -0,0 +1,12 @@
+export ROUTINE=BatchedMatMul
+export DATA_FORMAT=bin
+# Seed of the generated inputs; problem 0 of a batch is the MatMul data of the same seed.
+export DATA_SEED=1
+# B of the batch: shared (one matrix for every problem, e.g. layer weights) or batched
+# (one per problem); input sizes may override it.
+export BATCH_B=shared
+# Operand layout the kernels see: strided (problems back to back) or pointer (one
+# allocation per problem, reached through pointer arrays).
+export MATMUL_BATCH_LAYOUT=strided
+# hot or cold; rotating is not supported for batches.
+export MATMUL_CACHE=hot
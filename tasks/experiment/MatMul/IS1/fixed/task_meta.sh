@@ -0,0 +1,3 @@
+export COMPETITOR=fixed
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
\ No newline at end of file
@@ -0,0 +1,4 @@
+export COMPETITOR=fp16
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
+export MATMUL_MIXED_KERNEL=auto
@@ -0,0 +1,3 @@
+#!/usr/bin/env bash
+# B packed for the micro-kernel the build selected (the binary prints its layout).
+B_LAYOUT=$("$TASKS/build/$COMPETITOR/$BUILD_FOLDER/matmul" --B-layout) run_experiment
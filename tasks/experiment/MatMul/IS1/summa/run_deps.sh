@@ -0,0 +1,5 @@
+export DEPENDENCIES+=(
+    tasks/build/containers/mpi:$BUILD_FOLDER
+    tasks/build/$COMPETITOR:$BUILD_FOLDER
+    tasks/experiment/$ROUTINE/$INPUT_SIZE/data:$BUILD_FOLDER
+)
@@ -0,0 +1,5 @@
+export COMPETITOR=summa
+# Ranks start in their own container (see mpi_launch), so the task itself runs outside one.
+export MPI_CONTAINER=$TASKS/build/containers/mpi/$BUILD_FOLDER/mpi.sif
+export MPI_RANKS=4
+export MATMUL_MPI_LAYERS=1
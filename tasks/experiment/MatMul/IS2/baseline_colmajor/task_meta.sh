@@ -0,0 +1,4 @@
+export COMPETITOR=baseline
+export B_LAYOUT=colmajor
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
@@ -0,0 +1,6 @@
+export TASK_DISABLED=true
+export COMPETITOR=cuda_fp16
+export CONTAINER=$TASKS/build/containers/cuda/$BUILD_FOLDER/cuda.sif
+export CONTAINER_DEF=$CONTAINERS/cuda.def
+export CONTAINER_GPU=ON
+export MATMUL_CUDA_KERNEL=auto
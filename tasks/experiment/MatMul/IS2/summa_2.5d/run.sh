@@ -0,0 +1,2 @@
+#!/usr/bin/env bash
+run_experiment mpi_launch
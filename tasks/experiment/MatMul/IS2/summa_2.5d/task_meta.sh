@@ -0,0 +1,6 @@
+export COMPETITOR=summa
+# Ranks start in their own container (see mpi_launch), so the task itself runs outside one.
+export MPI_CONTAINER=$TASKS/build/containers/mpi/$BUILD_FOLDER/mpi.sif
+# A 2x2x2 grid; workload_managers/palmaII-skylake-mpi.sh sizes its jobs for these ranks.
+export MPI_RANKS=8
+export MATMUL_MPI_LAYERS=2
@@ -0,0 +1,3 @@
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
+export RUN_SPEC=$BUILD_FOLDER
\ No newline at end of file
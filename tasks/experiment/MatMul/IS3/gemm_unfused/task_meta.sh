@@ -0,0 +1,3 @@
+export COMPETITOR=gemm_unfused
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
@@ -0,0 +1,5 @@
+export COMPETITOR=parallel
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
+export MATMUL_SCHEDULE=static
+export MATMUL_PINNING=compact
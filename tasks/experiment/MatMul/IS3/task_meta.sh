@@ -0,0 +1,6 @@
+export INPUT_SIZE=IS3
+export I=512
+export J=512
+export K=512
+# IS2 with a bias-add and GELU epilogue on top of C = A B + C_init, as in a transformer MLP.
+export MATMUL_EPILOGUE=alpha=1,beta=1,bias,gelu
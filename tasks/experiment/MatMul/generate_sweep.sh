@@ -0,0 +1,98 @@
+#!/usr/bin/env bash
+# Expand an input-size sweep spec (default: sweep.spec next to this script) into input-size
+# tasks <family>_<n>/ of this routine: task_meta.sh with I, J, and K, the data task, and
+# the spec's competitors, all copied from the template input size. Input sizes an earlier
+# expansion generated are removed first, so the tree always matches the spec; with
+# --clean only that happens.
+#
+#     tasks/experiment/MatMul/generate_sweep.sh [--clean] [<spec>]
+set -euo pipefail
+
+routine_dir="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+marker="# Generated by generate_sweep.sh"
+clean_only=false
+[[ "${1:-}" == --clean ]] && { clean_only=true; shift; }
+spec="${1:-$routine_dir/sweep.spec}"
+
+for meta in "$routine_dir"/*/task_meta.sh; do
+    if [[ "$(head -1 "$meta")" == "$marker"* ]]; then
+        rm -rf "$(dirname "$meta")"
+    fi
+done
+$clean_only && exit 0
+
+competitors=()
+template=IS1
+sizes=()
+while read -r family rest; do
+    [[ -z "$family" || "$family" == \#* ]] && continue
+    case "$family" in
+        competitors) read -ra competitors <<< "$rest" ;;
+        template) template="$rest" ;;
+        square|skinny_m|skinny_n|deep_k)
+            read -r first last factor fixed <<< "$rest"
+            if [[ -z "$factor" || ( "$family" != square && -z "$fixed" ) ]]; then
+                echo "Error: $spec: expected '$family <first> <last> <factor> [<fixed>]' (fixed: all but square)" >&2
+                exit 1
+            fi
+            if ! steps=$(awk -v first="$first" -v last="$last" -v factor="$factor" 'BEGIN {
+                    if (first < 1 || factor <= 1) exit 1
+                    for (i = 0; int(first * factor ^ i + 0.5) <= last; ++i) {
+                        n = int(first * factor ^ i + 0.5)
+                        if (n != prev) print n
+                        prev = n
+                    }
+                }'); then
+                echo "Error: $spec: the sizes of $family need first >= 1 and factor > 1" >&2
+                exit 1
+            fi
+            for n in $steps; do
+                case "$family" in
+                    square) sizes+=("$family $n $n $n $n") ;;
+                    skinny_m) sizes+=("$family $n $fixed $n $n") ;;
+                    skinny_n) sizes+=("$family $n $n $fixed $n") ;;
+                    deep_k) sizes+=("$family $n $fixed $fixed $n") ;;
+                esac
+            done
+            ;;
+        *)
+            echo "Error: $spec: unknown family '$family' (expected square, skinny_m, skinny_n, or deep_k)" >&2
+            exit 1
+            ;;
+    esac
+done < "$spec"
+
+if [[ ! -d "$routine_dir/$template/data" ]]; then
+    echo "Error: template input size $template has no data task" >&2
+    exit 1
+fi
+for competitor in "${competitors[@]}"; do
+    if [[ ! -f "$routine_dir/$template/$competitor/run.sh" ]]; then
+        echo "Error: template input size $template has no competitor $competitor" >&2
+        exit 1
+    fi
+done
+
+for size in "${sizes[@]}"; do
+    read -r family n I J K <<< "$size"
+    name="${family}_$n"
+    if [[ -e "$routine_dir/$name" ]]; then
+        echo "Error: $name already exists and was not generated" >&2
+        exit 1
+    fi
+    mkdir "$routine_dir/$name"
+    # Only the size-specific settings: the rest of the template's task_meta.sh (e.g. an
+    # epilogue) would change what the sweep measures.
+    cat > "$routine_dir/$name/task_meta.sh" <<META
+$marker from ${spec##*/}; rerun it instead of editing.
+export INPUT_SIZE=$name
+export I=$I
+export J=$J
+export K=$K
+META
+    for task in data "${competitors[@]}"; do
+        mkdir "$routine_dir/$name/$task"
+        cp -p "$routine_dir/$template/$task"/*.sh "$routine_dir/$name/$task/"
+    done
+done
+echo "Generated ${#sizes[@]} input sizes with ${#competitors[@]} competitor(s) from $spec"
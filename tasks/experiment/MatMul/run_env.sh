@@ -3,13 +3,107 @@ create_data() {
         echo "Error: I, J, K must be set." >&2
         return 1
     fi
-    "$TASKS/build/data/$BUILD_FOLDER/matmul" "$I" "$J" "$K"
+    # Use every core allocated to the job (SLURM cpus-per-task, else the affinity mask).
+    export OMP_NUM_THREADS="${OMP_NUM_THREADS:-${SLURM_CPUS_PER_TASK:-$(nproc)}}"
+    # Skip the O(IJK) gold output above GOLD_MAX_IJK; experiments then verify their
+    # result with Freivalds probes instead.
+    local gold=gold
+    if (( ${GOLD_MAX_IJK:-0} > 0 && I * J * K > GOLD_MAX_IJK )); then
+        gold=nogold
+    fi
+    # Stream in row panels if the matrices exceed DATA_MEMORY_BUDGET_MB (default: the
+    # job's SLURM memory allocation, else unlimited); the budget does not change the data.
+    local params=("$I" "$J" "$K" "${DATA_FORMAT:-txt}" "${DATA_SEED:-random}" "$gold" \
+                  "${DATA_B_LAYOUTS:-none}" "${MATMUL_EPILOGUE:-none}")
+    cached_data "${params[@]}" -- \
+        "$TASKS/build/data/$BUILD_FOLDER/matmul" "$I" "$J" "$K" "${DATA_FORMAT:-txt}" \
+        "${DATA_MEMORY_BUDGET_MB:-${SLURM_MEM_PER_NODE:-0}}" "${DATA_SEED:-random}" "$gold" \
+        "${DATA_B_LAYOUTS:-none}" "${MATMUL_EPILOGUE:-none}"
 }
 
+# Run the generator command after "--" through the data cache in DATA_CACHE, keyed by the
+# generation parameters before "--" and the generator's sources. A hit hard-links the
+# cached files into the run folder (symlinks across file systems); a miss generates them
+# and adds them to the cache. DATA_CACHE=off, or DATA_SEED=random, always generates.
+# Cached files are read-only; delete an entry (or the cache) to regenerate it.
+cached_data() {
+    local key=()
+    while [[ "$1" != -- ]]; do key+=("$1"); shift; done
+    shift
+    local cache="${DATA_CACHE:-off}" file
+    # Start from no data files: files an earlier hit linked in are the cache's, and files an
+    # earlier miss added share the (read-only) inode of the entry even once it is deleted.
+    rm -f input_* output_*
+    if [[ "$cache" == off || "${DATA_SEED:-random}" == random ]]; then
+        "$@"
+        return
+    fi
+    local hash
+    hash=$({ printf '%s\n' "${key[@]}"; cat "$TASKS/build/data/run.sh" "$ASSETS"/data/*.h "$ASSETS"/data/*.cpp; } \
+        | sha256sum | cut -c1-32)
+    local entry="$cache/$hash"
+    if [[ -d "$entry" ]]; then
+        for file in "$entry"/*; do
+            [[ "${file##*/}" == params ]] && continue
+            ln -f "$file" . 2>/dev/null || ln -sf "$file" .
+        done
+        echo "Linked cached data from $entry"
+        return
+    fi
+    "$@" || return
+    # Fill a staging folder and rename it into place, so that entries are complete and
+    # concurrent data tasks with the same key keep the first one.
+    mkdir -p "$cache"
+    local staging
+    staging=$(mktemp -d "$cache/.staging.XXXXXX")
+    for file in input_* output_*; do
+        [[ -f "$file" ]] || continue
+        ln "$file" "$staging/" 2>/dev/null || cp "$file" "$staging/"
+        chmod a-w "$staging/$file"
+    done
+    printf '%s\n' "${key[@]}" > "$staging/params"
+    if mv -T "$staging" "$entry" 2>/dev/null; then
+        echo "Added the data to the cache as $entry"
+    else
+        rm -rf "$staging"
+    fi
+}
+
+# Run the competitor binary on the input size's data, with B in B_LAYOUT (one of
+# DATA_B_LAYOUTS); arguments are a launcher command to prefix it with (e.g. mpi_launch).
+# EXPERIMENT_BINARY runs another build of the competitor instead (e.g. a traced one, see
+# tasks/trace/MatMul).
 run_experiment() {
-    "$TASKS/build/$COMPETITOR/$BUILD_FOLDER/matmul" \
-        "$TASKS/experiment/$ROUTINE/$INPUT_SIZE/data/$BUILD_FOLDER/input_A.txt" \
-        "$TASKS/experiment/$ROUTINE/$INPUT_SIZE/data/$BUILD_FOLDER/input_B.txt" \
-        "$TASKS/experiment/$ROUTINE/$INPUT_SIZE/data/$BUILD_FOLDER/input_C.txt" \
-        "$TASKS/experiment/$ROUTINE/$INPUT_SIZE/data/$BUILD_FOLDER/output_C.txt"
+    local data_dir="$TASKS/experiment/$ROUTINE/$INPUT_SIZE/data/$BUILD_FOLDER"
+    local ext="${DATA_FORMAT:-txt}"
+    local B_file="input_B.$ext"
+    [[ "${B_LAYOUT:-rowmajor}" != rowmajor ]] && B_file="input_B.$B_LAYOUT.$ext"
+    # Without a gold output C (see GOLD_MAX_IJK), the binary verifies with Freivalds probes.
+    local gold_C=()
+    [[ -f "$data_dir/output_C.$ext" ]] && gold_C=("$data_dir/output_C.$ext")
+    # The bias of an epilogue with bias (MATMUL_EPILOGUE), which the data task wrote.
+    [[ -f "$data_dir/input_bias.$ext" ]] && export MATMUL_BIAS="$data_dir/input_bias.$ext"
+    "$@" "${EXPERIMENT_BINARY:-$TASKS/build/$COMPETITOR/$BUILD_FOLDER/matmul}" \
+        "$data_dir/input_A.$ext" \
+        "$data_dir/$B_file" \
+        "$data_dir/input_C.$ext" \
+        "${gold_C[@]}"
+}
+
+# Start "$@" on MPI_RANKS ranks, each in MPI_CONTAINER. Inside a SLURM allocation srun
+# starts the ranks on the allocated nodes (several with workload_managers/
+# palmaII-skylake-mpi.sh), one container per rank, and splits the job's CPUs evenly
+# over them as OpenMP threads; otherwise the container's mpirun starts them on this node.
+mpi_launch() {
+    local ranks="${MPI_RANKS:?Error: MPI_RANKS must be set.}"
+    if [[ -n "${SLURM_JOB_ID:-}" ]]; then
+        local cpus=$(( ${SLURM_CPUS_PER_TASK:-1} * ${SLURM_NTASKS:-1} / ranks ))
+        (( cpus < 1 )) && cpus=1
+        OMP_NUM_THREADS="$cpus" \
+            srun --ntasks="$ranks" --cpus-per-task="$cpus" --mpi="${MPI_SRUN_MPI:-pmix}" \
+            apptainer exec -B "$REPOSITORY_ROOT:$REPOSITORY_ROOT" "$MPI_CONTAINER" "$@"
+    else
+        apptainer exec -B "$REPOSITORY_ROOT:$REPOSITORY_ROOT" "$MPI_CONTAINER" \
+            mpirun --oversubscribe -n "$ranks" "$@"
+    fi
 }
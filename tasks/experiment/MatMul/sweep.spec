@@ -0,0 +1,12 @@
+# Input-size sweep of generate_sweep.sh. Competitors of every generated input size (taken
+# from the variants of the template input size):
+competitors baseline optimized gemm parallel
+template IS2
+# <family> <first> <last> <factor> [<fixed>]: one input size <family>_<n> for each n of
+# first, first * factor, ... up to last (rounded). square is n x n x n; skinny_m has
+# I = fixed, skinny_n J = fixed, both with the other dimensions n; deep_k is I = J = fixed
+# with K = n.
+square   64  4096  1.41421356
+skinny_m 64  8192  2      16
+skinny_n 64  8192  2      16
+deep_k   256 65536 2      64
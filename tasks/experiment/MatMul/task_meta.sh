@@ -1 +1,30 @@
 export ROUTINE=MatMul
+export DATA_FORMAT=bin
+# Seed of the generated inputs; the same seed gives bit-identical data on any node
+# (use DATA_SEED=random for fresh data).
+export DATA_SEED=1
+# Content-addressed store of generated data shared by all data tasks, build folders, and
+# sweeps: inputs with the same generation parameters are generated once and linked into
+# later data tasks (off: always generate).
+export DATA_CACHE=$REPOSITORY_ROOT/data_cache
+# Largest I*J*K the data task computes the gold output C for (4096^3); larger sizes are
+# verified with Freivalds probes (MATMUL_FREIVALDS_PROBES) in the experiment binary. The
+# probes miss single-element errors of up to ~8 sqrt(J) tolerances; accuracy runs use 0.
+export GOLD_MAX_IJK=68719476736
+# Cache state of the operands at the start of each eval run: hot, cold (last-level cache
+# evicted before every run), or rotating (runs cycle through copies of the operands).
+export MATMUL_CACHE=hot
+# NUMA placement of the operands on multi-socket nodes: off (first touch), interleave,
+# or partition (row blocks of A and C per node, B per MATMUL_NUMA_B: replicate or
+# interleave). Give other policies their own run folder prefix.
+export MATMUL_NUMA=off
+export MATMUL_NUMA_B=replicate
+# Further layouts of B the data task writes (input_B.<layout>.<ext>, comma-separated) for
+# competitors that read B pre-transposed or pre-packed; B_LAYOUT picks one per experiment.
+# The blocked layouts are pre-packed B for the gemm micro-kernels (AVX2: NR 16, AVX-512: NR 32).
+export DATA_B_LAYOUTS=colmajor,blocked_256x16,blocked_256x32
+export B_LAYOUT=rowmajor
+# Epilogue of the matmul, C = act(alpha A B + beta C_init + bias): none, or comma-separated
+# alpha=<x>, beta=<x>, bias, and relu or gelu (e.g. alpha=1,beta=1,bias,gelu). The data
+# task generates the matching initial C, bias, and gold output; set it per input size.
+export MATMUL_EPILOGUE=none
@@ -0,0 +1,5 @@
+# The dense path: the gemm competitor on the dense A.
+export COMPETITOR=gemm
+export A_FORMAT=dense
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
\ No newline at end of file
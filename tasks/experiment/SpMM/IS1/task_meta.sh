@@ -0,0 +1,6 @@
+export INPUT_SIZE=IS1
+# The shape is fixed across the input sizes, which sweep the density of A.
+export I=4096
+export J=256
+export K=4096
+export DENSITY=0.01
@@ -0,0 +1,5 @@
+export INPUT_SIZE=IS4
+export I=4096
+export J=256
+export K=4096
+export DENSITY=0.25
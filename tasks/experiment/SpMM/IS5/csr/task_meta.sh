@@ -0,0 +1,4 @@
+export COMPETITOR=spmm_csr
+export A_FORMAT=csr
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
\ No newline at end of file
@@ -0,0 +1,23 @@
+create_data() {
+    if [[ -z "${I:-}" || -z "${J:-}" || -z "${K:-}" || -z "${DENSITY:-}" ]]; then
+        echo "Error: I, J, K, DENSITY must be set." >&2
+        return 1
+    fi
+    export OMP_NUM_THREADS="${OMP_NUM_THREADS:-${SLURM_CPUS_PER_TASK:-$(nproc)}}"
+    "$TASKS/build/data/$BUILD_FOLDER/spmm" "$I" "$J" "$K" "$DENSITY" "${DATA_FORMAT:-txt}" \
+        "${DATA_SEED:-random}" "${SPMM_PATTERN:-block}" "${SPMM_BLOCK:-4x4}"
+}
+
+# Run the competitor binary on the input size's data, with A in A_FORMAT: dense
+# (input_A.<ext>, for the MatMul competitors), csr, or bsr (input_A.<format>.<ext>).
+run_experiment() {
+    local data_dir="$TASKS/experiment/$ROUTINE/$INPUT_SIZE/data/$BUILD_FOLDER"
+    local ext="${DATA_FORMAT:-txt}"
+    local A_file="input_A.$ext"
+    [[ "${A_FORMAT:-dense}" != dense ]] && A_file="input_A.$A_FORMAT.$ext"
+    "$TASKS/build/$COMPETITOR/$BUILD_FOLDER/matmul" \
+        "$data_dir/$A_file" \
+        "$data_dir/input_B.$ext" \
+        "$data_dir/input_C.$ext" \
+        "$data_dir/output_C.$ext"
+}
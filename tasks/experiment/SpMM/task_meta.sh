@@ -0,0 +1,12 @@
+export ROUTINE=SpMM
+export DATA_FORMAT=bin
+# Seed of the generated inputs; A holds the MatMul A of the same seed where the
+# sparsity pattern keeps it, so the input sizes differ only in the pattern's density.
+export DATA_SEED=1
+# Sparsity pattern: block (whole SPMM_BLOCK blocks kept or dropped, as in block-pruned
+# weights) or element (every element drawn independently; BSR then stores mostly fill).
+export SPMM_PATTERN=block
+# Block size of the BSR file (rows x cols); must tile A.
+export SPMM_BLOCK=4x4
+# hot or cold; rotating is not supported for SpMM.
+export MATMUL_CACHE=hot
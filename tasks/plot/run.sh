@@ -1,2 +1,24 @@
 #!/usr/bin/env bash
-python3 "$ASSETS/plots/runtimes.py" "$TASKS/experiment"
+# Aggregate the run records of all experiments once, into results.jsonl (and results.csv);
+# the plots and the regression check read that file instead of the experiment folders.
+python3 "$ASSETS/plots/runtimes.py" "$TASKS/experiment" --mode aggregate -o results.jsonl || return
+status=0
+if [[ -n "${REGRESSION_HISTORY:-}" ]]; then
+    python3 "$ASSETS/plots/runtimes.py" results.jsonl --mode regression \
+        --history "$REGRESSION_HISTORY" --threshold "$REGRESSION_THRESHOLD" -o regression.tsv || status=$?
+fi
+python3 "$ASSETS/plots/runtimes.py" results.jsonl
+python3 "$ASSETS/plots/runtimes.py" results.jsonl --mode roofline --peaks "$TASKS/calibrate" -o roofline.pdf
+# Scaling curves, for input-size sweeps (tasks/experiment/MatMul/generate_sweep.sh) and
+# thread counts: the runs of the scaling task (tasks/scaling/MatMul) if it ran, else
+# experiment runs with a <device>-t<N> folder prefix.
+if compgen -G "$TASKS/experiment/*/*_[0-9]*/" > /dev/null; then
+    python3 "$ASSETS/plots/runtimes.py" results.jsonl --mode sizes --peaks "$TASKS/calibrate" -o sizes.pdf
+fi
+scaling="$TASKS/scaling/MatMul/$BUILD_FOLDER"
+if compgen -G "$scaling/*/*/*/*-t[0-9]*-run*/" > /dev/null; then
+    python3 "$ASSETS/plots/runtimes.py" "$scaling" --mode threads -o threads.pdf
+elif compgen -G "$TASKS/experiment/*/*/*/*-t[0-9]*-run*/" > /dev/null; then
+    python3 "$ASSETS/plots/runtimes.py" results.jsonl --mode threads -o threads.pdf
+fi
+return "$status"
@@ -1,4 +1,6 @@
 export DEPENDENCIES+=(
     "tasks/build/containers/plot:$BUILD_FOLDER"
     "tasks/experiment/*/*/!(data):*-run*"
+    "tasks/calibrate:*"
+    "tasks/scaling/*:$BUILD_FOLDER"
 )
\ No newline at end of file
@@ -1,3 +1,8 @@
 export CONTAINER=$TASKS/build/containers/plot/$BUILD_FOLDER/plot.sif
 export CONTAINER_DEF=$CONTAINERS/plot.def
-export RUN_SPEC=assets
\ No newline at end of file
+export RUN_SPEC=assets
+# Earlier results to check the experiments against (runtimes.py --mode regression), e.g. a
+# copy of the results.jsonl every plot run aggregates the run records into: the plot task
+# fails if a run got significantly slower, by more than REGRESSION_THRESHOLD. Empty: no check.
+export REGRESSION_HISTORY=
+export REGRESSION_THRESHOLD=0.05
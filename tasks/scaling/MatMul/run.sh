@@ -0,0 +1,31 @@
+#!/usr/bin/env bash
+# Every MatMul experiment whose competitor is in SCALING_COMPETITORS at each thread count
+# in SCALING_THREADS, SCALING_RUNS times (run by run, so slow drift spreads over all thread
+# counts), with the experiment's own settings. The runs land in
+# MatMul/<input_size>/<experiment>/<BUILD_FOLDER>-t<threads>-run<N>/ of the run folder,
+# which `runtimes.py --mode threads` plots over the thread count.
+status=0
+for experiment in "$TASKS"/experiment/MatMul/*/*/; do
+    experiment="${experiment%/}"
+    [[ "${experiment##*/}" != data && -f "$experiment/run.sh" ]] || continue
+    (
+        set -euo pipefail
+        source "$TASKS/experiment/MatMul/task_meta.sh"
+        source "$(dirname "$experiment")/task_meta.sh"
+        source "$experiment/task_meta.sh"
+        [[ " $SCALING_COMPETITORS " == *" ${COMPETITOR:-} "* ]] || exit 0
+        source "$TASKS/experiment/MatMul/run_env.sh"
+        for run in $(seq 1 "$SCALING_RUNS"); do
+            for threads in $SCALING_THREADS; do
+                run_dir="MatMul/$INPUT_SIZE/${experiment##*/}/$BUILD_FOLDER-t$threads-run$run"
+                mkdir -p "$run_dir"
+                (
+                    cd "$run_dir"
+                    export MATMUL_THREADS="$threads" RUN_ID="${run_dir##*/}"
+                    source "$experiment/run.sh"
+                )
+            done
+        done
+    ) || status=$?
+done
+return "$status"
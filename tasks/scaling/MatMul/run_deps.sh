@@ -0,0 +1,7 @@
+export DEPENDENCIES+=(
+    tasks/build/containers/gcc:$BUILD_FOLDER
+    "tasks/experiment/MatMul/*/data:$BUILD_FOLDER"
+)
+for competitor in $SCALING_COMPETITORS; do
+    DEPENDENCIES+=("tasks/build/$competitor:$BUILD_FOLDER")
+done
@@ -0,0 +1,10 @@
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
+export RUN_SPEC=$BUILD_FOLDER
+# A thread-count sweep of the multithreaded experiments, run explicitly (--run-disabled).
+export TASK_DISABLED=true
+# Every MatMul experiment of one of these competitors runs SCALING_RUNS times at each
+# thread count in SCALING_THREADS (MATMUL_THREADS), with the experiment's settings.
+export SCALING_COMPETITORS="parallel"
+export SCALING_THREADS="1 2 4 8 16"
+export SCALING_RUNS=5
@@ -0,0 +1,38 @@
+#!/usr/bin/env bash
+# The MatMul experiments in benchmark server mode: one process per competitor runs every
+# input size SERVE_RUNS times (matmul --serve), reading the next case's inputs while the
+# current one computes. The runs land in MatMul/<input_size>/<competitor>/$BUILD_FOLDER-run<N>
+# like tasks/experiment's, so assets/plots/runtimes.py plots this folder the same way.
+export OMP_NUM_THREADS="${OMP_NUM_THREADS:-${SLURM_CPUS_PER_TASK:-$(nproc)}}"
+
+status=0
+for competitor in $SERVE_COMPETITORS; do
+    manifest="$competitor.manifest"
+    : > "$manifest" || return
+    for run in $(seq 1 "$SERVE_RUNS"); do
+        for meta in "$TASKS"/experiment/MatMul/*/task_meta.sh; do
+            is_dir="$(dirname "$meta")"
+            [[ -f "$is_dir/$competitor/run.sh" ]] || continue
+            # The case runs with the experiment's settings: the MATMUL_* variables (and B
+            # layout) of its routine, input size, and competitor task_meta.sh.
+            read -r is B_layout settings < <(
+                source "$TASKS/experiment/MatMul/task_meta.sh"; source "$meta"
+                source "$is_dir/$competitor/task_meta.sh"
+                echo "$INPUT_SIZE ${B_LAYOUT:-rowmajor}" $(compgen -e MATMUL_ | grep -vxE 'MATMUL_(BIAS|PREFETCH)' |
+                                                           while read -r var; do echo "$var=${!var}"; done))
+            data_dir="$is_dir/data/$BUILD_FOLDER"
+            ext=txt
+            [[ -f "$data_dir/input_A.bin" ]] && ext=bin
+            B_file="input_B.$ext"
+            [[ "$B_layout" != rowmajor ]] && B_file="input_B.$B_layout.$ext"
+            gold=-
+            [[ -f "$data_dir/output_C.$ext" ]] && gold="$data_dir/output_C.$ext"
+            [[ -f "$data_dir/input_bias.$ext" ]] && settings+=" MATMUL_BIAS=$data_dir/input_bias.$ext"
+            echo "MatMul/$is/$competitor/$BUILD_FOLDER-run$run $data_dir/input_A.$ext $data_dir/$B_file" \
+                "$data_dir/input_C.$ext $gold $settings" >> "$manifest"
+        done
+    done
+    [[ -s "$manifest" ]] || continue
+    "$TASKS/build/$competitor/$BUILD_FOLDER/matmul" --serve "$manifest" || status=$?
+done
+return "$status"
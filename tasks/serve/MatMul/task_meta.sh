@@ -0,0 +1,11 @@
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
+export RUN_SPEC=$BUILD_FOLDER
+# A second measurement of the experiments, run explicitly (--run-disabled).
+export TASK_DISABLED=true
+# Competitors the benchmark server runs (one process each) on every MatMul input size
+# they have an experiment for, SERVE_RUNS times per size.
+export SERVE_COMPETITORS="baseline optimized gemm parallel"
+export SERVE_RUNS=10
+# on: read the next case's inputs while the current one runs; off: after it.
+export MATMUL_PREFETCH=on
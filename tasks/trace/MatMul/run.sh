@@ -0,0 +1,23 @@
+#!/usr/bin/env bash
+# One run of every MatMul experiment whose competitor is in TRACE_COMPETITORS, with the
+# competitor's traced build (tasks/build/trace) and the experiment's own settings. The run
+# outputs, with the Chrome trace trace.json (open it in ui.perfetto.dev), land in
+# MatMul/<input_size>/<experiment>/ of the run folder.
+status=0
+for experiment in "$TASKS"/experiment/MatMul/*/*/; do
+    experiment="${experiment%/}"
+    [[ "${experiment##*/}" != data && -f "$experiment/run.sh" ]] || continue
+    (
+        set -euo pipefail
+        source "$TASKS/experiment/MatMul/task_meta.sh"
+        source "$(dirname "$experiment")/task_meta.sh"
+        source "$experiment/task_meta.sh"
+        [[ " $TRACE_COMPETITORS " == *" ${COMPETITOR:-} "* ]] || exit 0
+        source "$TASKS/experiment/MatMul/run_env.sh"
+        mkdir -p "MatMul/$INPUT_SIZE/${experiment##*/}"
+        cd "MatMul/$INPUT_SIZE/${experiment##*/}"
+        export EXPERIMENT_BINARY="$TASKS/build/trace/$BUILD_FOLDER/$COMPETITOR/matmul"
+        source "$experiment/run.sh"
+    ) || status=$?
+done
+return "$status"
@@ -0,0 +1,9 @@
+export DEPENDENCIES+=(
+    tasks/build/containers/gcc:$BUILD_FOLDER
+    tasks/build/trace:$BUILD_FOLDER
+    "tasks/experiment/MatMul/*/data:$BUILD_FOLDER"
+)
+# Experiments may query the competitor's own build (e.g. gemm_prepacked for its B layout).
+for competitor in $TRACE_COMPETITORS; do
+    DEPENDENCIES+=("tasks/build/$competitor:$BUILD_FOLDER")
+done
@@ -0,0 +1,8 @@
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
+export RUN_SPEC=$BUILD_FOLDER
+# Traces for finding where the time of a run goes, run explicitly (--run-disabled).
+export TASK_DISABLED=true
+# Competitors with a traced build (tasks/build/trace); every MatMul experiment of one of
+# them is traced once, with the experiment's settings.
+export TRACE_COMPETITORS="optimized parallel gemm"
@@ -0,0 +1,64 @@
+#!/usr/bin/env bash
+# Grid search over TILE_I/J/K of the optimized kernel on every MatMul input size.
+# Writes results.tsv (all candidates) and tiles.sh (winners), which tasks/build/optimized
+# picks up for the same BUILD_FOLDER.
+
+src="$ASSETS/experiments/optimized/matmul.cpp"
+echo -e "input_size\tI\tJ\tK\ttile_i\ttile_j\ttile_k\tmedian_ns" > results.tsv
+mkdir -p candidates scratch || return
+
+for ti in $TUNE_TILE_I; do
+    for tj in $TUNE_TILE_J; do
+        for tk in $TUNE_TILE_K; do
+            bin="candidates/matmul_${ti}x${tj}x${tk}"
+            g++ "$src" -I"$ASSETS/data" -I"$ASSETS/harness" -O3 -DTILE_I="$ti" -DTILE_J="$tj" -DTILE_K="$tk" \
+                -DWARMUP_RUNS=1 -DEVAL_RUNS="$TUNE_EVAL_RUNS" -o "$bin" || return
+            for meta in "$TASKS"/experiment/MatMul/*/task_meta.sh; do
+                # With the input size's epilogue (and bias), which its gold output includes.
+                read -r is i j k epilogue < <(source "$TASKS/experiment/MatMul/task_meta.sh"; source "$meta"
+                                              echo "$INPUT_SIZE $I $J $K $MATMUL_EPILOGUE")
+                data_dir="$(dirname "$meta")/data/$BUILD_FOLDER"
+                ext=txt
+                [[ -f "$data_dir/input_A.bin" ]] && ext=bin
+                settings=(MATMUL_EPILOGUE="$epilogue")
+                [[ -f "$data_dir/input_bias.$ext" ]] && settings+=(MATMUL_BIAS="$data_dir/input_bias.$ext")
+                if ! (cd scratch && env "${settings[@]}" "../$bin" "$data_dir/input_A.$ext" "$data_dir/input_B.$ext" \
+                        "$data_dir/input_C.$ext" "$data_dir/output_C.$ext" > /dev/null); then
+                    echo "Skipping ${ti}x${tj}x${tk} on $is: result mismatch" >&2
+                    continue
+                fi
+                median=$(sort -n scratch/runtimes | awk '{ v[NR] = $1 } END { print v[int((NR + 1) / 2)] }')
+                echo -e "$is\t$i\t$j\t$k\t$ti\t$tj\t$tk\t$median" >> results.tsv
+            done
+        done
+    done
+done
+rm -rf candidates scratch
+
+# Per shape: the fastest candidate. Default TILE_I/J/K: the candidate with the lowest
+# geometric-mean slowdown relative to the per-shape best (over shapes it passed on).
+awk -F'\t' '
+NR == 1 { next }
+{
+    shape = $2 "x" $3 "x" $4; tiles = $5 "x" $6 "x" $7
+    t[shape, tiles] = $8; shapes[shape] = 1; cands[tiles] = 1
+    if (!(shape in best) || $8 < best[shape]) { best[shape] = $8; win[shape] = tiles }
+}
+END {
+    nshapes = 0; for (s in shapes) nshapes++
+    for (c in cands) {
+        n = 0; score = 0
+        for (s in shapes) if ((s, c) in t) { score += log(t[s, c] / best[s]); n++ }
+        if (n == nshapes && (def == "" || score < def_score)) { def = c; def_score = score }
+    }
+    print "# Generated by tasks/tune/MatMul; entries are IxJxK:TILE_IxTILE_JxTILE_K."
+    if (def != "") {
+        split(def, d, "x")
+        print "export TILE_I=" d[1]
+        print "export TILE_J=" d[2]
+        print "export TILE_K=" d[3]
+    }
+    line = ""; for (s in win) line = line (line == "" ? "" : " ") s ":" win[s]
+    print "export TUNED_TILES=\"" line "\""
+}' results.tsv > tiles.sh || return
+cat tiles.sh
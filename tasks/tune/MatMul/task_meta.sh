@@ -0,0 +1,10 @@
+export CONTAINER=$TASKS/build/containers/gcc/$BUILD_FOLDER/gcc.sif
+export CONTAINER_DEF=$CONTAINERS/gcc.def
+export RUN_SPEC=$BUILD_FOLDER
+# Tuning builds and runs the whole search space; run it explicitly (--run-disabled).
+export TASK_DISABLED=true
+# Search space of the grid search over the optimized kernel's tile sizes.
+export TUNE_TILE_I="8 16 32 64"
+export TUNE_TILE_J="32 64 128 256"
+export TUNE_TILE_K="32 64 128 256"
+export TUNE_EVAL_RUNS=3
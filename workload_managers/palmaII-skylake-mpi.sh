@@ -0,0 +1,47 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+MANIFEST="$1"
+LOG_DIR="$2"
+STAGE="${3:?Error: Stage number required.}"
+[[ -z "$MANIFEST" ]] && { echo "Error: Manifest path required." >&2; exit 1; }
+[[ -z "$LOG_DIR" ]] && { echo "Error: Log directory required." >&2; exit 1; }
+RUNNER="$REPOSITORY_ROOT/run_tasks.sh"
+OUTPUT_DIR="$LOG_DIR"
+
+# Multi-node jobs for the MPI competitors: MPI_NODES nodes (default 4) with
+# MPI_TASKS_PER_NODE ranks each (default 1, one rank per node using all its cores).
+# Each job gets more ranks per node if one of its tasks starts more than that (MPI_RANKS,
+# e.g. 8 for summa_2.5d); mpi_launch (tasks/experiment/MatMul/run_env.sh) splits the
+# allocated CPUs over the MPI_RANKS ranks of a task.
+SBATCH_PARTITION="express,normal,long"
+SBATCH_NODES="${MPI_NODES:-4}"
+SBATCH_NTASKS_PER_NODE="${MPI_TASKS_PER_NODE:-1}"
+SBATCH_CPUS_PER_TASK="$((36 / SBATCH_NTASKS_PER_NODE))"
+SBATCH_MEM="90gb"
+SBATCH_TIME="${WALLTIME:-2:00:00}"
+
+TASKS="$REPOSITORY_ROOT/tasks"
+CONTAINERS="$REPOSITORY_ROOT/containers"
+ASSETS="$REPOSITORY_ROOT/assets"
+WORKLOAD_MANAGERS="$REPOSITORY_ROOT/workload_managers"
+source "$REPOSITORY_ROOT/.template/scripts/env.sh"
+
+# Ranks per node for the largest MPI_RANKS of the job's tasks (from their task_meta.sh chain
+# and KEY=VALUE overrides), so that srun can place every rank in the allocation.
+sbatch_job_resources() {
+  local ranks=$((SBATCH_NODES * SBATCH_NTASKS_PER_NODE)) task_ranks
+  local -a fields
+  while IFS=$'\t' read -ra fields; do
+    [[ ${#fields[@]} -ge 3 ]] || continue
+    ENV_OVERRIDES=("${fields[@]:3}")
+    task_ranks=$(resolve_task_var "$REPOSITORY_ROOT/${fields[2]}" MPI_RANKS)
+    if [[ "$task_ranks" =~ ^[0-9]+$ ]] && (( task_ranks > ranks )); then ranks=$task_ranks; fi
+  done <<< "$1"
+  local per_node=$(( (ranks + SBATCH_NODES - 1) / SBATCH_NODES ))
+  local cpus=$(( 36 / per_node ))
+  echo "$SBATCH_NODES $per_node $(( cpus > 0 ? cpus : 1 ))"
+}
+
+source "$(dirname "$0")/slurm_common.sh"
+parse_and_submit_stage "$MANIFEST" "$LOG_DIR" "$STAGE"
@@ -5,6 +5,9 @@
 
 # Parse manifest for our JOBs in the given stage, resolve DEPENDS from wm_job_ids, submit, append to wm_job_ids.
 # Uses: RUNNER, OUTPUT_DIR (use LOG_DIR), SBATCH_* variables. JOB_NAME and SBATCH_TIME come from script.
+# If the script defines sbatch_job_resources, it is called with a job's task lines and prints
+# "nodes ntasks_per_node cpus_per_task" for that job instead of SBATCH_NODES,
+# SBATCH_NTASKS_PER_NODE, and SBATCH_CPUS_PER_TASK.
 parse_and_submit_stage() {
   local manifest="$1"
   local log_dir="$2"
@@ -23,6 +26,7 @@ parse_and_submit_stage() {
   declare -A job_depends=()
   declare -A job_task_count=()
   declare -A job_job_name=()
+  declare -A job_tasks=()
   local current_job="" current_stage="" current_wm="" in_header=true
   declare -A job_id_seen=()
 
@@ -31,7 +35,7 @@ parse_and_submit_stage() {
       [[ "$line" == "---" ]] && in_header=false
       continue
     fi
-    if [[ "$line" == JOB* ]]; then
+    if [[ "$line" == $'JOB\t'* ]]; then
       current_job=$(echo "$line" | cut -f2)
       current_stage=""
       current_wm=""
@@ -57,6 +61,7 @@ parse_and_submit_stage() {
     if [[ "$line" =~ ^[0-9]+[[:space:]] ]]; then
       if [[ "$current_stage" == "$stage" ]] && [[ "$current_wm" == "$our_wm_abs" ]]; then
         job_task_count["$current_job"]=$((${job_task_count["$current_job"]:-0} + 1))
+        job_tasks["$current_job"]+="$line"$'\n'
         if [[ -z "${job_id_seen[$current_job]:-}" ]]; then
           job_id_seen["$current_job"]=1
           job_ids+=("$current_job")
@@ -96,6 +101,15 @@ parse_and_submit_stage() {
     local gres_line=""
     [[ -n "${SBATCH_GRES:-}" ]] && gres_line="#SBATCH --gres=${SBATCH_GRES}"
 
+    # Multi-node jobs (MPI): nodes and tasks per node; SBATCH_CPUS_PER_TASK is then per rank.
+    local job_nodes="${SBATCH_NODES:-}" job_ntasks="${SBATCH_NTASKS_PER_NODE:-}" job_cpus="${SBATCH_CPUS_PER_TASK}"
+    if declare -F sbatch_job_resources > /dev/null; then
+      read -r job_nodes job_ntasks job_cpus < <(sbatch_job_resources "${job_tasks[$jid]}")
+    fi
+    local nodes_line="" ntasks_line=""
+    [[ -n "$job_nodes" ]] && nodes_line="#SBATCH --nodes=${job_nodes}"
+    [[ -n "$job_ntasks" ]] && ntasks_line="#SBATCH --ntasks-per-node=${job_ntasks}"
+
     job_name_val="${job_job_name[$jid]:-run_tasks}"
 
     local tmp
@@ -105,7 +119,9 @@ parse_and_submit_stage() {
       echo "#SBATCH --array=0-${array_max}"
       echo "#SBATCH --partition=${SBATCH_PARTITION}"
       [[ -n "$gres_line" ]] && echo "$gres_line"
-      echo "#SBATCH --cpus-per-task=${SBATCH_CPUS_PER_TASK}"
+      [[ -n "$nodes_line" ]] && echo "$nodes_line"
+      [[ -n "$ntasks_line" ]] && echo "$ntasks_line"
+      echo "#SBATCH --cpus-per-task=${job_cpus}"
       echo "#SBATCH --mem=${SBATCH_MEM}"
       echo "#SBATCH --time=${SBATCH_TIME:-2:00:00}"
       echo "#SBATCH --job-name=${job_name_val}_${jid}"